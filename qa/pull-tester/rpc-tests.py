@@ -77,6 +77,7 @@ BASE_SCRIPTS= [
     # vv Tests less than 30s vv
     'wallet_1941.py',
     'wallet_accounts.py',
+    'wallet_asyncrescan.py',
     'wallet_addresses.py',
     'wallet_anchorfork.py',
     'wallet_changeindicator.py',
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+# Copyright (c) 2025 The Juno Cash developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#
+# Test background rescans after key imports (-asyncrescan): progress
+# reporting through getrescaninfo, merging of overlapping requests, and
+# resuming a rescan interrupted by a restart.
+#
+
+from decimal import Decimal
+import time
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_true,
+    connect_nodes_bi,
+    start_node,
+    start_nodes,
+    stop_node,
+)
+
+BASE_ARGS = ['-allowdeprecated=getnewaddress']
+# Slow the rescan down so that it can be observed while it runs.
+RESCAN_ARGS = BASE_ARGS + ['-asyncrescan=1', '-rescanchunkdelay=1000']
+
+
+class WalletAsyncRescanTest(BitcoinTestFramework):
+
+    def __init__(self):
+        super().__init__()
+        self.num_nodes = 2
+
+    def setup_network(self, split=False):
+        self.nodes = start_nodes(self.num_nodes, self.options.tmpdir,
+            extra_args=[BASE_ARGS, RESCAN_ARGS])
+        connect_nodes_bi(self.nodes, 0, 1)
+        self.is_network_split = False
+        self.sync_all()
+
+    def wait_for_rescan(self, node, condition, timeout=120):
+        deadline = time.time() + timeout
+        while True:
+            info = node.getrescaninfo()
+            if condition(info):
+                return info
+            assert_true(time.time() < deadline, "Timed out waiting for the rescan: %r" % info)
+            time.sleep(0.1)
+
+    def assert_received(self, node, addr, amount):
+        utxos = node.listunspent(1, 10**9, [addr])
+        assert_equal([amount], [utxo['amount'] for utxo in utxos])
+
+    def run_test(self):
+        # Enough blocks for the rescan to take several chunks.
+        self.nodes[0].generate(300)
+        addr1 = self.nodes[0].getnewaddress()
+        addr2 = self.nodes[0].getnewaddress()
+        self.nodes[0].sendtoaddress(addr1, Decimal('1.5'))
+        self.nodes[0].sendtoaddress(addr2, Decimal('2.5'))
+        self.nodes[0].generate(1)
+        self.sync_all()
+        tip = self.nodes[1].getblockcount()
+        key1 = self.nodes[0].dumpprivkey(addr1)
+        key2 = self.nodes[0].dumpprivkey(addr2)
+
+        assert_equal(False, self.nodes[1].getrescaninfo()['rescanning'])
+
+        # The import returns before the rescan has found anything.
+        assert_equal(addr1, self.nodes[1].importprivkey(key1, '', True))
+        info = self.nodes[1].getrescaninfo()
+        assert_equal(True, info['rescanning'])
+        assert_equal(0, info['startheight'])
+        assert_equal(tip, info['tipheight'])
+        assert_equal([], self.nodes[1].listunspent(1, 10**9, [addr1]))
+
+        # Progress is reported while the rescan runs.
+        info = self.wait_for_rescan(self.nodes[1], lambda i: i['height'] > 0)
+        assert_equal(True, info['rescanning'])
+        assert_true(0 <= info['progress'] < 1, "Unexpected progress: %r" % info)
+        height = info['height']
+
+        # A second import that needs a rescan from the same height joins the
+        # running pass instead of starting over.
+        assert_equal(addr2, self.nodes[1].importprivkey(key2, '', True))
+        info = self.nodes[1].getrescaninfo()
+        assert_equal(True, info['rescanning'])
+        assert_equal(0, info['startheight'])
+        assert_true(info['height'] >= height, "The rescan restarted: %r" % info)
+        height = info['height']
+
+        # Interrupt the rescan. After a restart it carries on from where it
+        # stopped.
+        stop_node(self.nodes[1], 1)
+        self.nodes[1] = start_node(1, self.options.tmpdir, RESCAN_ARGS)
+        info = self.nodes[1].getrescaninfo()
+        assert_equal(True, info['rescanning'])
+        assert_true(info['startheight'] >= height, "The rescan did not resume: %r" % info)
+        assert_true(info['startheight'] > 0, "The rescan did not resume: %r" % info)
+
+        # Once it has finished, both imports have found their funds.
+        self.wait_for_rescan(self.nodes[1], lambda i: not i['rescanning'])
+        assert_equal(False, 'error' in self.nodes[1].getrescaninfo())
+        self.assert_received(self.nodes[1], addr1, Decimal('1.5'))
+        self.assert_received(self.nodes[1], addr2, Decimal('2.5'))
+
+
+if __name__ == '__main__':
+    WalletAsyncRescanTest().main()
@@ -0,0 +1,357 @@
+#!/usr/bin/env python3
+# Copyright (c) 2025 The Juno Cash developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#
+# Synthetic Orchard-heavy regtest workload generator and replay harness.
+#
+# The `generate` command builds a regtest chain in which every block carries
+# (at least) a configurable number of Orchard actions, spread across a set of
+# wallet accounts, plus transparent coinbase fan-in shielding transactions.
+# The resulting datadir is saved as a reusable fixture together with a
+# manifest describing how it was built.
+#
+# The `replay` command starts a fresh node and measures:
+# - block connection throughput (blocks/s, txs/s) by submitting the fixture
+#   blocks via `submitblock`;
+# - mempool admission throughput by re-submitting the transactions of the
+#   last few fixture blocks via `sendrawtransaction`, one block at a time.
+#   Each block is connected once its transactions have been submitted, so
+#   that the next block's transactions find their inputs and anchors;
+# - `getblocktemplate` latency with the transactions of the last block in
+#   the mempool;
+# - wallet rescan speed, by restarting the node with the fixture wallet and
+#   `-rescan`.
+#
+# To use:
+#   ./qa/zcash/orchard_workload.py generate --blocks=200 --actions=20 \
+#       --wallets=4 --fanin=3 --out=orchard-workload
+#   ./qa/zcash/orchard_workload.py replay --fixture=orchard-workload \
+#       --json=results.json
+#
+# The shape of the workload (which account pays which, how many outputs each
+# transaction has) is derived from --seed, so two runs with the same
+# parameters produce equivalent chains.  Keys, proofs and txids are still
+# generated by the node and therefore differ between runs; always replay a
+# saved fixture when comparing two builds.
+#
+
+import argparse
+import json
+import os
+import random
+import shutil
+import sys
+import tempfile
+import time
+
+from decimal import Decimal
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.realpath(__file__)), '..', 'rpc-tests'))
+
+from test_framework.util import (
+    PortSeed,
+    get_coinbase_address,
+    initialize_chain_clean,
+    start_node,
+    stop_node,
+    wait_and_assert_operationid_status,
+)
+from test_framework.zip317 import conventional_fee
+
+MANIFEST = 'manifest.json'
+FIXTURE_NODE = 'node0'
+
+# Coinbase outputs must mature before they can be shielded.
+MATURITY_BLOCKS = 101
+
+NODE_ARGS = [
+    '-allowdeprecated=getnewaddress',
+    '-debug=0',
+    '-txindex',
+]
+
+
+def timed(f, *args):
+    start = time.perf_counter()
+    result = f(*args)
+    return (result, time.perf_counter() - start)
+
+
+def orchard_actions(node, txid):
+    tx = node.getrawtransaction(txid, 1)
+    return len(tx.get('orchard', {}).get('actions', []))
+
+
+class WorkloadGenerator:
+    def __init__(self, options):
+        self.options = options
+        self.rng = random.Random(options.seed)
+        self.accounts = []
+        self.stats = {
+            'blocks': 0,
+            'txs': 0,
+            'orchard_actions': 0,
+            'shielding_txs': 0,
+            'transparent_inputs': 0,
+        }
+
+    def spendable(self, node, ua):
+        return node.z_getbalanceforaccount(ua['account'], 1).get('pools', {}) \
+            .get('orchard', {}).get('valueZat', 0)
+
+    def shield_coinbase(self, node):
+        # Transparent fan-in: sweep several mature coinbase outputs into a
+        # single Orchard note for a randomly chosen account.
+        target = self.rng.choice(self.accounts)
+        result = node.z_shieldcoinbase(
+            self.coinbase_taddr, target['address'], None, self.options.fanin)
+        if result['shieldingUTXOs'] == 0:
+            return []
+        txid = wait_and_assert_operationid_status(node, result['opid'])
+        self.stats['shielding_txs'] += 1
+        self.stats['transparent_inputs'] += result['shieldingUTXOs']
+        return [txid]
+
+    def orchard_transfer(self, node):
+        # Orchard fan-out: one account pays between one and --fanout other
+        # accounts from its confirmed notes.
+        funded = [a for a in self.accounts if self.spendable(node, a) > 0]
+        if not funded:
+            return []
+        sender = self.rng.choice(funded)
+        others = [a for a in self.accounts if a is not sender] or [sender]
+        n_outputs = self.rng.randint(1, self.options.fanout)
+        fee = conventional_fee(n_outputs + 2)
+        budget = Decimal(self.spendable(node, sender)) / Decimal(100000000) - fee
+        if budget <= Decimal('0.0001') * n_outputs:
+            return []
+        amount = (budget / (2 * n_outputs)).quantize(Decimal('0.00000001'))
+        recipients = [
+            {'address': self.rng.choice(others)['address'], 'amount': amount}
+            for _ in range(n_outputs)
+        ]
+        opid = node.z_sendmany(sender['address'], recipients, 1, fee, 'FullPrivacy')
+        return [wait_and_assert_operationid_status(node, opid)]
+
+    def build_block(self, node):
+        txids = []
+        actions = 0
+        if self.options.fanin > 0:
+            for txid in self.shield_coinbase(node):
+                txids.append(txid)
+                actions += orchard_actions(node, txid)
+        attempts = 0
+        while actions < self.options.actions and attempts < 4 * self.options.actions:
+            attempts += 1
+            new_txids = self.orchard_transfer(node)
+            if not new_txids:
+                break
+            for txid in new_txids:
+                txids.append(txid)
+                actions += orchard_actions(node, txid)
+        node.generate(1)
+        self.stats['blocks'] += 1
+        self.stats['txs'] += len(txids)
+        self.stats['orchard_actions'] += actions
+        return actions
+
+    def run(self):
+        out = os.path.abspath(self.options.out)
+        if os.path.exists(out):
+            raise Exception('Output directory %s already exists' % out)
+
+        tmpdir = tempfile.mkdtemp(prefix='orchard-workload')
+        initialize_chain_clean(tmpdir, 1)
+        node = start_node(0, tmpdir, NODE_ARGS)
+        try:
+            for _ in range(self.options.wallets):
+                account = node.z_getnewaccount()['account']
+                address = node.z_getaddressforaccount(account, ['orchard'])['address']
+                self.accounts.append({'account': account, 'address': address})
+
+            node.generate(MATURITY_BLOCKS)
+            self.coinbase_taddr = get_coinbase_address(node)
+
+            # Seed every account with shielded funds before measuring.
+            for _ in range(len(self.accounts)):
+                self.shield_coinbase(node)
+                node.generate(1)
+            start_height = node.getblockcount()
+
+            for i in range(self.options.blocks):
+                actions = self.build_block(node)
+                if (i + 1) % 10 == 0 or i + 1 == self.options.blocks:
+                    print('Block %d/%d: %d Orchard actions' % (i + 1, self.options.blocks, actions))
+
+            manifest = {
+                'parameters': vars(self.options),
+                'start_height': start_height,
+                'tip_height': node.getblockcount(),
+                'tip_hash': node.getbestblockhash(),
+                'accounts': self.accounts,
+                'stats': self.stats,
+            }
+        finally:
+            stop_node(node, 0)
+
+        shutil.copytree(os.path.join(tmpdir, FIXTURE_NODE), os.path.join(out, FIXTURE_NODE))
+        with open(os.path.join(out, MANIFEST), 'w', encoding='utf8') as f:
+            json.dump(manifest, f, indent=2, default=str)
+        shutil.rmtree(tmpdir)
+        print('Saved workload fixture to %s' % out)
+        print(json.dumps(self.stats, indent=2))
+
+
+class WorkloadReplay:
+    def __init__(self, options):
+        self.options = options
+        self.fixture = os.path.abspath(options.fixture)
+        with open(os.path.join(self.fixture, MANIFEST), encoding='utf8') as f:
+            self.manifest = json.load(f)
+
+    def fixture_datadir(self, tmpdir):
+        # Work on a copy so the fixture itself is never modified.
+        shutil.copytree(os.path.join(self.fixture, FIXTURE_NODE), os.path.join(tmpdir, 'node0'))
+
+    def run(self):
+        results = {'fixture': self.fixture, 'manifest_stats': self.manifest['stats']}
+        tmpdir = tempfile.mkdtemp(prefix='orchard-replay')
+        self.fixture_datadir(tmpdir)
+        initialize_chain_clean(tmpdir, 2)
+        # Rewrite the config files so that the fixture node uses this run's ports.
+        source = start_node(0, tmpdir, NODE_ARGS)
+        # Without a wallet, getblocktemplate needs an address to pay.
+        target = None
+        try:
+            miner_address = source.getnewaddress()
+            target = start_node(1, tmpdir, NODE_ARGS + [
+                '-disablewallet',
+                '-mineraddress=%s' % miner_address,
+            ])
+
+            tip = source.getblockcount()
+            mempool_blocks = min(self.options.mempool_blocks, tip)
+            connect_height = tip - mempool_blocks
+
+            # Block connection throughput.
+            blocks = [source.getblock(source.getblockhash(h), 0) for h in range(1, connect_height + 1)]
+            n_txs = sum(len(source.getblock(source.getblockhash(h))['tx']) for h in range(1, connect_height + 1))
+            start = time.perf_counter()
+            for block in blocks:
+                assert target.submitblock(block) is None
+            elapsed = time.perf_counter() - start
+            results['connect'] = {
+                'blocks': len(blocks),
+                'txs': n_txs,
+                'seconds': elapsed,
+                'blocks_per_second': len(blocks) / elapsed if elapsed else None,
+                'txs_per_second': n_txs / elapsed if elapsed else None,
+            }
+
+            # Mempool admission throughput. The transactions of a block can
+            # spend notes and use anchors from the blocks before it, so each
+            # block is connected before the next one's transactions are
+            # submitted, and only the last block's stay in the mempool.
+            submitted = 0
+            accepted = 0
+            elapsed = 0
+            for h in range(connect_height + 1, tip + 1):
+                block_hash = source.getblockhash(h)
+                raw_txs = [tx['hex'] for tx in source.getblock(block_hash, 2)['tx'][1:]]
+                submitted += len(raw_txs)
+                start = time.perf_counter()
+                for raw in raw_txs:
+                    try:
+                        target.sendrawtransaction(raw)
+                        accepted += 1
+                    except Exception as e:
+                        print('Transaction rejected: %s' % e)
+                elapsed += time.perf_counter() - start
+                if h < tip:
+                    assert target.submitblock(source.getblock(block_hash, 0)) is None
+            results['mempool'] = {
+                'submitted': submitted,
+                'accepted': accepted,
+                'seconds': elapsed,
+                'txs_per_second': accepted / elapsed if elapsed else None,
+            }
+
+            # Block template latency with the replayed mempool.
+            latencies = []
+            for _ in range(self.options.template_samples):
+                (_, t) = timed(target.getblocktemplate)
+                latencies.append(t)
+            latencies.sort()
+            results['template'] = {
+                'samples': len(latencies),
+                'min_seconds': latencies[0],
+                'median_seconds': latencies[len(latencies) // 2],
+                'max_seconds': latencies[-1],
+            }
+        finally:
+            if target is not None:
+                stop_node(target, 1)
+            stop_node(source, 0)
+
+        # Wallet rescan speed: restart the fixture node with -rescan and time
+        # until RPC is available again.
+        start = time.perf_counter()
+        source = start_node(0, tmpdir, NODE_ARGS + ['-rescan'])
+        elapsed = time.perf_counter() - start
+        try:
+            results['rescan'] = {
+                'blocks': source.getblockcount(),
+                'seconds': elapsed,
+                'blocks_per_second': source.getblockcount() / elapsed if elapsed else None,
+            }
+        finally:
+            stop_node(source, 0)
+
+        shutil.rmtree(tmpdir)
+        print(json.dumps(results, indent=2))
+        if self.options.json:
+            with open(self.options.json, 'w', encoding='utf8') as f:
+                json.dump(results, f, indent=2)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--srcdir', default=os.path.normpath(
+        os.path.join(os.path.dirname(os.path.realpath(__file__)), '..', '..', 'src')),
+        help='Source directory containing junocashd (overridden by $ZCASHD)')
+    parser.add_argument('--portseed', type=int, default=os.getpid(),
+        help='The seed to use for assigning port numbers')
+    subparsers = parser.add_subparsers(dest='command', required=True)
+
+    gen = subparsers.add_parser('generate', help='Build a workload fixture')
+    gen.add_argument('--blocks', type=int, default=100, help='Number of workload blocks')
+    gen.add_argument('--actions', type=int, default=20, help='Target Orchard actions per block')
+    gen.add_argument('--wallets', type=int, default=4, help='Number of wallet accounts')
+    gen.add_argument('--fanin', type=int, default=2,
+        help='Coinbase outputs swept per shielding transaction (0 disables shielding per block)')
+    gen.add_argument('--fanout', type=int, default=3, help='Maximum recipients per Orchard transfer')
+    gen.add_argument('--seed', type=int, default=1, help='Seed for the workload shape')
+    gen.add_argument('--out', required=True, help='Directory to save the fixture to')
+
+    replay = subparsers.add_parser('replay', help='Replay a workload fixture into a fresh node')
+    replay.add_argument('--fixture', required=True, help='Fixture directory created by `generate`')
+    replay.add_argument('--mempool-blocks', type=int, default=10,
+        help='Number of trailing fixture blocks whose transactions are replayed into the mempool')
+    replay.add_argument('--template-samples', type=int, default=10,
+        help='Number of getblocktemplate calls to time')
+    replay.add_argument('--json', help='Write results to this file')
+
+    options = parser.parse_args()
+    PortSeed.n = options.portseed
+    os.environ.setdefault('ZCASHD', os.path.join(options.srcdir, 'junocashd'))
+
+    if options.command == 'generate':
+        WorkloadGenerator(options).run()
+    else:
+        WorkloadReplay(options).run()
+
+
+if __name__ == '__main__':
+    main()
@@ -3,6 +3,7 @@
 // file COPYING or https://www.opensource.org/licenses/mit-license.php .
 
 #include "asyncrpcqueue.h"
+#include "threadbudget.h"
 #include "util/system.h"
 
 static std::atomic<size_t> workerCounter(0);
@@ -29,6 +30,7 @@ AsyncRPCQueue::~AsyncRPCQueue() {
 void AsyncRPCQueue::run(size_t workerId) {
     std::string s = strprintf("zc-asyncrpc-%s", workerId);
     RenameThread(s.c_str());
+    ThreadPoolMember member(ThreadPool::ASYNC_RPC);
 
     while (true) {
         AsyncRPCOperationId key;
@@ -7,9 +7,107 @@
 
 #include "perf.h"
 
+#include <univalue.h>
+
+#include <algorithm>
 #include <assert.h>
+#include <cmath>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Linear interpolation between closest ranks; `sorted` must be non-empty.
+double Percentile(const std::vector<double>& sorted, double p)
+{
+    double rank = p * (sorted.size() - 1);
+    size_t lo = static_cast<size_t>(std::floor(rank));
+    size_t hi = static_cast<size_t>(std::ceil(rank));
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - lo);
+}
+
+void PrintCsvHeader(std::ostream& os)
+{
+    os << "#Benchmark" << "," << "count" << "," << "min(ns)" << "," << "max(ns)" << "," << "average(ns)" << ","
+       << "min_cycles" << "," << "max_cycles" << "," << "average_cycles" << ","
+       << "median(ns)" << "," << "p90(ns)" << "," << "p99(ns)" << "," << "stddev(ns)" << "\n";
+}
+
+void PrintCsvRow(std::ostream& os, const benchmark::Result& r)
+{
+    os << std::fixed << std::setprecision(15) << r.name << "," << r.count << "," << r.minNs << "," << r.maxNs << "," << r.avgNs << ","
+       << r.minCycles << "," << r.maxCycles << "," << r.avgCycles << ","
+       << std::setprecision(0) << r.medianNs << "," << r.p90Ns << "," << r.p99Ns << "," << r.stddevNs << "\n";
+    os.copyfmt(std::ios(nullptr));
+}
+
+UniValue ResultToJSON(const benchmark::Result& r)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("name", r.name);
+    obj.pushKV("count", r.count);
+    obj.pushKV("samples", r.samples);
+    obj.pushKV("min_ns", r.minNs);
+    obj.pushKV("max_ns", r.maxNs);
+    obj.pushKV("average_ns", r.avgNs);
+    obj.pushKV("median_ns", r.medianNs);
+    obj.pushKV("p90_ns", r.p90Ns);
+    obj.pushKV("p99_ns", r.p99Ns);
+    obj.pushKV("stddev_ns", r.stddevNs);
+    obj.pushKV("min_cycles", r.minCycles);
+    obj.pushKV("max_cycles", r.maxCycles);
+    obj.pushKV("average_cycles", r.avgCycles);
+    return obj;
+}
+
+bool ReadBaseline(const std::string& path, std::map<std::string, benchmark::Result>& baseline)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: could not open baseline file " << path << "\n";
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+
+    UniValue json;
+    if (!json.read(contents.str()) || !json.isObject() || !json["benchmarks"].isArray()) {
+        std::cerr << "Error: " << path << " is not a benchmark JSON file\n";
+        return false;
+    }
+    for (const UniValue& entry : json["benchmarks"].getValues()) {
+        if (!entry.isObject() || !entry["name"].isStr()) {
+            std::cerr << "Error: " << path << " has a benchmark without a name\n";
+            return false;
+        }
+        for (const char* field : {"count", "samples", "average_ns", "stddev_ns"}) {
+            if (!entry[field].isNum()) {
+                std::cerr << "Error: benchmark " << entry["name"].get_str() << " in " << path
+                          << " has no numeric " << field << " field\n";
+                return false;
+            }
+        }
+        benchmark::Result r;
+        r.name = entry["name"].get_str();
+        try {
+            r.count = entry["count"].get_int64();
+            r.samples = entry["samples"].get_int64();
+            r.avgNs = entry["average_ns"].get_int64();
+            r.stddevNs = entry["stddev_ns"].get_real();
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Error: benchmark " << r.name << " in " << path << " has an invalid field: " << e.what() << "\n";
+            return false;
+        }
+        baseline[r.name] = r;
+    }
+    return true;
+}
+
+}
 
 benchmark::BenchRunner::BenchmarkMap &benchmark::BenchRunner::benchmarks() {
     static std::map<std::string, benchmark::BenchFunction> benchmarks_map;
@@ -21,25 +119,138 @@ benchmark::BenchRunner::BenchRunner(std::string name, benchmark::BenchFunction f
     benchmarks().insert(std::make_pair(name, func));
 }
 
-void
-benchmark::BenchRunner::RunAll(benchmark::duration elapsedTimeForOne)
+bool
+benchmark::BenchRunner::RunAll(const benchmark::Options& options)
 {
+    std::regex filter(options.filter);
+
+    if (options.listOnly) {
+        for (const auto &p: benchmarks()) {
+            if (std::regex_match(p.first, filter)) {
+                std::cout << p.first << "\n";
+            }
+        }
+        return true;
+    }
+
+    std::map<std::string, benchmark::Result> baseline;
+    if (!options.baseline.empty() && !ReadBaseline(options.baseline, baseline)) {
+        return false;
+    }
+
     perf_init();
     if (std::ratio_less_equal<benchmark::clock::period, std::micro>::value) {
         std::cerr << "WARNING: Clock precision is worse than microsecond - benchmarks may be less accurate!\n";
     }
-    std::cout << "#Benchmark" << "," << "count" << "," << "min(ns)" << "," << "max(ns)" << "," << "average(ns)" << ","
-              << "min_cycles" << "," << "max_cycles" << "," << "average_cycles" << "\n";
+    PrintCsvHeader(std::cout);
 
+    std::vector<benchmark::Result> results;
     for (const auto &p: benchmarks()) {
-        State state(p.first, elapsedTimeForOne);
+        if (!std::regex_match(p.first, filter)) {
+            continue;
+        }
+        State state(p.first, options, results);
         p.second(state);
+        if (!results.empty() && results.back().name == p.first) {
+            PrintCsvRow(std::cout, results.back());
+        }
     }
     perf_fini();
+
+    if (!options.outputCsv.empty()) {
+        std::ofstream csv(options.outputCsv);
+        PrintCsvHeader(csv);
+        for (const auto& r : results) {
+            PrintCsvRow(csv, r);
+        }
+    }
+    if (!options.outputJson.empty()) {
+        UniValue benchmarks(UniValue::VARR);
+        for (const auto& r : results) {
+            benchmarks.push_back(ResultToJSON(r));
+        }
+        UniValue json(UniValue::VOBJ);
+        json.pushKV("benchmarks", benchmarks);
+        std::ofstream(options.outputJson) << json.write(4) << "\n";
+    }
+
+    bool ok = true;
+    if (!baseline.empty()) {
+        std::cout << "\n#Benchmark,baseline_average(ns),average(ns),change(%),status\n";
+        for (const auto& r : results) {
+            auto it = baseline.find(r.name);
+            if (it == baseline.end()) {
+                std::cout << r.name << ",,," << r.avgNs << ",new\n";
+                continue;
+            }
+            const auto& base = it->second;
+            double change = base.avgNs ? 100.0 * (r.avgNs - base.avgNs) / base.avgNs : 0;
+            bool regression = IsRegression(base, r, options.regressionThreshold);
+            ok &= !regression;
+            std::cout << std::fixed << std::setprecision(2) << r.name << "," << base.avgNs << "," << r.avgNs << ","
+                      << change << "," << (regression ? "REGRESSION" : "ok") << "\n";
+            std::cout.copyfmt(std::ios(nullptr));
+        }
+    }
+    return ok;
+}
+
+bool benchmark::IsRegression(const Result& baseline, const Result& current, double thresholdPercent)
+{
+    double diff = current.avgNs - baseline.avgNs;
+    if (diff <= baseline.avgNs * thresholdPercent / 100.0) {
+        return false;
+    }
+    // With fewer than two samples on either side there is no variance estimate,
+    // so the threshold alone decides.
+    if (baseline.samples < 2 || current.samples < 2) {
+        return true;
+    }
+    double se = std::sqrt(
+        baseline.stddevNs * baseline.stddevNs / baseline.samples +
+        current.stddevNs * current.stddevNs / current.samples);
+    return se == 0 || diff / se > 2.58;
+}
+
+void benchmark::State::Report(time_point now, uint64_t nowCycles)
+{
+    // Duration casts are only necessary here because hardware with sub-nanosecond clocks
+    // will lose precision.
+    Result r;
+    r.name = name;
+    r.count = count;
+    r.minNs = std::chrono::duration_cast<std::chrono::nanoseconds>(minTime).count();
+    r.maxNs = std::chrono::duration_cast<std::chrono::nanoseconds>(maxTime).count();
+    r.avgNs = std::chrono::duration_cast<std::chrono::nanoseconds>((now-beginTime)/count).count();
+    r.minCycles = minCycles;
+    r.maxCycles = maxCycles;
+    r.avgCycles = (nowCycles-beginCycles)/count;
+
+    r.samples = samples.size();
+    if (!samples.empty()) {
+        std::sort(samples.begin(), samples.end());
+        r.medianNs = Percentile(samples, 0.5);
+        r.p90Ns = Percentile(samples, 0.9);
+        r.p99Ns = Percentile(samples, 0.99);
+
+        double mean = 0;
+        for (double s : samples) mean += s;
+        mean /= samples.size();
+        double var = 0;
+        for (double s : samples) var += (s - mean) * (s - mean);
+        if (samples.size() > 1) {
+            r.stddevNs = std::sqrt(var / (samples.size() - 1));
+        }
+    }
+    results.push_back(r);
 }
 
 bool benchmark::State::KeepRunning()
 {
+    if (warmupRemaining > 0) {
+        --warmupRemaining;
+        return true;
+    }
     if (count & countMask) {
       ++count;
       return true;
@@ -57,6 +268,7 @@ bool benchmark::State::KeepRunning()
         auto elapsedOne = elapsed / (countMask + 1);
         if (elapsedOne < minTime) minTime = elapsedOne;
         if (elapsedOne > maxTime) maxTime = elapsedOne;
+        samples.push_back(std::chrono::duration<double, std::nano>(elapsedOne).count());
 
         // We only use relative values, so don't have to handle 64-bit wrap-around specially
         nowCycles = perf_cpucycles();
@@ -64,7 +276,7 @@ bool benchmark::State::KeepRunning()
         if (elapsedOneCycles < minCycles) minCycles = elapsedOneCycles;
         if (elapsedOneCycles > maxCycles) maxCycles = elapsedOneCycles;
 
-        if (elapsed*128 < maxElapsed) {
+        if (fixedIterations == 0 && elapsed*128 < maxElapsed) {
           // If the execution was much too fast (1/128th of maxElapsed), increase the count mask by 8x and restart timing.
           // The restart avoids including the overhead of this code in the measurement.
           countMask = ((countMask<<3)|7) & ((1LL<<60)-1);
@@ -73,9 +285,10 @@ bool benchmark::State::KeepRunning()
           maxTime = duration::zero();
           minCycles = std::numeric_limits<uint64_t>::max();
           maxCycles = std::numeric_limits<uint64_t>::min();
+          samples.clear();
           return true;
         }
-        if (elapsed*16 < maxElapsed) {
+        if (fixedIterations == 0 && elapsed*16 < maxElapsed) {
           uint64_t newCountMask = ((countMask<<1)|1) & ((1LL<<60)-1);
           if ((count & newCountMask)==0) {
               countMask = newCountMask;
@@ -86,22 +299,17 @@ bool benchmark::State::KeepRunning()
     lastCycles = nowCycles;
     ++count;
 
-    if (now - beginTime < maxElapsed) return true; // Keep going
+    if (fixedIterations != 0) {
+        if (count <= fixedIterations) return true; // Keep going
+    } else {
+        if (now - beginTime < maxElapsed) return true; // Keep going
+    }
 
     --count;
 
     assert(count != 0 && "count == 0 => (now == 0 && beginTime == 0) => return above");
 
-    // Output results
-    // Duration casts are only necessary here because hardware with sub-nanosecond clocks
-    // will lose precision.
-    int64_t min_elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(minTime).count();
-    int64_t max_elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(maxTime).count();
-    int64_t avg_elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>((now-beginTime)/count).count();
-    int64_t averageCycles = (nowCycles-beginCycles)/count;
-    std::cout << std::fixed << std::setprecision(15) << name << "," << count << "," << min_elapsed << "," << max_elapsed << "," << avg_elapsed << ","
-              << minCycles << "," << maxCycles << "," << averageCycles << "\n";
-    std::cout.copyfmt(std::ios(nullptr));
+    Report(now, nowCycles);
 
     return false;
 }
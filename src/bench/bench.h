@@ -11,6 +11,7 @@
 #include <map>
 #include <string>
 #include <chrono>
+#include <vector>
 
 #include <boost/preprocessor/cat.hpp>
 #include <boost/preprocessor/stringize.hpp>
@@ -36,7 +37,7 @@ static void CODE_TO_TIME(benchmark::State& state)
 BENCHMARK(CODE_TO_TIME);
 
  */
- 
+
 namespace benchmark {
     // In case high_resolution_clock is steady, prefer that, otherwise use steady_clock.
     struct best_clock {
@@ -48,9 +49,53 @@ namespace benchmark {
     using time_point = clock::time_point;
     using duration = clock::duration;
 
+    /** How the runner selects, runs and reports benchmarks. */
+    struct Options {
+        /** Only benchmarks whose name fully matches this regex are run. */
+        std::string filter = ".*";
+        /** Time budget per benchmark when iterations == 0. */
+        duration elapsedTimeForOne = std::chrono::seconds(1);
+        /**
+         * If non-zero, run exactly this many timed iterations (each one a
+         * separate sample) instead of adapting to the time budget.
+         */
+        uint64_t iterations = 0;
+        /** Number of untimed iterations run before measurement starts. */
+        uint64_t warmup = 0;
+        /** If set, print benchmark names and exit without running them. */
+        bool listOnly = false;
+        std::string outputCsv;
+        std::string outputJson;
+        /** JSON file written by a previous -output-json run to compare against. */
+        std::string baseline;
+        /** Minimum relative slowdown (in percent) reported as a regression. */
+        double regressionThreshold = 5.0;
+    };
+
+    /** Summary of one benchmark run; times are per iteration. */
+    struct Result {
+        std::string name;
+        uint64_t count = 0;
+        int64_t minNs = 0;
+        int64_t maxNs = 0;
+        int64_t avgNs = 0;
+        double medianNs = 0;
+        double p90Ns = 0;
+        double p99Ns = 0;
+        double stddevNs = 0;
+        /** Number of timing samples the percentiles and stddev are based on. */
+        uint64_t samples = 0;
+        uint64_t minCycles = 0;
+        uint64_t maxCycles = 0;
+        uint64_t avgCycles = 0;
+    };
+
     class State {
         std::string name;
         duration maxElapsed;
+        uint64_t fixedIterations;
+        uint64_t warmupRemaining;
+        std::vector<Result>& results;
         time_point beginTime, lastTime;
         duration minTime, maxTime;
         uint64_t count;
@@ -59,14 +104,21 @@ namespace benchmark {
         uint64_t lastCycles;
         uint64_t minCycles;
         uint64_t maxCycles;
+        // Per-iteration time of each measured batch, in nanoseconds.
+        std::vector<double> samples;
+
+        void Report(time_point now, uint64_t nowCycles);
     public:
-        State(std::string _name, duration _maxElapsed) :
+        State(std::string _name, const Options& options, std::vector<Result>& _results) :
             name(_name),
-            maxElapsed(_maxElapsed),
+            maxElapsed(options.elapsedTimeForOne),
+            fixedIterations(options.iterations),
+            warmupRemaining(options.warmup),
+            results(_results),
             minTime(duration::max()),
             maxTime(duration::zero()),
             count(0),
-            countMask(1),
+            countMask(options.iterations ? 0 : 1),
             beginCycles(0),
             lastCycles(0),
             minCycles(std::numeric_limits<uint64_t>::max()),
@@ -85,8 +137,20 @@ namespace benchmark {
     public:
         BenchRunner(std::string name, BenchFunction func);
 
-        static void RunAll(duration elapsedTimeForOne = std::chrono::seconds(1));
+        /**
+         * Runs all benchmarks selected by the options and reports them.
+         * Returns false if a baseline was given and a regression was detected.
+         */
+        static bool RunAll(const Options& options = Options());
     };
+
+    /**
+     * Compares a result against a baseline result. Returns true if the
+     * current run is slower by more than thresholdPercent and the difference
+     * is statistically significant (Welch's t-test, |t| > 2.58, which is
+     * roughly a 99% confidence level for the sample sizes we collect).
+     */
+    bool IsRegression(const Result& baseline, const Result& current, double thresholdPercent);
 }
 
 // BENCHMARK(foo) expands to:  benchmark::BenchRunner bench_11foo("foo", foo);
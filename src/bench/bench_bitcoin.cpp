@@ -10,14 +10,92 @@
 #include "key.h"
 #include "main.h"
 #include "util/system.h"
+#include "util/strencodings.h"
+#include "tinyformat.h"
 
 #include <rust/init.h>
 
+#include <iostream>
+#include <regex>
+
 const std::function<std::string(const char*)> G_TRANSLATION_FUN = nullptr;
 
+static const char* DEFAULT_BENCH_FILTER = ".*";
+static const int64_t DEFAULT_BENCH_TIME_MS = 1000;
+static const int64_t DEFAULT_BENCH_ITERATIONS = 0;
+static const int64_t DEFAULT_BENCH_WARMUP = 0;
+static const char* DEFAULT_BENCH_REGRESSION_THRESHOLD = "5";
+
+static std::string HelpMessageBench()
+{
+    std::string strUsage = "Usage: bench_bitcoin [options]\n\nOptions:\n";
+    strUsage += "  -?                          Print this help message and exit\n";
+    strUsage += "  -list                       List the benchmarks selected by -filter without running them\n";
+    strUsage += strprintf("  -filter=<regex>             Run only benchmarks whose name fully matches the regex (default: %s)\n", DEFAULT_BENCH_FILTER);
+    strUsage += strprintf("  -time=<n>                   Time budget per benchmark in milliseconds (default: %d)\n", DEFAULT_BENCH_TIME_MS);
+    strUsage += "  -iterations=<n>             Run exactly <n> timed iterations per benchmark instead of using -time\n";
+    strUsage += strprintf("  -warmup=<n>                 Run <n> untimed iterations before measuring (default: %d)\n", DEFAULT_BENCH_WARMUP);
+    strUsage += "  -output-csv=<file>          Also write results as CSV to <file>\n";
+    strUsage += "  -output-json=<file>         Write results as JSON to <file>, usable as a -baseline\n";
+    strUsage += "  -baseline=<file>            Compare results against a JSON file from a previous run; exit with an error on regressions\n";
+    strUsage += strprintf("  -regression-threshold=<n>   Minimum slowdown in percent that -baseline reports as a regression (default: %s)\n", DEFAULT_BENCH_REGRESSION_THRESHOLD);
+    return strUsage;
+}
+
+// Reads an integer option of at least nMin. Prints an error and returns false
+// if it is set to anything else.
+static bool GetCountArg(const std::string& strArg, int64_t nDefault, int64_t nMin, int64_t& nOut)
+{
+    nOut = nDefault;
+    if (mapArgs.count(strArg) && (!ParseInt64(mapArgs[strArg], &nOut) || nOut < nMin)) {
+        std::cerr << "Error: " << strArg << " must be an integer of at least " << nMin << ", got '" << mapArgs[strArg] << "'\n";
+        return false;
+    }
+    return true;
+}
+
 int
 main(int argc, char** argv)
 {
+    ParseParameters(argc, argv);
+    if (mapArgs.count("-?") || mapArgs.count("-h") || mapArgs.count("-help")) {
+        std::cout << HelpMessageBench();
+        return EXIT_SUCCESS;
+    }
+
+    benchmark::Options options;
+    options.filter = GetArg("-filter", DEFAULT_BENCH_FILTER);
+    try {
+        std::regex filter(options.filter);
+    } catch (const std::regex_error& e) {
+        std::cerr << "Error: invalid -filter regex '" << options.filter << "': " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    int64_t nTimeMs, nIterations, nWarmup;
+    // A zero time budget would stop State::KeepRunning before the first
+    // timed iteration.
+    if (!GetCountArg("-time", DEFAULT_BENCH_TIME_MS, 1, nTimeMs) ||
+        !GetCountArg("-iterations", DEFAULT_BENCH_ITERATIONS, 0, nIterations) ||
+        !GetCountArg("-warmup", DEFAULT_BENCH_WARMUP, 0, nWarmup)) {
+        return EXIT_FAILURE;
+    }
+    options.elapsedTimeForOne = std::chrono::milliseconds(nTimeMs);
+    options.iterations = nIterations;
+    options.warmup = nWarmup;
+    options.listOnly = GetBoolArg("-list", false);
+    options.outputCsv = GetArg("-output-csv", "");
+    options.outputJson = GetArg("-output-json", "");
+    options.baseline = GetArg("-baseline", "");
+    std::string strThreshold = GetArg("-regression-threshold", DEFAULT_BENCH_REGRESSION_THRESHOLD);
+    if (!ParseDouble(strThreshold, &options.regressionThreshold) || options.regressionThreshold < 0) {
+        std::cerr << "Error: -regression-threshold must be a non-negative number, got '" << strThreshold << "'\n";
+        return EXIT_FAILURE;
+    }
+
+    if (options.listOnly) {
+        return benchmark::BenchRunner::RunAll(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     SHA256AutoDetect();
     ECC_Start();
     SetupEnvironment();
@@ -37,7 +115,9 @@ main(int argc, char** argv)
         true
     );
 
-    benchmark::BenchRunner::RunAll();
+    bool ok = benchmark::BenchRunner::RunAll(options);
 
     ECC_Stop();
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
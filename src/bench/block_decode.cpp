@@ -0,0 +1,87 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "bench.h"
+
+#include "checkqueue.h"
+#include "primitives/block.h"
+#include "primitives/transaction.h"
+#include "streams.h"
+#include "util/system.h"
+#include "version.h"
+
+#include <assert.h>
+
+#include <algorithm>
+
+#include <boost/thread/thread.hpp>
+
+// A block of transparent transactions with two inputs and two outputs each.
+static CDataStream MakeSerializedBlock(size_t nTransactions)
+{
+    CBlock block;
+    for (size_t n = 0; n < nTransactions; n++) {
+        CMutableTransaction mtx;
+        mtx.vin.resize(2);
+        mtx.vout.resize(2);
+        for (size_t i = 0; i < 2; i++) {
+            *mtx.vin[i].prevout.hash.begin() = n & 0xff;
+            *(mtx.vin[i].prevout.hash.begin() + 1) = (n >> 8) & 0xff;
+            mtx.vin[i].prevout.n = i;
+            mtx.vin[i].scriptSig = CScript() << std::vector<unsigned char>(72, 0xaa)
+                                             << std::vector<unsigned char>(33, 0xbb);
+            mtx.vout[i].nValue = 150000000;
+            mtx.vout[i].scriptPubKey = CScript() << OP_DUP << OP_HASH160
+                                                 << std::vector<unsigned char>(20, 0xcc)
+                                                 << OP_EQUALVERIFY << OP_CHECKSIG;
+        }
+        block.vtx.push_back(CTransaction(mtx));
+    }
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << block;
+    return ss;
+}
+
+static void DecodeBlock(benchmark::State& state)
+{
+    const CDataStream serialized = MakeSerializedBlock(2000);
+    while (state.KeepRunning()) {
+        CDataStream ss(serialized);
+        CBlock block;
+        ss >> block;
+        assert(block.vtx.size() == 2000 && !block.vtx.back().GetHash().IsNull());
+    }
+}
+
+static void DecodeBlockSerialHashes(benchmark::State& state)
+{
+    DecodeBlock(state);
+}
+
+// Hashes on a check queue, as the node does on its script check threads.
+static void DecodeBlockParallelHashes(benchmark::State& state)
+{
+    CCheckQueue<CFunctionCheck> queue(128);
+    boost::thread_group threads;
+    for (int i = 1; i < std::max(GetNumCores(), 2); i++) {
+        threads.create_thread([&] { queue.Thread(); });
+    }
+    SetTransactionHashRunner([&](const std::vector<std::function<bool()>>& vJobs) {
+        CCheckQueueControl<CFunctionCheck> control(&queue);
+        std::vector<CFunctionCheck> vChecks;
+        for (const std::function<bool()>& job : vJobs) {
+            vChecks.emplace_back(job);
+        }
+        control.Add(vChecks);
+        control.Wait();
+        return true;
+    });
+    DecodeBlock(state);
+    SetTransactionHashRunner(nullptr);
+    threads.interrupt_all();
+    threads.join_all();
+}
+
+BENCHMARK(DecodeBlockSerialHashes);
+BENCHMARK(DecodeBlockParallelHashes);
@@ -0,0 +1,121 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "bench.h"
+
+#include "uint256.h"
+
+#include <univalue.h>
+
+#include <string>
+#include <vector>
+
+// Builds an object shaped like one transaction in getblock's verbose output,
+// the way TxToJSON does.
+static UniValue MakeTxObject(int n)
+{
+    uint256 txid;
+    *txid.begin() = n & 0xff;
+    *(txid.begin() + 1) = (n >> 8) & 0xff;
+    const std::string hex(2 * 250, 'a');
+
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("txid", txid.GetHex());
+    entry.pushKV("authdigest", txid.GetHex());
+    entry.pushKV("size", 250);
+    entry.pushKV("overwintered", true);
+    entry.pushKV("version", 5);
+    entry.pushKV("locktime", (int64_t)0);
+    entry.pushKV("expiryheight", (int64_t)n);
+    entry.pushKV("hex", hex);
+
+    UniValue vin(UniValue::VARR);
+    vin.reserve(2);
+    for (int i = 0; i < 2; i++) {
+        UniValue in(UniValue::VOBJ);
+        in.pushKV("txid", txid.GetHex());
+        in.pushKV("vout", (int64_t)i);
+        UniValue o(UniValue::VOBJ);
+        o.pushKV("asm", std::string(140, 'b'));
+        o.pushKV("hex", std::string(214, 'c'));
+        in.pushKV("scriptSig", std::move(o));
+        in.pushKV("sequence", (int64_t)0xffffffff);
+        vin.push_back(std::move(in));
+    }
+    entry.pushKV("vin", std::move(vin));
+
+    UniValue vout(UniValue::VARR);
+    vout.reserve(2);
+    for (int i = 0; i < 2; i++) {
+        UniValue out(UniValue::VOBJ);
+        out.pushKV("value", 1.5);
+        out.pushKV("valueZat", (int64_t)150000000);
+        out.pushKV("n", (int64_t)i);
+        UniValue o(UniValue::VOBJ);
+        o.pushKV("asm", std::string(80, 'd'));
+        o.pushKV("hex", std::string(50, 'e'));
+        o.pushKV("type", "pubkeyhash");
+        out.pushKV("scriptPubKey", std::move(o));
+        vout.push_back(std::move(out));
+    }
+    entry.pushKV("vout", std::move(vout));
+    entry.pushKV("vjoinsplit", UniValue(UniValue::VARR));
+    return entry;
+}
+
+static UniValue MakeVerboseBlock(int nTx)
+{
+    UniValue txs(UniValue::VARR);
+    txs.reserve(nTx);
+    for (int i = 0; i < nTx; i++) {
+        txs.push_back(MakeTxObject(i));
+    }
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("hash", uint256().GetHex());
+    result.pushKV("height", 1000000);
+    result.pushKV("tx", std::move(txs));
+    return result;
+}
+
+static void RpcBuildVerboseBlock(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        UniValue block = MakeVerboseBlock(1000);
+    }
+}
+
+static void RpcWriteVerboseBlock(benchmark::State& state)
+{
+    UniValue block = MakeVerboseBlock(1000);
+    while (state.KeepRunning()) {
+        std::string json = block.write();
+    }
+}
+
+// getrawmempool true: one member per transaction, keyed by txid.
+static void RpcBuildMempoolObject(benchmark::State& state)
+{
+    std::vector<std::string> txids;
+    for (int i = 0; i < 5000; i++) {
+        uint256 txid;
+        *txid.begin() = i & 0xff;
+        *(txid.begin() + 1) = (i >> 8) & 0xff;
+        txids.push_back(txid.GetHex());
+    }
+    while (state.KeepRunning()) {
+        UniValue o(UniValue::VOBJ);
+        o.reserve(txids.size());
+        for (const std::string& txid : txids) {
+            UniValue info(UniValue::VOBJ);
+            info.pushKV("size", 250);
+            info.pushKV("fee", 0.0001);
+            info.pushKV("depends", UniValue(UniValue::VARR));
+            o.pushKVEnd(txid, std::move(info));
+        }
+    }
+}
+
+BENCHMARK(RpcBuildVerboseBlock);
+BENCHMARK(RpcWriteVerboseBlock);
+BENCHMARK(RpcBuildMempoolObject);
@@ -0,0 +1,80 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "main.h"
+#include "net.h"
+#include "sync.h"
+#include "util/time.h"
+#include "version.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static const int IDLE_PEERS = 8;
+
+// SendMessages for peers that have nothing to download from, as a message
+// handler loop runs it. With fContended set, another thread holds cs_main
+// almost all of the time, as block validation does during a sync. Idle
+// peers never wait for cs_main, so both runs should take the same time.
+static void SendMessagesIdlePeers(benchmark::State& state, bool fContended)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    const Consensus::Params& params = Params().GetConsensus();
+    RegisterNodeSignals(GetNodeSignals());
+
+    std::vector<std::unique_ptr<CNode>> vPeers;
+    for (int i = 0; i < IDLE_PEERS; i++) {
+        struct in_addr ipv4;
+        ipv4.s_addr = htonl(0x0a000001 + i);
+        CAddress addr(CService(CNetAddr(ipv4), Params().GetDefaultPort()));
+        vPeers.emplace_back(new CNode(INVALID_SOCKET, addr, "", true));
+        vPeers.back()->nVersion = PROTOCOL_VERSION;
+        vPeers.back()->fClient = true;
+        // Leave out the first round of ping, addr and local address
+        // announcements.
+        SendMessages(params, vPeers.back().get());
+    }
+
+    std::atomic<bool> fStop(false);
+    std::thread holder;
+    if (fContended) {
+        holder = std::thread([&fStop] {
+            while (!fStop) {
+                LOCK(cs_main);
+                MilliSleep(1);
+            }
+        });
+    }
+
+    while (state.KeepRunning()) {
+        for (const auto& pnode : vPeers) {
+            SendMessages(params, pnode.get());
+        }
+    }
+
+    fStop = true;
+    if (holder.joinable()) {
+        holder.join();
+    }
+    vPeers.clear();
+    UnregisterNodeSignals(GetNodeSignals());
+}
+
+static void SendMessagesIdlePeersFree(benchmark::State& state)
+{
+    SendMessagesIdlePeers(state, false);
+}
+
+static void SendMessagesIdlePeersContended(benchmark::State& state)
+{
+    SendMessagesIdlePeers(state, true);
+}
+
+BENCHMARK(SendMessagesIdlePeersFree);
+BENCHMARK(SendMessagesIdlePeersContended);
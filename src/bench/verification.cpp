@@ -18,7 +18,9 @@
 #include <rust/bridge.h>
 #include <rust/ed25519.h>
 
-static void ECDSA(benchmark::State& state)
+// Verifies every input of a P2PKH transaction with nInputs inputs, signed by
+// nKeys distinct keys in turn.
+static void VerifyP2PKHInputs(benchmark::State& state, uint32_t nInputs, uint32_t nKeys, bool fCompressed)
 {
     uint32_t consensusBranchId = NetworkUpgradeInfo[Consensus::UPGRADE_OVERWINTER].nBranchId;
     CMutableTransaction mtx;
@@ -26,14 +28,14 @@ static void ECDSA(benchmark::State& state)
     mtx.nVersion = SAPLING_TX_VERSION;
     mtx.nVersionGroupId = SAPLING_VERSION_GROUP_ID;
 
-    CKey key = CKey::TestOnlyRandomKey(false);
     CBasicKeyStore keystore;
-    keystore.AddKeyPubKey(key, key.GetPubKey());
-    CKeyID hash = key.GetPubKey().GetID();
-    CScript scriptPubKey = GetScriptForDestination(hash);
+    std::vector<CScript> scriptPubKeys;
+    for (uint32_t k = 0; k < nKeys; k++) {
+        CKey key = CKey::TestOnlyRandomKey(fCompressed);
+        keystore.AddKeyPubKey(key, key.GetPubKey());
+        scriptPubKeys.push_back(GetScriptForDestination(key.GetPubKey().GetID()));
+    }
 
-    // Benchmark a transaction containing a single input and output.
-    auto nInputs = 1;
     for(uint32_t ij = 0; ij < nInputs; ij++) {
         uint32_t i = mtx.vin.size();
         uint256 prevId;
@@ -56,7 +58,7 @@ static void ECDSA(benchmark::State& state)
 
     // sign all inputs
     for(uint32_t i = 0; i < mtx.vin.size(); i++) {
-        bool hashSigned = SignSignature(keystore, scriptPubKey, mtx, txdata, i, 1000, SIGHASH_ALL, consensusBranchId);
+        bool hashSigned = SignSignature(keystore, scriptPubKeys[i % nKeys], mtx, txdata, i, 1000, SIGHASH_ALL, consensusBranchId);
         assert(hashSigned);
     }
 
@@ -68,16 +70,38 @@ static void ECDSA(benchmark::State& state)
     ScriptError error;
 
     while (state.KeepRunning()) {
-        VerifyScript(
-            tx.vin[0].scriptSig,
-            scriptPubKey,
-            SCRIPT_VERIFY_P2SH,
-            TransactionSignatureChecker(&tx, txdata, 0, 1000),
-            consensusBranchId,
-            &error);
+        for (uint32_t i = 0; i < tx.vin.size(); i++) {
+            bool fValid = VerifyScript(
+                tx.vin[i].scriptSig,
+                scriptPubKeys[i % nKeys],
+                SCRIPT_VERIFY_P2SH,
+                TransactionSignatureChecker(&tx, txdata, i, 1000),
+                consensusBranchId,
+                &error);
+            assert(fValid);
+        }
     }
 }
 
+// Benchmark a transaction containing a single input and output.
+static void ECDSA(benchmark::State& state)
+{
+    VerifyP2PKHInputs(state, 1, 1, false);
+}
+
+// A consolidation of 100 outputs sent to the same address, which presents
+// the same public key for every input.
+static void ECDSAConsolidation(benchmark::State& state)
+{
+    VerifyP2PKHInputs(state, 100, 1, true);
+}
+
+// 100 inputs from 100 different addresses, for comparison.
+static void ECDSADistinctKeys(benchmark::State& state)
+{
+    VerifyP2PKHInputs(state, 100, 100, true);
+}
+
 static void JoinSplitSig(benchmark::State& state)
 {
     ed25519::VerificationKey joinSplitPubKey;
@@ -136,6 +160,8 @@ static void SaplingOutput(benchmark::State& state)
 }
 
 BENCHMARK(ECDSA);
+BENCHMARK(ECDSAConsolidation);
+BENCHMARK(ECDSADistinctKeys);
 BENCHMARK(JoinSplitSig);
 BENCHMARK(SaplingSpend);
 BENCHMARK(SaplingOutput);
@@ -8,6 +8,7 @@
 #define BITCOIN_CHAIN_H
 
 #include "arith_uint256.h"
+#include "memusage.h"
 #include "primitives/block.h"
 #include "pow.h"
 #include "tinyformat.h"
@@ -183,6 +184,8 @@ enum BlockStatus: uint32_t {
     BLOCK_FAILED_MASK        =   BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 
     BLOCK_ACTIVATES_UPGRADE  =   128, //! block activates a network upgrade
+
+    BLOCK_POW_UNVERIFIED     =   256, //! RandomX solution of the header not checked yet (-assumevalid)
 };
 
 //! Short-hand for the highest consensus validity we implement.
@@ -502,6 +505,12 @@ public:
         nSolution = solution;
     }
 
+    //! Memory held by the stored solution, in bytes.
+    size_t SolutionMemoryUsage() const
+    {
+        return memusage::DynamicUsage(nSolution);
+    }
+
     //! Raise the validity level of this block index entry.
     //! Returns true if the validity was changed.
     bool RaiseValidity(enum BlockStatus nUpTo)
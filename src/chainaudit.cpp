@@ -0,0 +1,87 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "chainaudit.h"
+
+#include "chainparams.h"
+#include "compat.h"
+#include "main.h"
+#include "sync.h"
+#include "util/system.h"
+#include "util/time.h"
+#include "warnings.h"
+
+#include <optional>
+
+#include <boost/thread.hpp>
+
+#include <rust/metrics.h>
+
+namespace {
+
+// A block that failed its checks may have been pruned or reorged out while
+// we were reading it, which is not corruption.
+bool IsStillStored(const CStoredBlock& stored)
+{
+    LOCK(cs_main);
+    CBlockIndex* pindex = chainActive[stored.nHeight];
+    return pindex != nullptr &&
+        pindex->GetBlockHash() == stored.hash &&
+        (pindex->nStatus & BLOCK_HAVE_DATA);
+}
+
+}
+
+void ThreadChainAudit()
+{
+    // Auditing competes with nothing the node needs to do now.
+    SetThreadPriority(THREAD_PRIORITY_LOWEST);
+
+    const CChainParams& chainparams = Params();
+    while (true) {
+        while (IsInitialBlockDownload(chainparams.GetConsensus())) {
+            MilliSleep(60 * 1000);
+        }
+
+        LogPrintf("Chain audit: starting a pass over the active chain\n");
+        int64_t nStart = GetTime();
+        int nCorrupt = 0;
+        int nHeight = 0;
+        for (;; nHeight++) {
+            boost::this_thread::interruption_point();
+
+            std::optional<CStoredBlock> stored;
+            {
+                LOCK(cs_main);
+                CBlockIndex* pindex = chainActive[nHeight];
+                if (pindex == nullptr) {
+                    break;
+                }
+                if (pindex->pprev != nullptr && (pindex->nStatus & BLOCK_HAVE_DATA)) {
+                    stored = GetStoredBlock(chainparams, pindex);
+                }
+            }
+
+            std::string strError;
+            if (stored && !CheckStoredBlock(chainparams, *stored, 2, strError) && IsStillStored(*stored)) {
+                nCorrupt++;
+                LogPrintf("ERROR: Chain audit: %s\n", strError);
+                MetricsIncrementCounter("zcashd.chainaudit.corrupt_blocks");
+                SetMiscWarning(strprintf(
+                    _("Warning: The stored data of block %d is corrupt; restart with -reindex to repair it."),
+                    stored->nHeight), GetTime());
+            }
+
+            MetricsGauge("zcashd.chainaudit.height", (double)nHeight);
+            if (nHeight > 0 && nHeight % CHAIN_AUDIT_LOG_INTERVAL == 0) {
+                LogPrintf("Chain audit: checked up to height %d, %d corrupt blocks found\n", nHeight, nCorrupt);
+            }
+        }
+        LogPrintf("Chain audit: pass complete, %d blocks checked, %d corrupt blocks found (%ds)\n",
+            nHeight, nCorrupt, GetTime() - nStart);
+        MetricsIncrementCounter("zcashd.chainaudit.passes");
+
+        MilliSleep(CHAIN_AUDIT_PASS_INTERVAL * 1000);
+    }
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_CHAINAUDIT_H
+#define BITCOIN_CHAINAUDIT_H
+
+#include <stdint.h>
+
+/**
+ * Background audit of the stored chain.
+ *
+ * -checkblocks only looks at the most recent blocks at startup, and deeper
+ * checks make restarts slow. With -auditchain, a thread running at the lowest
+ * priority walks the active chain from genesis to the tip, over and over,
+ * re-reading every stored block and its undo data and running the same checks
+ * as -checklevel=2. It only takes cs_main to look up the next block. Progress
+ * is logged and published as metrics; corrupt data is logged and raised as a
+ * warning, as it can only be repaired with -reindex.
+ */
+
+/** Default for -auditchain. */
+static const bool DEFAULT_AUDIT_CHAIN = false;
+/** Pause between two passes over the chain, in seconds. */
+static const int64_t CHAIN_AUDIT_PASS_INTERVAL = 24 * 60 * 60;
+/** Number of blocks between two progress messages in the log. */
+static const int CHAIN_AUDIT_LOG_INTERVAL = 10000;
+
+void ThreadChainAudit();
+
+#endif // BITCOIN_CHAINAUDIT_H
@@ -7,6 +7,11 @@
 #define BITCOIN_CHECKQUEUE_H
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <boost/thread/condition_variable.hpp>
@@ -18,21 +23,42 @@
 template <typename T>
 class CCheckQueueControl;
 
-/** 
+/**
  * Queue for verifications that have to be performed.
   * The verifications are represented by a type T, which must provide an
-  * operator(), returning a bool.
+  * operator(), returning a bool, and a swap() member.
   *
   * One thread (the master) is assumed to push batches of verifications
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every worker (and the master) owns a local deque. Added checks are
+  * spread over those deques in batches; a worker takes work from the back
+  * of its own deque and, once that is empty, steals from the front of the
+  * other deques. Each deque has its own lock, so workers only contend when
+  * they touch the same deque. The shared mutex is only taken to go to sleep
+  * and to wake sleepers up.
+  *
+  * As soon as one check fails, the remaining checks are destroyed without
+  * being evaluated.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    //! Number of local deques; workers beyond this share deques.
+    static constexpr int MAX_WORKER_QUEUES = 64;
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<T> checks;
+    };
+
+    //! Per-worker deques. Index 0 belongs to the master.
+    WorkerQueue workerQueues[MAX_WORKER_QUEUES];
+
+    //! Mutex protecting sleeping and waking up; does not guard the deques.
     boost::mutex mutex;
 
     //! Worker threads block on this when out of work
@@ -41,25 +67,30 @@ private:
     //! Master thread blocks on this when out of work
     boost::condition_variable condMaster;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue;
-
-    //! The number of workers (including the master) that are idle.
-    int nIdle;
-
-    //! The total number of workers (including the master).
-    int nTotal;
-
-    //! The temporary evaluation result.
-    bool fAllOk;
+    //! Number of checks sitting in the deques, not yet taken by any worker.
+    std::atomic<unsigned int> nQueued;
 
     /**
      * Number of verifications that haven't completed yet.
      * This includes elements that are no longer queued, but still in the
      * worker's own batches.
      */
-    unsigned int nTodo;
+    std::atomic<unsigned int> nTodo;
+
+    //! The temporary evaluation result; cleared by the first failing check.
+    std::atomic<bool> fAllOk;
+
+    //! The number of workers (excluding the master) that are asleep.
+    std::atomic<int> nIdle;
+
+    //! The total number of workers (excluding the master).
+    std::atomic<int> nWorkers;
+
+    //! Number of deques that have ever been assigned to a thread.
+    std::atomic<int> nQueuesUsed;
+
+    //! Deque that the next batch passed to Add() starts at.
+    unsigned int nNextQueue;
 
     //! Whether we're shutting down.
     bool fQuit;
@@ -67,64 +98,125 @@ private:
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
+    int ActiveQueues() const
+    {
+        return std::min(nWorkers.load() + 1, MAX_WORKER_QUEUES);
+    }
+
+    //! How many checks to take at once out of a deque holding `size` checks.
+    unsigned int BatchFor(size_t size) const
+    {
+        // Leave half of the deque behind so that idle workers can steal it,
+        // but don't do batches smaller than 1 or larger than nBatchSize.
+        return std::max(1U, std::min(nBatchSize, (unsigned int)(size / 2)));
+    }
+
+    /**
+     * Moves a batch of checks into vChecks, first from the back of our own
+     * deque, otherwise from the front of another one. Returns false if there
+     * was nothing to take.
+     */
+    bool Take(int self, std::vector<T>& vChecks)
+    {
+        {
+            WorkerQueue& own = workerQueues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.checks.empty()) {
+                unsigned int nNow = BatchFor(own.checks.size());
+                vChecks.resize(nNow);
+                for (unsigned int i = 0; i < nNow; i++) {
+                    vChecks[i].swap(own.checks.back());
+                    own.checks.pop_back();
+                }
+                nQueued -= nNow;
+                return true;
+            }
+        }
+        // Scan every deque that was ever in use, so that checks are not
+        // stranded in the deque of a worker that has since exited.
+        int nQueues = nQueuesUsed;
+        for (int i = 1; i <= nQueues; i++) {
+            int q = (self + i) % nQueues;
+            if (q == self) continue;
+            WorkerQueue& victim = workerQueues[q];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.checks.empty()) {
+                unsigned int nNow = BatchFor(victim.checks.size());
+                vChecks.resize(nNow);
+                for (unsigned int j = 0; j < nNow; j++) {
+                    vChecks[j].swap(victim.checks.front());
+                    victim.checks.pop_front();
+                }
+                nQueued -= nNow;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! Evaluates (or, after a failure, just discards) a batch and retires it.
+    void Run(std::vector<T>& vChecks, bool fMaster)
+    {
+        unsigned int nNow = vChecks.size();
+        for (T& check : vChecks) {
+            if (!fAllOk.load(std::memory_order_relaxed)) break;
+            if (!check()) fAllOk = false;
+        }
+        // Destroy the checks before reporting them as done, so that the
+        // master never returns while check destructors are still running.
+        vChecks.clear();
+        if (nTodo.fetch_sub(nNow) == nNow && !fMaster) {
+            // We processed the last element; inform the master it can exit and return the result
+            boost::unique_lock<boost::mutex> lock(mutex);
+            condMaster.notify_one();
+        }
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster = false)
+    bool Loop(int self, bool fMaster = false)
     {
-        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
         do {
-            {
-                boost::unique_lock<boost::mutex> lock(mutex);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        condMaster.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
+            if (Take(self, vChecks)) {
+                Run(vChecks, fMaster);
+                continue;
+            }
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (fMaster) {
+                if (nTodo == 0) {
+                    bool fRet = fAllOk;
+                    // reset the status for new work later
+                    fAllOk = true;
+                    // return the current status
+                    return fRet;
                 }
-                // logically, the do loop starts here
-                while (queue.empty()) {
-                    if ((fMaster || fQuit) && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        if (fMaster)
-                            fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
+                if (nQueued == 0) {
+                    condMaster.wait(lock);
                 }
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
+            } else {
+                if (fQuit && nTodo == 0) {
+                    return fAllOk;
                 }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                // Announce that we are about to sleep before checking for
+                // work, so that Add() either sees us idle or we see its work.
+                // A non-zero nQueued with nothing to take means another
+                // worker is in the middle of taking a batch; just retry.
+                nIdle++;
+                if (nQueued == 0) {
+                    try {
+                        condWorker.wait(lock);
+                    } catch (...) {
+                        nIdle--;
+                        throw;
+                    }
+                }
+                nIdle--;
+            }
+            if (nQueued != 0) {
+                lock.unlock();
+                std::this_thread::yield();
             }
-            // execute work
-            for (T& check : vChecks)
-                if (fOk)
-                    fOk = check();
-            vChecks.clear();
         } while (true);
     }
 
@@ -133,33 +225,59 @@ public:
     boost::mutex ControlMutex;
 
     //! Create a new check queue
-    CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), fQuit(false), nBatchSize(nBatchSizeIn) {}
+    CCheckQueue(unsigned int nBatchSizeIn) : nQueued(0), nTodo(0), fAllOk(true), nIdle(0), nWorkers(0), nQueuesUsed(1), nNextQueue(0), fQuit(false), nBatchSize(nBatchSizeIn) {}
 
     //! Worker thread
     void Thread()
     {
-        Loop();
+        int self = 1 + (nWorkers++ % (MAX_WORKER_QUEUES - 1));
+        int nUsed = nQueuesUsed;
+        while (nUsed <= self && !nQueuesUsed.compare_exchange_weak(nUsed, self + 1)) {}
+        try {
+            Loop(self);
+        } catch (...) {
+            nWorkers--;
+            throw;
+        }
+        nWorkers--;
     }
 
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait()
     {
-        return Loop(true);
+        return Loop(0, true);
     }
 
     //! Add a batch of checks to the queue
     void Add(std::vector<T>& vChecks)
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        for (T& check : vChecks) {
-            queue.push_back(T());
-            check.swap(queue.back());
-        }
+        if (vChecks.empty()) return;
+
         nTodo += vChecks.size();
-        if (vChecks.size() == 1)
-            condWorker.notify_one();
-        else if (vChecks.size() > 1)
-            condWorker.notify_all();
+        // Hand the checks out in batches, one deque after another, so that
+        // consecutive calls (typically one per transaction) end up local to
+        // different workers.
+        int nQueues = ActiveQueues();
+        for (size_t start = 0; start < vChecks.size(); start += nBatchSize) {
+            size_t end = std::min(vChecks.size(), start + nBatchSize);
+            WorkerQueue& target = workerQueues[nNextQueue++ % nQueues];
+            std::lock_guard<std::mutex> lock(target.mutex);
+            for (size_t i = start; i < end; i++) {
+                target.checks.emplace_back();
+                target.checks.back().swap(vChecks[i]);
+            }
+            nQueued += end - start;
+        }
+
+        // Only take the mutex if somebody is asleep; busy workers will find
+        // the new checks on their own.
+        if (nIdle > 0) {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (vChecks.size() == 1)
+                condWorker.notify_one();
+            else
+                condWorker.notify_all();
+        }
     }
 
     ~CCheckQueue()
@@ -168,7 +286,25 @@ public:
 
 };
 
-/** 
+/**
+ * Adapter that lets arbitrary verification work (for example chunks of a
+ * shielded batch validation or header checks) run on a CCheckQueue.
+ */
+class CFunctionCheck
+{
+private:
+    std::function<bool()> func;
+
+public:
+    CFunctionCheck() {}
+    explicit CFunctionCheck(std::function<bool()> funcIn) : func(std::move(funcIn)) {}
+
+    bool operator()() { return !func || func(); }
+
+    void swap(CFunctionCheck& check) { func.swap(check.func); }
+};
+
+/**
  * RAII-style controller object for a CCheckQueue that guarantees the passed
  * queue is finished before continuing.
  */
@@ -179,6 +315,17 @@ private:
     CCheckQueue<T> * const pqueue;
     bool fDone;
 
+    static CCheckQueue<T>* TryEnter(CCheckQueue<T> * const pqueueIn)
+    {
+        if (pqueueIn == NULL)
+            return NULL;
+        EnterCritical("pqueue->ControlMutex", __FILE__, __LINE__, (void*)(&pqueueIn->ControlMutex), true);
+        if (pqueueIn->ControlMutex.try_lock())
+            return pqueueIn;
+        LeaveCritical();
+        return NULL;
+    }
+
 public:
     CCheckQueueControl() = delete;
     CCheckQueueControl(const CCheckQueueControl&) = delete;
@@ -191,6 +338,12 @@ public:
         }
     }
 
+    //! Takes the passed queue only if it is unused; see HasQueue().
+    CCheckQueueControl(CCheckQueue<T> * const pqueueIn, std::try_to_lock_t) : pqueue(TryEnter(pqueueIn)), fDone(false) {}
+
+    //! Whether the checks added are run on the queue.
+    bool HasQueue() const { return pqueue != NULL; }
+
     bool Wait()
     {
         if (pqueue == NULL)
@@ -0,0 +1,255 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "coinbasepool.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "compat.h"
+#include "util/match.h"
+#include "util/system.h"
+#include "util/time.h"
+#include "validationinterface.h"
+
+#include <algorithm>
+
+#include <rust/metrics.h>
+
+namespace {
+
+bool SameMinerAddress(const MinerAddress& a, const MinerAddress& b)
+{
+    if (a.index() != b.index()) return false;
+    return examine(a, match {
+        [&](const libzcash::OrchardRawAddress& addr) {
+            return addr == std::get<libzcash::OrchardRawAddress>(b);
+        },
+        [&](const libzcash::SaplingPaymentAddress& addr) {
+            return addr == std::get<libzcash::SaplingPaymentAddress>(b);
+        },
+        [&](const boost::shared_ptr<CReserveScript>& script) {
+            return script == std::get<boost::shared_ptr<CReserveScript>>(b);
+        },
+    });
+}
+
+CCoinbasePool pool;
+
+}
+
+CAmount CoinbasePoolFeeBucket(CAmount nFees)
+{
+    if (nFees <= 0) {
+        return 0;
+    }
+    CAmount nUnit = 1;
+    while (nFees / nUnit >= 100) {
+        nUnit *= 10;
+    }
+    return nFees / nUnit * nUnit;
+}
+
+void CCoinbasePool::Reset()
+{
+    coinbases.clear();
+    failed.clear();
+    nGeneration++;
+}
+
+std::optional<CCoinbasePool::Job> CCoinbasePool::FindJob() const
+{
+    if (!fEnabled || !address || pindexTip == nullptr) {
+        return std::nullopt;
+    }
+    for (int nHeight = pindexTip->nHeight + 1; nHeight <= pindexTip->nHeight + COINBASE_POOL_DEPTH; nHeight++) {
+        for (CAmount nBucket : buckets) {
+            Key key(nHeight, nBucket);
+            if (!coinbases.count(key) && !failed.count(key)) {
+                return Job{key, *address, nGeneration};
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+void CCoinbasePool::SetTip(const CBlockIndex* pindex)
+{
+    if (pindex == pindexTip) return;
+    if (pindexTip != nullptr &&
+        (pindex->nHeight < pindexTip->nHeight || pindex->GetAncestor(pindexTip->nHeight) != pindexTip))
+    {
+        // Coinbases only commit to their height, but reorgs are rare
+        // enough that it is not worth working out which ones survive.
+        Reset();
+    } else {
+        for (auto it = coinbases.begin(); it != coinbases.end() && it->first.first <= pindex->nHeight;) {
+            it = coinbases.erase(it);
+        }
+        failed.clear();
+    }
+    pindexTip = pindex;
+    MetricsGauge("zcashd.coinbasepool.size", (double)coinbases.size());
+    cond.notify_one();
+}
+
+void CCoinbasePool::SetEnabled(bool fEnabledIn)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    fEnabled = fEnabledIn;
+    if (!fEnabled) {
+        Reset();
+    }
+    cond.notify_all();
+}
+
+bool CCoinbasePool::IsEnabled()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    return fEnabled;
+}
+
+std::optional<CCoinbasePool::Job> CCoinbasePool::NextJob()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    return FindJob();
+}
+
+CCoinbasePool::Job CCoinbasePool::WaitForJob()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    std::optional<Job> job;
+    while (!(job = FindJob())) {
+        cond.wait(lock);
+    }
+    return *job;
+}
+
+void CCoinbasePool::AddCoinbase(const Job& job, std::optional<CMutableTransaction> mtx)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    if (job.nGeneration != nGeneration ||
+        pindexTip == nullptr || job.key.first <= pindexTip->nHeight) {
+        return;
+    }
+    if (mtx) {
+        coinbases.emplace(job.key, std::move(*mtx));
+    } else {
+        failed.insert(job.key);
+    }
+    MetricsGauge("zcashd.coinbasepool.size", (double)coinbases.size());
+}
+
+std::optional<CMutableTransaction> CCoinbasePool::Get(
+    const MinerAddress& minerAddress,
+    const CBlockIndex* pindexPrev,
+    CAmount nFees)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    if (!fEnabled) {
+        return std::nullopt;
+    }
+    if (!address || !SameMinerAddress(*address, minerAddress)) {
+        address = minerAddress;
+        Reset();
+    }
+    // Tip updates are not announced during initial block download.
+    SetTip(pindexPrev);
+
+    CAmount nBucket = CoinbasePoolFeeBucket(nFees);
+    if (nBucket != 0) {
+        // The empty block's bucket always stays in front of the fee levels.
+        auto it = std::find(buckets.begin() + 1, buckets.end(), nBucket);
+        if (it != buckets.end()) {
+            buckets.erase(it);
+        }
+        buckets.insert(buckets.begin() + 1, nBucket);
+        if (buckets.size() > COINBASE_POOL_MAX_BUCKETS) {
+            buckets.pop_back();
+        }
+    }
+    cond.notify_one();
+
+    auto it = coinbases.find(Key(pindexPrev->nHeight + 1, nBucket));
+    if (it == coinbases.end()) {
+        MetricsIncrementCounter("zcashd.coinbasepool.misses");
+        return std::nullopt;
+    }
+    MetricsIncrementCounter("zcashd.coinbasepool.hits");
+    return it->second;
+}
+
+size_t CCoinbasePool::Size()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    return coinbases.size();
+}
+
+void CCoinbasePool::UpdatedBlockTip(const CBlockIndex* pindex)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    // Notifications are delivered from the scheduler thread, so a template
+    // may already have moved the pool to a newer tip. Acting on the stale
+    // notification would look like a reorg and throw the pool away. A real
+    // reorg to a chain with less work is picked up by the next template.
+    if (!fEnabled || (pindexTip != nullptr && pindex->nChainWork <= pindexTip->nChainWork)) {
+        return;
+    }
+    SetTip(pindex);
+}
+
+void StartCoinbasePool()
+{
+    pool.SetEnabled(true);
+    RegisterValidationInterface(&pool);
+}
+
+void StopCoinbasePool()
+{
+    UnregisterValidationInterface(&pool);
+    pool.SetEnabled(false);
+}
+
+bool CoinbasePoolEnabled()
+{
+    return pool.IsEnabled();
+}
+
+void ThreadCoinbasePool()
+{
+    // Proving competes with the miner, not with validation.
+    SetThreadPriority(THREAD_PRIORITY_LOWEST);
+
+    const CChainParams& chainparams = Params();
+    while (true) {
+        boost::this_thread::interruption_point();
+
+        CCoinbasePool::Job job = pool.WaitForJob();
+
+        int64_t nStart = GetTimeMicros();
+        std::optional<CMutableTransaction> mtx;
+        try {
+            mtx = CreateCoinbaseTransaction(chainparams, job.key.second, job.address, job.key.first);
+        } catch (const boost::thread_interrupted&) {
+            throw;
+        } catch (...) {
+            LogPrintf("%s: failed to create coinbase for height %d\n", __func__, job.key.first);
+        }
+        if (mtx) {
+            LogPrint("pow", "%s: proved coinbase for height %d with %d in fees (%.2fms)\n",
+                __func__, job.key.first, job.key.second, (GetTimeMicros() - nStart) * 0.001);
+        }
+        pool.AddCoinbase(job, std::move(mtx));
+    }
+}
+
+std::optional<CMutableTransaction> GetPooledCoinbase(
+    const MinerAddress& minerAddress,
+    const CBlockIndex* pindexPrev,
+    CAmount nFees)
+{
+    if (!IsShieldedMinerAddress(minerAddress)) {
+        return std::nullopt;
+    }
+    return pool.Get(minerAddress, pindexPrev, nFees);
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_COINBASEPOOL_H
+#define BITCOIN_COINBASEPOOL_H
+
+#include "amount.h"
+#include "miner.h"
+#include "primitives/transaction.h"
+#include "validationinterface.h"
+
+#include <deque>
+#include <map>
+#include <optional>
+#include <set>
+
+#include <boost/thread.hpp>
+
+class CBlockIndex;
+
+/**
+ * Pool of precomputed shielded coinbase transactions.
+ *
+ * A coinbase that pays a shielded miner address carries an Orchard (or
+ * Sapling) proof, and creating it dominates the time it takes to produce a
+ * block template once a new tip arrives. A coinbase only commits to its
+ * height, its value and the miner address, so a background thread proves
+ * coinbases for the next COINBASE_POOL_DEPTH heights ahead of time, at the
+ * fee levels recent templates asked for. Fees are rounded down to two
+ * significant digits, so a pooled coinbase forgoes less than a tenth of the
+ * block's fees; a template whose fee bucket is not ready yet proves its
+ * coinbase on the spot, and the bucket is prepared for the following ones.
+ */
+
+/** How many heights above the tip the pool prepares coinbases for. */
+static const int COINBASE_POOL_DEPTH = 2;
+/** Number of distinct fee buckets kept per height, including the empty block's. */
+static const size_t COINBASE_POOL_MAX_BUCKETS = 3;
+
+/** Rounds nFees down to the value paid by a pooled coinbase. */
+CAmount CoinbasePoolFeeBucket(CAmount nFees);
+
+/**
+ * Bookkeeping of the pool. The node has a single instance, which is driven by
+ * ThreadCoinbasePool and GetPooledCoinbase.
+ */
+class CCoinbasePool : public CValidationInterface
+{
+public:
+    /** Height and fee bucket of a coinbase. */
+    typedef std::pair<int, CAmount> Key;
+
+    /** A coinbase that still has to be proven. */
+    struct Job {
+        Key key;
+        MinerAddress address;
+        uint64_t nGeneration;
+    };
+
+private:
+    boost::mutex mutex;
+    boost::condition_variable cond;
+
+    bool fEnabled = false;
+    //! Bumped whenever the pooled coinbases are thrown away, so that a proof
+    //! that was in flight at the time is discarded too.
+    uint64_t nGeneration = 0;
+    const CBlockIndex* pindexTip = nullptr;
+    std::optional<MinerAddress> address;
+    //! Fee buckets to prepare, most recently requested first.
+    std::deque<CAmount> buckets{0};
+    std::map<Key, CMutableTransaction> coinbases;
+    //! Keys whose coinbase could not be created; not retried until the tip changes.
+    std::set<Key> failed;
+
+    void Reset();
+    std::optional<Job> FindJob() const;
+    void SetTip(const CBlockIndex* pindex);
+
+public:
+    void SetEnabled(bool fEnabledIn);
+    bool IsEnabled();
+
+    /** Returns the next coinbase to prove, if there is one. */
+    std::optional<Job> NextJob();
+    /** Blocks until there is a coinbase to prove. */
+    Job WaitForJob();
+    /** Stores the result of a job, or records that it failed if mtx is empty. */
+    void AddCoinbase(const Job& job, std::optional<CMutableTransaction> mtx);
+
+    /** See GetPooledCoinbase. */
+    std::optional<CMutableTransaction> Get(
+        const MinerAddress& minerAddress,
+        const CBlockIndex* pindexPrev,
+        CAmount nFees);
+
+    size_t Size();
+
+    void UpdatedBlockTip(const CBlockIndex* pindex) override;
+};
+
+/**
+ * Enables the pool and hooks it up to tip updates. It is off by default on
+ * networks that mine blocks on demand, where the exact coinbase value matters
+ * more than template latency.
+ */
+void StartCoinbasePool();
+void StopCoinbasePool();
+bool CoinbasePoolEnabled();
+
+/** Background thread that proves the pooled coinbases. */
+void ThreadCoinbasePool();
+
+/**
+ * Returns a pooled coinbase paying minerAddress for the block after
+ * pindexPrev with CoinbasePoolFeeBucket(nFees) in fees, if one is ready. The
+ * request tells the pool which address and fee levels to prepare.
+ */
+std::optional<CMutableTransaction> GetPooledCoinbase(
+    const MinerAddress& minerAddress,
+    const CBlockIndex* pindexPrev,
+    CAmount nFees);
+
+#endif // BITCOIN_COINBASEPOOL_H
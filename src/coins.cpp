@@ -84,6 +84,7 @@ bool CCoinsViewBacked::BatchWrite(CCoinsMap &mapCoins,
                             historyCacheMap, cacheSaplingSubtrees, cacheOrchardSubtrees);
 }
 bool CCoinsViewBacked::GetStats(CCoinsStats &stats) const { return base->GetStats(stats); }
+size_t CCoinsViewBacked::DatabaseMemoryUsage() const { return base->DatabaseMemoryUsage(); }
 
 SaltedTxidHasher::SaltedTxidHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
 
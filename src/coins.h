@@ -442,6 +442,9 @@ public:
     //! Calculate statistics about the unspent transaction output set
     virtual bool GetStats(CCoinsStats &stats) const = 0;
 
+    //! Memory held by the underlying database, in bytes
+    virtual size_t DatabaseMemoryUsage() const { return 0; }
+
     //! As we use CCoinsViews polymorphically, have a virtual destructor
     virtual ~CCoinsView() {}
 };
@@ -579,6 +582,7 @@ public:
                     SubtreeCache &cacheSaplingSubtrees,
                     SubtreeCache &cacheOrchardSubtrees);
     bool GetStats(CCoinsStats &stats) const;
+    size_t DatabaseMemoryUsage() const;
 };
 
 
@@ -13,6 +13,8 @@
 #include "uint256.h"
 
 uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated = nullptr);
+std::vector<uint256> ComputeMerkleBranch(const std::vector<uint256>& leaves, uint32_t position);
+uint256 ComputeMerkleRootFromBranch(const uint256& leaf, const std::vector<uint256>& branch, uint32_t position);
 
 /*
  * Compute the Merkle root of the transactions in a block.
@@ -20,4 +22,11 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated = nullptr);
  */
 uint256 BlockMerkleRoot(const CBlock& block, bool* mutated = NULL);
 
+/*
+ * Compute the Merkle branch of the transaction at the given position in a
+ * block. A branch computed for the coinbase (position 0) stays valid when the
+ * coinbase changes, which lets miners update hashMerkleRoot in O(log n).
+ */
+std::vector<uint256> BlockMerkleBranch(const CBlock& block, uint32_t position);
+
 #endif // BITCOIN_CONSENSUS_MERKLE_H
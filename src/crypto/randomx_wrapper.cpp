@@ -4,8 +4,10 @@
 
 #include "randomx_wrapper.h"
 #include "randomx/randomx.h"
+#include "randomx/configuration.h"
 #include "util/system.h"
 
+#include <atomic>
 #include <mutex>
 #include <memory>
 #include <map>
@@ -39,6 +41,9 @@ static uint256 main_seed;
 static bool main_seed_set = false;
 static std::mutex main_seed_mutex;
 
+// Number of VMs alive across all threads
+static std::atomic<size_t> rx_vm_count{0};
+
 // Thread-local VMs mapped by seed hash
 struct ThreadLocalVM {
     std::map<uint256, randomx_vm*> vms;
@@ -47,6 +52,7 @@ struct ThreadLocalVM {
         for (auto& pair : vms) {
             if (pair.second) {
                 randomx_destroy_vm(pair.second);
+                rx_vm_count--;
             }
         }
         vms.clear();
@@ -111,6 +117,24 @@ static std::shared_ptr<CacheEntry> GetOrCreateCache(const uint256& seedhash)
     return entry;
 }
 
+size_t RandomX_CacheMemoryUsage()
+{
+    std::lock_guard<std::mutex> lock(cache_map_mutex);
+    return seed_caches.size() * RandomX_CacheSize();
+}
+
+size_t RandomX_VMMemoryUsage()
+{
+    // Each VM owns a scratchpad; its JIT code buffer is small next to it.
+    return rx_vm_count * (size_t)RANDOMX_SCRATCHPAD_L3;
+}
+
+size_t RandomX_CacheSize()
+{
+    // The cache is RANDOMX_ARGON_MEMORY Argon2 blocks of 1 KiB each.
+    return (size_t)RANDOMX_ARGON_MEMORY * 1024;
+}
+
 // Initialize RandomX
 void RandomX_Init()
 {
@@ -214,6 +238,7 @@ bool RandomX_Hash_WithSeed(const void* seedhash, size_t seedhashSize,
         }
 
         rxVM_thread.vms[seed] = vm;
+        rx_vm_count++;
         vm_it = rxVM_thread.vms.find(seed);
     }
 
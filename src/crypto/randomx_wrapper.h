@@ -107,4 +107,20 @@ void RandomX_Init();
  */
 void RandomX_Shutdown();
 
+/**
+ * Memory currently held by the per-seed RandomX caches, in bytes.
+ */
+size_t RandomX_CacheMemoryUsage();
+
+/**
+ * Memory currently held by the RandomX VMs of all threads, in bytes. Hashing
+ * runs in light mode, so there is no dataset.
+ */
+size_t RandomX_VMMemoryUsage();
+
+/**
+ * Memory needed by one RandomX cache, in bytes.
+ */
+size_t RandomX_CacheSize();
+
 #endif // BITCOIN_CRYPTO_RANDOMX_WRAPPER_H
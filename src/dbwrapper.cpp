@@ -85,6 +85,16 @@ bool CDBWrapper::IsEmpty()
     return !(it->Valid());
 }
 
+size_t CDBWrapper::DynamicMemoryUsage() const
+{
+    std::string memory;
+    if (!pdb->GetProperty("leveldb.approximate-memory-usage", &memory)) {
+        LogPrint("db", "Failed to get approximate-memory-usage property\n");
+        return 0;
+    }
+    return stoul(memory);
+}
+
 CDBIterator::~CDBIterator() { delete piter; }
 bool CDBIterator::Valid() { return piter->Valid(); }
 void CDBIterator::SeekToFirst() { piter->SeekToFirst(); }
@@ -256,6 +256,12 @@ public:
      * Return true if the database managed by this class contains no entries.
      */
     bool IsEmpty();
+
+    /**
+     * Return LevelDB's estimate of the memory held by its memtables and block
+     * cache, in bytes.
+     */
+    size_t DynamicMemoryUsage() const;
 };
 
 #endif // BITCOIN_DBWRAPPER_H
@@ -0,0 +1,53 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include <gtest/gtest.h>
+
+#include "memorybudget.h"
+#include "txdb.h"
+
+static const int64_t MiB = 1 << 20;
+
+TEST(MemoryBudgetTests, UnknownAvailableMemoryKeepsDefault)
+{
+    EXPECT_EQ(ComputeCoinCacheLimit(true, -1, 100 * MiB, 300 * MiB, 0), 300 * MiB);
+    EXPECT_EQ(ComputeCoinCacheLimit(false, -1, 100 * MiB, 300 * MiB, 0), 300 * MiB);
+}
+
+TEST(MemoryBudgetTests, GrowsDuringInitialBlockDownload)
+{
+    // 4 GiB free plus the 1 GiB already in the cache, minus the reservation
+    // and the safety margin.
+    int64_t nLimit = ComputeCoinCacheLimit(true, 4096 * MiB, 1024 * MiB, 300 * MiB, 256 * MiB);
+    EXPECT_EQ(nLimit, 5120 * MiB - 256 * MiB - MEMORY_GOVERNOR_SAFETY_MARGIN);
+
+    // Capped on machines with a lot of memory.
+    EXPECT_EQ(ComputeCoinCacheLimit(true, 1024 * 1024 * MiB, 0, 300 * MiB, 0), MAX_AUTO_COIN_CACHE);
+
+    // Never below the -dbcache default, even when memory is short.
+    EXPECT_EQ(ComputeCoinCacheLimit(true, 100 * MiB, 0, 300 * MiB, 256 * MiB), 300 * MiB);
+}
+
+TEST(MemoryBudgetTests, ShrinksAfterCatchUp)
+{
+    EXPECT_EQ(ComputeCoinCacheLimit(false, 4096 * MiB, 3000 * MiB, 300 * MiB, 256 * MiB), 300 * MiB);
+
+    // Under memory pressure the cache goes below the default...
+    int64_t nLimit = ComputeCoinCacheLimit(false, 100 * MiB, 700 * MiB, 300 * MiB, 80 * MiB);
+    EXPECT_EQ(nLimit, 800 * MiB - 80 * MiB - MEMORY_GOVERNOR_SAFETY_MARGIN);
+
+    // ...but not below the -dbcache minimum.
+    EXPECT_EQ(ComputeCoinCacheLimit(false, 0, 0, 300 * MiB, 80 * MiB), nMinDbCache * MiB);
+}
+
+TEST(MemoryBudgetTests, ScalesMempoolCostLimitToBytes)
+{
+    // A nearly empty mempool assumes one byte per cost unit.
+    EXPECT_EQ(MempoolMemoryLimit(80000000, 0, 0), 80000000);
+    EXPECT_EQ(MempoolMemoryLimit(80000000, 3 * MIN_MEMPOOL_COST_SAMPLE, MIN_MEMPOOL_COST_SAMPLE - 1), 80000000);
+
+    // Otherwise the limit is scaled by the usage per cost unit.
+    EXPECT_EQ(MempoolMemoryLimit(80000000, 3 * MIN_MEMPOOL_COST_SAMPLE, MIN_MEMPOOL_COST_SAMPLE), 240000000);
+    EXPECT_EQ(MempoolMemoryLimit(80000000, MIN_MEMPOOL_COST_SAMPLE, 2 * MIN_MEMPOOL_COST_SAMPLE), 40000000);
+}
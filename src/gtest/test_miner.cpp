@@ -2,7 +2,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "chain.h"
 #include "chainparams.h"
+#include "coinbasepool.h"
 #include "key.h"
 #include "miner.h"
 #include "util/system.h"
@@ -122,4 +124,164 @@ TEST(Miner, GetMinerAddress) {
         EXPECT_FALSE(IsValidMinerAddress(minerAddress));
     }
 }
+
+TEST(Miner, CoinbasePoolFeeBucket) {
+    EXPECT_EQ(CoinbasePoolFeeBucket(0), 0);
+    EXPECT_EQ(CoinbasePoolFeeBucket(-5), 0);
+    EXPECT_EQ(CoinbasePoolFeeBucket(99), 99);
+    EXPECT_EQ(CoinbasePoolFeeBucket(100), 100);
+    EXPECT_EQ(CoinbasePoolFeeBucket(10000), 10000);
+    EXPECT_EQ(CoinbasePoolFeeBucket(12345), 12000);
+    EXPECT_EQ(CoinbasePoolFeeBucket(99999), 99000);
+
+    // A pooled coinbase never pays more than the fees, and forgoes less than
+    // a tenth of them.
+    for (CAmount nFees = 1; nFees < 10 * COIN; nFees = nFees * 3 + 7) {
+        CAmount nBucket = CoinbasePoolFeeBucket(nFees);
+        EXPECT_LE(nBucket, nFees);
+        EXPECT_LT((nFees - nBucket) * 10, nFees);
+    }
+}
+
+// Links blocks[i] to blocks[i - 1], starting at height nStart on top of pprev.
+static void BuildCoinbasePoolChain(std::vector<CBlockIndex>& blocks, CBlockIndex* pprev, int nStart, int nWork)
+{
+    for (size_t i = 0; i < blocks.size(); i++) {
+        blocks[i].pprev = i ? &blocks[i - 1] : pprev;
+        blocks[i].nHeight = nStart + i;
+        blocks[i].nChainWork = arith_uint256(nWork * (nStart + i));
+        blocks[i].BuildSkip();
+    }
+}
+
+static MinerAddress CoinbasePoolAddress()
+{
+    return boost::shared_ptr<CReserveScript>(new CReserveScript());
+}
+
+static CMutableTransaction ProveCoinbasePoolJob(CCoinbasePool& pool, const CCoinbasePool::Job& job)
+{
+    CMutableTransaction mtx;
+    mtx.nLockTime = job.key.first;
+    pool.AddCoinbase(job, mtx);
+    return mtx;
+}
+
+TEST(Miner, CoinbasePoolHit) {
+    std::vector<CBlockIndex> blocks(20);
+    BuildCoinbasePoolChain(blocks, nullptr, 0, 1);
+    MinerAddress address = CoinbasePoolAddress();
+
+    CCoinbasePool pool;
+    pool.SetEnabled(true);
+    EXPECT_FALSE(pool.NextJob().has_value());
+
+    // The first request misses and tells the pool what to prepare.
+    EXPECT_FALSE(pool.Get(address, &blocks[10], 0).has_value());
+    auto job = pool.NextJob();
+    ASSERT_TRUE(job.has_value());
+    EXPECT_EQ(job->key, CCoinbasePool::Key(11, 0));
+    ProveCoinbasePoolJob(pool, *job);
+
+    auto cb = pool.Get(address, &blocks[10], 0);
+    ASSERT_TRUE(cb.has_value());
+    EXPECT_EQ(cb->nLockTime, 11);
+
+    // Fees are looked up by bucket.
+    EXPECT_FALSE(pool.Get(address, &blocks[10], 12345).has_value());
+    job = pool.NextJob();
+    ASSERT_TRUE(job.has_value());
+    EXPECT_EQ(job->key, CCoinbasePool::Key(11, 12000));
+    ProveCoinbasePoolJob(pool, *job);
+    EXPECT_TRUE(pool.Get(address, &blocks[10], 12999).has_value());
+
+    // Coinbases for heights that have been mined are dropped, the ones
+    // above the new tip are kept.
+    while ((job = pool.NextJob())) {
+        ProveCoinbasePoolJob(pool, *job);
+    }
+    EXPECT_EQ(pool.Size(), 4);
+    pool.UpdatedBlockTip(&blocks[11]);
+    EXPECT_EQ(pool.Size(), 2);
+    cb = pool.Get(address, &blocks[11], 0);
+    ASSERT_TRUE(cb.has_value());
+    EXPECT_EQ(cb->nLockTime, 12);
+
+    // A disabled pool has nothing to offer.
+    pool.SetEnabled(false);
+    EXPECT_FALSE(pool.Get(address, &blocks[11], 0).has_value());
+    EXPECT_EQ(pool.Size(), 0);
+}
+
+TEST(Miner, CoinbasePoolReorgReset) {
+    std::vector<CBlockIndex> blocks(20);
+    BuildCoinbasePoolChain(blocks, nullptr, 0, 1);
+    std::vector<CBlockIndex> fork(5);
+    BuildCoinbasePoolChain(fork, &blocks[10], 11, 2);
+    MinerAddress address = CoinbasePoolAddress();
+
+    CCoinbasePool pool;
+    pool.SetEnabled(true);
+    EXPECT_FALSE(pool.Get(address, &blocks[11], 0).has_value());
+    std::optional<CCoinbasePool::Job> job;
+    while ((job = pool.NextJob())) {
+        ProveCoinbasePoolJob(pool, *job);
+    }
+    EXPECT_EQ(pool.Size(), 2);
+
+    // A notification for an older tip, delivered after a template moved the
+    // pool forward, is ignored.
+    pool.UpdatedBlockTip(&blocks[10]);
+    pool.UpdatedBlockTip(&blocks[11]);
+    EXPECT_EQ(pool.Size(), 2);
+    EXPECT_TRUE(pool.Get(address, &blocks[11], 0).has_value());
+
+    // A reorg throws the pool away, including a proof that was in flight.
+    job = pool.NextJob();
+    EXPECT_FALSE(job.has_value());
+    pool.UpdatedBlockTip(&blocks[12]);
+    job = pool.NextJob();
+    ASSERT_TRUE(job.has_value());
+    EXPECT_EQ(job->key, CCoinbasePool::Key(14, 0));
+    pool.UpdatedBlockTip(&fork[1]);
+    EXPECT_EQ(pool.Size(), 0);
+    ProveCoinbasePoolJob(pool, *job);
+    EXPECT_EQ(pool.Size(), 0);
+    EXPECT_FALSE(pool.Get(address, &fork[1], 0).has_value());
+
+    job = pool.NextJob();
+    ASSERT_TRUE(job.has_value());
+    EXPECT_EQ(job->key, CCoinbasePool::Key(13, 0));
+}
+
+TEST(Miner, CoinbasePoolMinerAddressChange) {
+    std::vector<CBlockIndex> blocks(20);
+    BuildCoinbasePoolChain(blocks, nullptr, 0, 1);
+    MinerAddress address1 = CoinbasePoolAddress();
+    MinerAddress address2 = CoinbasePoolAddress();
+
+    CCoinbasePool pool;
+    pool.SetEnabled(true);
+    EXPECT_FALSE(pool.Get(address1, &blocks[10], 0).has_value());
+    auto job = pool.NextJob();
+    ASSERT_TRUE(job.has_value());
+    ProveCoinbasePoolJob(pool, *job);
+    EXPECT_TRUE(pool.Get(address1, &blocks[10], 0).has_value());
+    auto oldJob = pool.NextJob();
+    ASSERT_TRUE(oldJob.has_value());
+
+    // Coinbases paying the old address are thrown away, and so is a proof
+    // for it that completes afterwards.
+    EXPECT_FALSE(pool.Get(address2, &blocks[10], 0).has_value());
+    EXPECT_EQ(pool.Size(), 0);
+    ProveCoinbasePoolJob(pool, *oldJob);
+    EXPECT_EQ(pool.Size(), 0);
+
+    job = pool.NextJob();
+    ASSERT_TRUE(job.has_value());
+    EXPECT_TRUE(std::get<boost::shared_ptr<CReserveScript>>(job->address) ==
+                std::get<boost::shared_ptr<CReserveScript>>(address2));
+    ProveCoinbasePoolJob(pool, *job);
+    EXPECT_TRUE(pool.Get(address2, &blocks[10], 0).has_value());
+}
 #endif // ENABLE_MINING
@@ -123,3 +123,26 @@ TEST(PoW, MinDifficultyRules) {
     EXPECT_EQ(GetNextWorkRequired(&blocks[lastBlk], &next, params),
               UintToArith256(params.powLimit).GetCompact());
 }
+
+TEST(PoW, ClaimedProofOfWork) {
+    SelectParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = Params().GetConsensus();
+
+    CBlockHeader header;
+    header.nBits = UintToArith256(params.powLimit).GetCompact();
+
+    // A claimed hash below the target
+    uint256 claimed = ArithToUint256(UintToArith256(params.powLimit) >> 1);
+    header.nSolution.assign(claimed.begin(), claimed.end());
+    EXPECT_TRUE(CheckClaimedProofOfWork(&header, params));
+
+    // A claimed hash above the target
+    claimed = ArithToUint256(~arith_uint256());
+    header.nSolution.assign(claimed.begin(), claimed.end());
+    EXPECT_FALSE(CheckClaimedProofOfWork(&header, params));
+
+    // A valid claim under an out-of-range target
+    header.nSolution.assign(32, 0);
+    header.nBits = 0;
+    EXPECT_FALSE(CheckClaimedProofOfWork(&header, params));
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include <gtest/gtest.h>
+
+#include "primitives/block.h"
+#include "templatecache.h"
+
+static CTransaction MakeTx(uint32_t nLockTime, bool fCoinBase)
+{
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    if (fCoinBase) {
+        mtx.vin[0].prevout.SetNull();
+        mtx.vin[0].scriptSig = CScript() << nLockTime << OP_0;
+    } else {
+        mtx.vin[0].prevout = COutPoint(uint256S("0x01"), nLockTime);
+    }
+    mtx.vout.resize(1);
+    mtx.vout[0].nValue = 1000;
+    mtx.nLockTime = nLockTime;
+    return mtx;
+}
+
+static CBlock MakeBlock(const uint256& hashPrevBlock, uint32_t nCoinbaseNonce, std::vector<uint32_t> txs)
+{
+    CBlock block;
+    block.hashPrevBlock = hashPrevBlock;
+    block.vtx.push_back(MakeTx(nCoinbaseNonce, true));
+    for (uint32_t n : txs) {
+        block.vtx.push_back(MakeTx(n, false));
+    }
+    return block;
+}
+
+TEST(TemplateCacheTests, KeyIgnoresCoinbase)
+{
+    uint256 prev = uint256S("0xaa");
+    CBlock block = MakeBlock(prev, 1, {1, 2, 3});
+    EXPECT_EQ(BlockTemplateKey(block), BlockTemplateKey(MakeBlock(prev, 2, {1, 2, 3})));
+
+    // A different parent, a different transaction set or order is a different template.
+    EXPECT_NE(BlockTemplateKey(block), BlockTemplateKey(MakeBlock(uint256S("0xbb"), 1, {1, 2, 3})));
+    EXPECT_NE(BlockTemplateKey(block), BlockTemplateKey(MakeBlock(prev, 1, {1, 2})));
+    EXPECT_NE(BlockTemplateKey(block), BlockTemplateKey(MakeBlock(prev, 1, {1, 3, 2})));
+}
+
+TEST(TemplateCacheTests, RemembersRecentTemplates)
+{
+    uint256 prev = uint256S("0xcc");
+    CBlock first = MakeBlock(prev, 1, {100});
+    EXPECT_FALSE(IsFromRememberedTemplate(first));
+
+    RememberBlockTemplate(first);
+    // The miner rolled the extra nonce.
+    EXPECT_TRUE(IsFromRememberedTemplate(MakeBlock(prev, 7, {100})));
+    EXPECT_FALSE(IsFromRememberedTemplate(MakeBlock(prev, 1, {101})));
+
+    // Old templates are forgotten.
+    for (uint32_t n = 0; n < MAX_REMEMBERED_TEMPLATES; n++) {
+        RememberBlockTemplate(MakeBlock(prev, 1, {200 + n}));
+    }
+    EXPECT_FALSE(IsFromRememberedTemplate(first));
+    EXPECT_TRUE(IsFromRememberedTemplate(MakeBlock(prev, 1, {200})));
+}
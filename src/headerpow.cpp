@@ -0,0 +1,109 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "headerpow.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "consensus/validation.h"
+#include "main.h"
+#include "pow.h"
+#include "sync.h"
+#include "util/system.h"
+#include "util/time.h"
+#include "warnings.h"
+
+#include <utility>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+#include <rust/metrics.h>
+
+namespace {
+
+boost::mutex mutexDeferred;
+boost::condition_variable condDeferred;
+bool fDeferredPending = false;
+
+}
+
+void NotifyDeferredPoWHeaders()
+{
+    boost::unique_lock<boost::mutex> lock(mutexDeferred);
+    fDeferredPending = true;
+    condDeferred.notify_one();
+}
+
+void ThreadVerifyDeferredPoW()
+{
+    const CChainParams& chainparams = Params();
+    const Consensus::Params& consensusParams = chainparams.GetConsensus();
+    while (true) {
+        {
+            boost::unique_lock<boost::mutex> lock(mutexDeferred);
+            while (!fDeferredPending) {
+                condDeferred.wait(lock);
+            }
+            fDeferredPending = false;
+        }
+
+        while (true) {
+            boost::this_thread::interruption_point();
+
+            // Headers never leave the index while the node runs, and the
+            // fields CheckRandomXSolution reads never change.
+            std::vector<std::pair<CBlockIndex*, CBlockHeader>> vBatch;
+            {
+                LOCK(cs_main);
+                for (CBlockIndex* pindex : GetDeferredPoWHeaders(DEFERRED_POW_BATCH_SIZE)) {
+                    vBatch.emplace_back(pindex, pindex->GetBlockHeader());
+                }
+            }
+            if (vBatch.empty()) {
+                break;
+            }
+
+            int64_t nStart = GetTimeMicros();
+            std::vector<bool> vValid;
+            vValid.reserve(vBatch.size());
+            for (const auto& item : vBatch) {
+                vValid.push_back(CheckRandomXSolution(&item.second, consensusParams, item.first->pprev));
+            }
+            LogPrint("bench", "%s: checked %u headers up to height %d in %.2fms\n", __func__,
+                vBatch.size(), vBatch.back().first->nHeight, (GetTimeMicros() - nStart) * 0.001);
+
+            bool fInvalidated = false;
+            CValidationState state;
+            {
+                LOCK(cs_main);
+                for (size_t i = 0; i < vBatch.size(); i++) {
+                    CBlockIndex* pindex = vBatch[i].first;
+                    if (!(pindex->nStatus & BLOCK_POW_UNVERIFIED)) {
+                        // ConnectTip got there first.
+                        continue;
+                    }
+                    FinishDeferredPoWCheck(pindex, vValid[i]);
+                    if (vValid[i] || (pindex->nStatus & BLOCK_FAILED_MASK)) {
+                        continue;
+                    }
+
+                    LogPrintf("ERROR: %s: header %s at height %d has an invalid RandomX solution\n",
+                        __func__, pindex->GetBlockHash().ToString(), pindex->nHeight);
+                    MetricsIncrementCounter("zcashd.headerpow.invalid");
+                    if (IsAssumedValidHeader(consensusParams, pindex)) {
+                        SetMiscWarning(strprintf(
+                            _("Warning: The block assumed valid with -assumevalid has an invalid proof of work at height %d; check the -assumevalid setting."),
+                            pindex->nHeight), GetTime());
+                    }
+                    InvalidateBlock(state, chainparams, pindex);
+                    fInvalidated = true;
+                }
+            }
+            if (fInvalidated && state.IsValid()) {
+                ActivateBestChain(state, chainparams);
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_HEADERPOW_H
+#define BITCOIN_HEADERPOW_H
+
+#include <stddef.h>
+
+/**
+ * Deferred proof-of-work checks for headers below -assumevalid.
+ *
+ * Computing the RandomX hash of every header is the slowest part of header
+ * sync. During initial block download, until the -assumevalid block is in the
+ * index, AcceptBlockHeader only checks that the hash a header claims satisfies
+ * its nBits, and marks the header BLOCK_POW_UNVERIFIED. Once the assumed-valid
+ * block arrives with at least nMinimumChainWork, its hash commits to all of its
+ * ancestors, so their claims need not be checked before their blocks are
+ * connected. Any other unverified header has its RandomX solution checked in
+ * ConnectTip.
+ *
+ * With -verifydeferredpow, a background thread checks the unverified headers
+ * in height order as they arrive, and invalidates a header whose solution is
+ * wrong together with its descendants. An invalid header on the assumed-valid
+ * chain means -assumevalid is wrong, and is raised as a warning.
+ *
+ * At most MAX_DEFERRED_POW_HEADERS headers are deferred, and at most
+ * MAX_DEFERRED_POW_HEADERS_PER_PEER from one peer are pending at a time, which
+ * bounds what a peer can add to the index with headers that carry no work.
+ * One in DEFERRED_POW_SPOT_CHECK_INTERVAL headers is checked on receipt anyway,
+ * and a peer whose header fails a check is banned. Unverified headers and
+ * their descendants are not written to the block index database until their
+ * check passes, so a restart drops them and they are downloaded again.
+ */
+
+/** Default for -verifydeferredpow. */
+static const bool DEFAULT_VERIFY_DEFERRED_POW = true;
+/** Number of headers checked between two acquisitions of cs_main. */
+static const size_t DEFERRED_POW_BATCH_SIZE = 64;
+
+/** Wakes the verifier up after headers were deferred. */
+void NotifyDeferredPoWHeaders();
+
+/** Background thread that checks deferred headers. */
+void ThreadVerifyDeferredPoW();
+
+#endif // BITCOIN_HEADERPOW_H
@@ -12,7 +12,9 @@
 #include "init.h"
 #include "addrman.h"
 #include "amount.h"
+#include "chainaudit.h"
 #include "checkpoints.h"
+#include "coinbasepool.h"
 #include "compat.h"
 #include "compat/sanity.h"
 #include "consensus/upgrades.h"
@@ -20,6 +22,7 @@
 #include "deprecation.h"
 #include "experimental_features.h"
 #include "fs.h"
+#include "headerpow.h"
 #include "httpserver.h"
 #include "httprpc.h"
 #include "key.h"
@@ -27,6 +30,7 @@
 #include "key_io.h"
 #endif
 #include "main.h"
+#include "memorybudget.h"
 #include "mempool_limit.h"
 #include "metrics.h"
 #include "miner.h"
@@ -37,6 +41,8 @@
 #include "script/standard.h"
 #include "script/sigcache.h"
 #include "scheduler.h"
+#include "templatecache.h"
+#include "threadbudget.h"
 #include "txdb.h"
 #include "torcontrol.h"
 #include "ui_interface.h"
@@ -44,6 +50,7 @@
 #include "util/moneystr.h"
 #include "validationinterface.h"
 #ifdef ENABLE_WALLET
+#include "wallet/rescan.h"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 #endif
@@ -214,10 +221,13 @@ void Shutdown()
 #endif
 #ifdef ENABLE_MINING
     GenerateBitcoins(false, 0, Params());
+    StopCoinbasePool();
 #endif
     StopNode();
     StopTorControl();
     UnregisterNodeSignals(GetNodeSignals());
+    FlushBackgroundCallbacks();
+    UnregisterBackgroundSignalScheduler();
 
     {
         LOCK(cs_main);
@@ -329,6 +339,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-alerts", strprintf(_("Receive and display P2P network alerts (default: %u)"), DEFAULT_ALERTS));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
     strUsage += HelpMessageOpt("-allowdeprecated=<feature>", strprintf(_("Explicitly allow the use of the specified deprecated feature. Multiple instances of this parameter are permitted; values for <feature> must be selected from among {%s}"), GetAllowableDeprecatedFeatures()));
+    strUsage += HelpMessageOpt("-assumevalid=<hex>", _("If this block is in the chain, assume that it and its ancestors have a valid proof of work, and defer the RandomX check of their headers during initial block download (0 to check every header, default: the last checkpoint above genesis)"));
+    strUsage += HelpMessageOpt("-auditchain", strprintf(_("Continuously re-verify the stored blocks and undo data of the active chain in a low-priority background thread (default: %u)"), DEFAULT_AUDIT_CHAIN));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
     if (showDebug)
         strUsage += HelpMessageOpt("-blocksonly", strprintf(_("Whether to reject transactions from network peers. Automatic broadcast and rebroadcast of any transactions from inbound peers is disabled, unless '-whitelistforcerelay' is '1', in which case whitelisted peers' transactions will be relayed. RPC transactions are not affected. (default: %u)"), DEFAULT_BLOCKSONLY));
@@ -343,7 +355,8 @@ std::string HelpMessage(HelpMessageMode mode)
     }
     strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory (this path cannot use '~')"));
     strUsage += HelpMessageOpt("-paramsdir=<dir>", _("Specify Juno Cash network parameters directory"));
-    strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
+    strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d). "
+        "\"auto\" sizes the in-memory UTXO set from available memory during initial block download and shrinks it to the default afterwards"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
     strUsage += HelpMessageOpt("-debuglogfile=<file>", strprintf(_("Specify location of debug log file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)"), DEFAULT_DEBUGLOGFILE));
     strUsage += HelpMessageOpt("-exportdir=<dir>", _("Specify directory to be used when exporting data"));
     strUsage += HelpMessageOpt("-ibdskiptxverification", strprintf(_("Skip transaction verification during initial block download up to the last checkpoint height. Incompatible with flags that disable checkpoints. (default = %u)"), DEFAULT_IBD_SKIP_TX_VERIFICATION));
@@ -351,6 +364,11 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
+    strUsage += HelpMessageOpt("-threadbudget=<n>", strprintf(_("Split <n> cores between the script verification, proof verification, RPC and mining threads, "
+        "giving validation priority (0 = disabled, <0 = leave that many cores free, default: %d)"), DEFAULT_THREAD_BUDGET));
+    strUsage += HelpMessageOpt("-threadshare=<pool>:<percent>", _("Percentage of -threadbudget given to a thread pool (scriptcheck, rayon, http, miner). "
+        "Can be specified multiple times. Explicit -par, -rpcthreads and -genproclimit take precedence"));
+    strUsage += HelpMessageOpt("-verifydeferredpow", strprintf(_("Check the RandomX solutions of headers deferred by -assumevalid in a background thread (default: %u)"), DEFAULT_VERIFY_DEFERRED_POW));
 #ifndef WIN32
     strUsage += HelpMessageOpt("-pid=<file>", strprintf(_("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)"), BITCOIN_PID_FILENAME));
 #endif
@@ -436,6 +454,7 @@ std::string HelpMessage(HelpMessageMode mode)
     if (showDebug)
     {
         strUsage += HelpMessageOpt("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. (default: %u)", Params(CBaseChainParams::MAIN).DefaultConsistencyChecks()));
+        strUsage += HelpMessageOpt("-templatefastpath", strprintf("Connect blocks built from our own block templates without re-verifying their transactions, and verify them in the background instead (default: %u)", DEFAULT_TEMPLATE_FAST_PATH));
         strUsage += HelpMessageOpt("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", Params(CBaseChainParams::MAIN).DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED));
         strUsage += HelpMessageOpt("-disablesafemode", strprintf("Disable safemode, override a real safe mode event (default: %u)", DEFAULT_DISABLE_SAFEMODE));
@@ -501,6 +520,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-genproclimit=<n>", strprintf(_("Set the number of threads for coin generation if enabled (-1 = all cores, default: %d)"), DEFAULT_GENERATE_THREADS));
     strUsage += HelpMessageOpt("-equihashsolver=<name>", _("Specify the Equihash solver to be used if enabled (default: \"default\")"));
     strUsage += HelpMessageOpt("-mineraddress=<addr>", _("Send mined coins to a specific single address"));
+    strUsage += HelpMessageOpt("-coinbasepool", _("Prove shielded coinbase transactions for the next blocks in the background when -mineraddress is a shielded address (default: 1, except on regtest)"));
     strUsage += HelpMessageOpt("-minetolocalwallet", strprintf(
             _("Require that mined blocks use a coinbase address in the local wallet (default: %u)"),
  #ifdef ENABLE_WALLET
@@ -1065,8 +1085,16 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     std::set_new_handler(new_handler_terminate);
 
-    // Set up global Rayon threadpool.
-    init::rayon_threadpool();
+    // Split the available cores between the thread pools, if requested.
+    {
+        std::string strError;
+        if (!InitThreadBudget(GetNumCores(), strError)) {
+            return InitError(strError);
+        }
+    }
+
+    // Set up global Rayon threadpool (0 = one thread per core).
+    init::rayon_threadpool(ThreadBudgetFor(ThreadPool::RAYON, 0));
 
     // ********************************************************* Step 2: parameter interactions
     const CChainParams& chainparams = Params();
@@ -1157,8 +1185,19 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     fIBDSkipTxVerification = GetBoolArg("-ibdskiptxverification", DEFAULT_IBD_SKIP_TX_VERIFICATION);
     fCheckpointsEnabled = GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
 
+    // Juno Cash: the genesis checkpoint does not cover any headers.
+    uint256 hashDefaultAssumeValid;
+    const MapCheckpoints& checkpoints = chainparams.Checkpoints().mapCheckpoints;
+    if (fCheckpointsEnabled && !checkpoints.empty() && checkpoints.rbegin()->first > 0) {
+        hashDefaultAssumeValid = checkpoints.rbegin()->second;
+    }
+    hashAssumeValid = uint256S(GetArg("-assumevalid", hashDefaultAssumeValid.GetHex()));
+    if (!hashAssumeValid.IsNull()) {
+        LogPrintf("Assuming ancestors of block %s have a valid proof of work\n", hashAssumeValid.GetHex());
+    }
+
     // -par=0 means autodetect, but nScriptCheckThreads==0 means no concurrency
-    nScriptCheckThreads = GetArg("-par", DEFAULT_SCRIPTCHECK_THREADS);
+    nScriptCheckThreads = GetPoolThreadsArg(ThreadPool::SCRIPT_CHECK, "-par", DEFAULT_SCRIPTCHECK_THREADS);
     if (nScriptCheckThreads <= 0)
         nScriptCheckThreads += GetNumCores();
     if (nScriptCheckThreads <= 1)
@@ -1512,29 +1551,39 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     LogPrintf("Using at most %i connections (%i file descriptors available)\n", nMaxConnections, nFD);
     std::ostringstream strErrors;
 
-    // Initialize the validity caches. We currently have three:
+    // Initialize the validity caches. We currently have four:
     // - Transparent signature validity.
+    // - Transparent script execution (whole transactions).
     // - Sapling bundle validity.
     // - Orchard bundle validity.
-    // Assign half of the cap to transparent signatures, and split the rest
-    // between Sapling and Orchard bundles.
+    // Split half of the cap between transparent signatures and script
+    // execution, and the rest between Sapling and Orchard bundles.
     size_t nMaxCacheSize = GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
     if (nMaxCacheSize <= 0) {
         return InitError(strprintf(_("-maxsigcachesize must be at least 1")));
     }
-    InitSignatureCache(nMaxCacheSize / 2);
+    InitSignatureCache(nMaxCacheSize / 4);
+    InitScriptExecutionCache(nMaxCacheSize / 4);
     bundlecache::init(nMaxCacheSize / 4);
 
+    LogPrintf("Thread budget: %s\n", ThreadBudgetToString());
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
         for (int i=0; i<nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        // The transactions of large blocks are hashed on the same threads.
+        SetTransactionHashRunner(RunOnScriptCheckQueue);
     }
+    threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "templateaudit", &ThreadTemplateBlockAudit));
 
     // Start the lightweight task scheduler thread
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, &scheduler);
     threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
 
+    RegisterBackgroundSignalScheduler(scheduler);
+
+    scheduler.scheduleEvery(&SampleThreadPoolUtilization, THREAD_POOL_SAMPLE_INTERVAL);
+
     // Count uptime
     MarkStartTime();
 
@@ -1743,7 +1792,8 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     fs::create_directories(GetDataDir() / "blocks");
 
     // cache size calculations
-    int64_t nTotalCache = (GetArg("-dbcache", nDefaultDbCache) << 20);
+    bool fAutoDbCache = GetArg("-dbcache", "") == "auto";
+    int64_t nTotalCache = ((fAutoDbCache ? nDefaultDbCache : GetArg("-dbcache", nDefaultDbCache)) << 20);
     nTotalCache = std::max(nTotalCache, nMinDbCache << 20); // total cache cannot be less than nMinDbCache
     nTotalCache = std::min(nTotalCache, nMaxDbCache << 20); // total cache cannot be greater than nMaxDbcache
     int64_t nBlockTreeDBCache = nTotalCache / 8;
@@ -1765,7 +1815,9 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
-    LogPrintf("* Using %.1fMiB for in-memory UTXO set\n", nCoinCacheUsage * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for in-memory UTXO set%s\n", nCoinCacheUsage * (1.0 / 1024 / 1024),
+        fAutoDbCache ? " (adjusted to available memory during initial block download)" : "");
+    InitMemoryGovernor(fAutoDbCache, nBlockTreeDBCache, nCoinDBCache, nCoinCacheUsage, mempoolTotalCostLimit);
 
     bool clearWitnessCaches = false;
 
@@ -2019,6 +2071,11 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
         //   argument is not modified; in practice this means it is empty, and
         //   GenerateBitcoins() returns an error.
         GetMainSignals().AddressForMining.connect(GetMinerAddress);
+
+        if (GetBoolArg("-coinbasepool", !chainparams.MineBlocksOnDemand())) {
+            StartCoinbasePool();
+            threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "coinbasepool", &ThreadCoinbasePool));
+        }
     }
 #endif // ENABLE_MINING
 
@@ -2088,6 +2145,13 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
         return false;
     }
 
+    if (GetBoolArg("-auditchain", DEFAULT_AUDIT_CHAIN)) {
+        threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "chainaudit", &ThreadChainAudit));
+    }
+    if (GetBoolArg("-verifydeferredpow", DEFAULT_VERIFY_DEFERRED_POW)) {
+        threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "headerpow", &ThreadVerifyDeferredPoW));
+    }
+
     // ********************************************************* Step 11: start node
 
     if (!strErrors.str().empty())
@@ -2114,9 +2178,12 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     StartNode(threadGroup, scheduler);
 
+    scheduler.scheduleEvery(&UpdateMemoryBudgets, MEMORY_GOVERNOR_INTERVAL);
+    scheduler.scheduleEvery(&UpdateMemoryMetrics, MEMORY_GOVERNOR_INTERVAL);
+
 #ifdef ENABLE_MINING
     // Generate coins in the background
-    GenerateBitcoins(GetBoolArg("-gen", DEFAULT_GENERATE), GetArg("-genproclimit", DEFAULT_GENERATE_THREADS), chainparams);
+    GenerateBitcoins(GetBoolArg("-gen", DEFAULT_GENERATE), GetPoolThreadsArg(ThreadPool::MINER, "-genproclimit", DEFAULT_GENERATE_THREADS), chainparams);
 #endif
 
     // ********************************************************* Step 12: finished
@@ -2131,6 +2198,11 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
 
         // Run a thread to flush wallet periodically
         threadGroup.create_thread(boost::bind(&ThreadFlushWalletDB, boost::ref(pwalletMain->strWalletFile)));
+
+        // Run rescans queued by key imports, starting with any that the last
+        // shutdown interrupted
+        ResumeWalletRescan(pwalletMain);
+        threadGroup.create_thread(boost::bind(&ThreadWalletRescan, pwalletMain));
     }
 #endif
 
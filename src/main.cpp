@@ -18,8 +18,10 @@
 #include "consensus/merkle.h"
 #include "consensus/upgrades.h"
 #include "consensus/validation.h"
+#include "core_memusage.h"
 #include "deprecation.h"
 #include "experimental_features.h"
+#include "headerpow.h"
 #include "init.h"
 #include "key_io.h"
 #include "merkleblock.h"
@@ -28,6 +30,8 @@
 #include "policy/policy.h"
 #include "pow.h"
 #include "reverse_iterator.h"
+#include "templatecache.h"
+#include "threadbudget.h"
 #include "time.h"
 #include "txmempool.h"
 #include "ui_interface.h"
@@ -42,7 +46,11 @@
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <variant>
 
 #include <boost/algorithm/string/replace.hpp>
@@ -100,6 +108,7 @@ bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fCheckBlockIndex = false;
 bool fCheckpointsEnabled = DEFAULT_CHECKPOINTS_ENABLED;
 bool fIBDSkipTxVerification = DEFAULT_IBD_SKIP_TX_VERIFICATION;
+uint256 hashAssumeValid;
 bool fCoinbaseEnforcedShieldingEnabled = true;
 size_t nCoinCacheUsage = 5000 * 300;
 uint64_t nPruneTarget = 0;
@@ -221,8 +230,20 @@ namespace {
      * missing the data for the block.
      */
     set<CBlockIndex*, CBlockIndexWorkComparator> setBlockIndexCandidates;
-    /** Number of nodes with fSyncStarted. */
+
+    /**
+     * Protects the per-peer state in mapNodeState and the download
+     * bookkeeping shared between peers, so that sending messages to a peer
+     * that has nothing to download does not need cs_main. When both are
+     * needed, cs_main is taken first.
+     */
+    CCriticalSection cs_nodestate;
+    /** Number of nodes with fSyncStarted. Protected by cs_nodestate. */
     int nSyncStarted = 0;
+    /** Height of chainActive, for readers that do not hold cs_main. */
+    std::atomic<int> nActiveHeight{-1};
+    /** Time (in microseconds) after which SendMessages next offers the wallet to resend transactions. */
+    std::atomic<int64_t> nNextWalletBroadcast{0};
     /** All pairs A->B, where A (or one if its ancestors) misses transactions, but B has transactions.
       * Pruned nodes may have entries where B is missing data.
       */
@@ -248,7 +269,7 @@ namespace {
     /**
      * Sources of received blocks, saved to be able to send them reject
      * messages or ban them when processing happens afterwards. Protected by
-     * cs_main.
+     * cs_nodestate.
      */
     map<uint256, NodeId> mapBlockSource;
 
@@ -280,7 +301,7 @@ namespace {
     boost::scoped_ptr<CRollingBloomFilter> recentRejects;
     uint256 hashRecentRejectsChainTip;
 
-    /** Blocks that are in flight, and that are in the queue to be downloaded. Protected by cs_main. */
+    /** Blocks that are in flight, and that are in the queue to be downloaded. Protected by cs_nodestate. */
     struct QueuedBlock {
         uint256 hash;
         CBlockIndex* pindex;     //!< Optional.
@@ -290,10 +311,10 @@ namespace {
     };
     map<uint256, pair<NodeId, list<QueuedBlock>::iterator> > mapBlocksInFlight;
 
-    /** Number of blocks in flight with validated headers. */
+    /** Number of blocks in flight with validated headers. Protected by cs_nodestate. */
     int nQueuedValidatedHeaders = 0;
 
-    /** Number of preferable block download peers. */
+    /** Number of preferable block download peers. Protected by cs_nodestate. */
     int nPreferredDownload = 0;
 
     /** Dirty block index entries. */
@@ -302,10 +323,20 @@ namespace {
     /** Dirty block file entries. */
     set<int> setDirtyFileInfo;
 
-    /** Relay map, protected by cs_main. */
+    /** Headers marked BLOCK_POW_UNVERIFIED whose check is pending, lowest first. Protected by cs_main. */
+    set<pair<int, CBlockIndex*>> setDeferredPoWHeaders;
+    /** Number of headers deferred since startup, including those checked since. Protected by cs_main. */
+    size_t nDeferredPoWHeaders = 0;
+    /** Peer that sent each header in setDeferredPoWHeaders. Protected by cs_main. */
+    map<const CBlockIndex*, NodeId> mapDeferredPoWSource;
+    /** Number of headers in setDeferredPoWHeaders sent by each peer. Protected by cs_main. */
+    map<NodeId, size_t> mapDeferredPoWPerPeer;
+
+    CCriticalSection cs_mapRelay;
+    /** Relay map, protected by cs_mapRelay. */
     typedef std::map<uint256, std::shared_ptr<const CTransaction>> MapRelay;
     MapRelay mapRelay;
-    /** Expiration-time ordered list of (expire time, relay map entry) pairs, protected by cs_main). */
+    /** Expiration-time ordered list of (expire time, relay map entry) pairs, protected by cs_mapRelay. */
     std::deque<std::pair<int64_t, MapRelay::iterator>> vRelayExpiration;
 } // anon namespace
 
@@ -323,7 +354,7 @@ struct CBlockReject {
 };
 
 /**
- * Maintain validation-specific state about nodes, protected by cs_main, instead
+ * Maintain validation-specific state about nodes, protected by cs_nodestate, instead
  * by CNode's own locks. This simplifies asynchronous operation, where
  * processing of incoming data is done after the ProcessMessage call returns,
  * and we're no longer holding the node's locks.
@@ -372,11 +403,12 @@ struct CNodeState {
     }
 };
 
-/** Map maintaining per-node state. Requires cs_main. */
+/** Map maintaining per-node state. Requires cs_nodestate. */
 map<NodeId, CNodeState> mapNodeState;
 
-// Requires cs_main.
+// Requires cs_nodestate.
 CNodeState *State(NodeId pnode) {
+    AssertLockHeld(cs_nodestate);
     map<NodeId, CNodeState>::iterator it = mapNodeState.find(pnode);
     if (it == mapNodeState.end())
         return NULL;
@@ -389,6 +421,7 @@ int GetHeight()
     return chainActive.Height();
 }
 
+// Requires cs_nodestate.
 void UpdatePreferredDownload(CNode* node, CNodeState* state)
 {
     nPreferredDownload -= state->fPreferredDownload;
@@ -406,14 +439,14 @@ int64_t GetBlockTimeout(int64_t nTime, int nValidatedQueuedBefore, const Consens
 }
 
 void InitializeNode(NodeId nodeid, const CNode *pnode) {
-    LOCK(cs_main);
+    LOCK(cs_nodestate);
     CNodeState &state = mapNodeState.insert(std::make_pair(nodeid, CNodeState())).first->second;
     state.name = pnode->GetAddrName();
     state.address = pnode->addr;
 }
 
 void FinalizeNode(NodeId nodeid) {
-    LOCK(cs_main);
+    LOCK2(cs_main, cs_nodestate);
     CNodeState *state = State(nodeid);
 
     if (state->fSyncStarted)
@@ -431,7 +464,7 @@ void FinalizeNode(NodeId nodeid) {
     mapNodeState.erase(nodeid);
 }
 
-// Requires cs_main.
+// Requires cs_nodestate.
 // Returns a bool indicating whether we requested this block.
 bool MarkBlockAsReceived(const uint256& hash) {
     map<uint256, pair<NodeId, list<QueuedBlock>::iterator> >::iterator itInFlight = mapBlocksInFlight.find(hash);
@@ -448,7 +481,7 @@ bool MarkBlockAsReceived(const uint256& hash) {
     return false;
 }
 
-// Requires cs_main.
+// Requires cs_main and cs_nodestate.
 void MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const Consensus::Params& consensusParams, CBlockIndex *pindex = NULL) {
     CNodeState *state = State(nodeid);
     assert(state != NULL);
@@ -466,7 +499,7 @@ void MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const Consensus::Pa
     mapBlocksInFlight[hash] = std::make_pair(nodeid, it);
 }
 
-/** Check whether the last unknown block a peer advertized is not yet known. */
+/** Check whether the last unknown block a peer advertized is not yet known. Requires cs_main and cs_nodestate. */
 void ProcessBlockAvailability(NodeId nodeid) {
     CNodeState *state = State(nodeid);
     assert(state != NULL);
@@ -481,7 +514,7 @@ void ProcessBlockAvailability(NodeId nodeid) {
     }
 }
 
-/** Update tracking information about which blocks a peer is assumed to have. */
+/** Update tracking information about which blocks a peer is assumed to have. Requires cs_main and cs_nodestate. */
 void UpdateBlockAvailability(NodeId nodeid, const uint256 &hash) {
     CNodeState *state = State(nodeid);
     assert(state != NULL);
@@ -519,7 +552,7 @@ CBlockIndex* LastCommonAncestor(CBlockIndex* pa, CBlockIndex* pb) {
 }
 
 /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
- *  at most count entries. */
+ *  at most count entries. Requires cs_main and cs_nodestate. */
 void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<CBlockIndex*>& vBlocks, NodeId& nodeStaller) {
     if (count == 0)
         return;
@@ -605,7 +638,7 @@ void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<CBl
 } // anon namespace
 
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
-    LOCK(cs_main);
+    LOCK(cs_nodestate);
     CNodeState *state = State(nodeid);
     if (state == NULL)
         return false;
@@ -768,6 +801,20 @@ unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans) EXCLUSIVE_LOCKS_REQUIRE
     return nEvicted;
 }
 
+size_t OrphanPoolMemoryUsage()
+{
+    LOCK(cs_main);
+    size_t nUsage = memusage::DynamicUsage(mapOrphanTransactions) +
+        memusage::DynamicUsage(mapOrphanTransactionsByPrev);
+    for (const auto& entry : mapOrphanTransactions) {
+        nUsage += RecursiveDynamicUsage(entry.second.tx);
+    }
+    for (const auto& entry : mapOrphanTransactionsByPrev) {
+        nUsage += memusage::DynamicUsage(entry.second);
+    }
+    return nUsage;
+}
+
 bool IsFinalTx(const CTransaction &tx, int nBlockHeight, int64_t nBlockTime)
 {
     if (tx.nLockTime == 0)
@@ -2024,18 +2071,20 @@ bool AcceptToMemoryPool(
             return false;
         }
 
-        // Check again against just the consensus-critical mandatory script
-        // verification flags, in case of bugs in the standard flags that cause
-        // transactions to pass as valid when they're actually invalid. For
-        // instance the STRICTENC flag was incorrectly allowing certain
-        // CHECKSIG NOT scripts to pass, even though they were invalid.
+        // Check again against just the consensus-critical script verification
+        // flags that blocks are checked with, in case of bugs in the standard
+        // flags that cause transactions to pass as valid when they're actually
+        // invalid. For instance the STRICTENC flag was incorrectly allowing
+        // certain CHECKSIG NOT scripts to pass, even though they were invalid.
+        // This also stores the result in the script execution cache under the
+        // flags that ConnectBlock() will look it up with.
         //
         // There is a similar check in CreateNewBlock() to prevent creating
         // invalid blocks, however allowing such transactions into the mempool
         // can be exploited as a DoS attack.
-        if (!ContextualCheckInputs(tx, state, view, true, MANDATORY_SCRIPT_VERIFY_FLAGS, true, txdata, chainparams.GetConsensus(), consensusBranchId))
+        if (!ContextualCheckInputs(tx, state, view, true, BLOCK_SCRIPT_VERIFY_FLAGS, true, txdata, chainparams.GetConsensus(), consensusBranchId))
         {
-            return error("%s: BUG! PLEASE REPORT THIS! ConnectInputs failed against MANDATORY but not STANDARD flags %s, %s",
+            return error("%s: BUG! PLEASE REPORT THIS! ConnectInputs failed against BLOCK but not STANDARD flags %s, %s",
                 __func__, hash.ToString(), FormatStateMessage(state));
         }
 
@@ -2459,12 +2508,12 @@ void CheckForkWarningConditionsOnNewFork(CBlockIndex* pindexNewForkTip, const CC
     CheckForkWarningConditions(chainParams.GetConsensus());
 }
 
-// Requires cs_main.
 void Misbehaving(NodeId pnode, int howmuch)
 {
     if (howmuch == 0)
         return;
 
+    LOCK(cs_nodestate);
     CNodeState *state = State(pnode);
     if (state == NULL)
         return;
@@ -2499,6 +2548,7 @@ void static InvalidChainFound(CBlockIndex* pindexNew, const CChainParams& chainP
 void static InvalidBlockFound(CBlockIndex *pindex, const CValidationState &state, const CChainParams& chainParams) {
     int nDoS = 0;
     if (state.IsInvalid(nDoS)) {
+        LOCK(cs_nodestate);
         std::map<uint256, NodeId>::iterator it = mapBlockSource.find(pindex->GetBlockHash());
         if (it != mapBlockSource.end() && State(it->second)) {
             assert (state.GetRejectCode() < REJECT_INTERNAL); // Blocks are never rejected with internal reject codes
@@ -2553,6 +2603,9 @@ void UpdateCoins(const CTransaction& tx, CCoinsViewCache& inputs, int nHeight)
 }
 
 bool CScriptCheck::operator()() {
+    if (job) {
+        return (*job)();
+    }
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
     if (!VerifyScript(scriptSig, scriptPubKey, nFlags, CachingTransactionSignatureChecker(ptxTo, *txdata, nIn, amount, cacheStore), consensusBranchId, &error)) {
         return false;
@@ -2685,6 +2738,15 @@ bool ContextualCheckInputs(
         // before the last block chain checkpoint. This is safe because block merkle hashes are
         // still computed and checked, and any change will be caught at the next checkpoint.
         if (fScriptChecks) {
+            // Transactions from the mempool were already checked with the
+            // block's flags when they were accepted. A hit is evicted unless
+            // we are storing results, since a mined transaction is unlikely to
+            // be checked again.
+            uint256 hashCacheEntry = ScriptExecutionCacheEntry(tx, flags, consensusBranchId);
+            if (ScriptExecutionCacheContains(hashCacheEntry, !cacheStore)) {
+                return true;
+            }
+
             for (unsigned int i = 0; i < tx.vin.size(); i++) {
                 const COutPoint &prevout = tx.vin[i].prevout;
                 const CCoins* coins = inputs.AccessCoins(prevout.hash);
@@ -2730,6 +2792,11 @@ bool ContextualCheckInputs(
                     return state.DoS(100,false, REJECT_INVALID, strprintf("mandatory-script-verify-flag-failed (%s)", ScriptErrorString(check.GetScriptError())));
                 }
             }
+
+            if (cacheStore && !pvChecks) {
+                // All scripts were executed above (rather than queued), and passed.
+                ScriptExecutionCacheAdd(hashCacheEntry);
+            }
         }
     }
 
@@ -2834,28 +2901,54 @@ enum DisconnectResult
     DISCONNECT_FAILED   // Something else went wrong.
 };
 
+/**
+ * Juno Cash: JoinSplits and Sapling outputs are rejected by
+ * ContextualCheckTransaction, so the Sprout and Sapling note commitment trees
+ * never leave their empty roots. Returns true if the view is at those roots and
+ * the block cannot move them, in which case ConnectBlock uses the roots as
+ * constants instead of loading, hashing and re-pushing both trees for every
+ * block, and DisconnectBlock has no anchors to restore.
+ */
+static bool LegacyTreesFrozen(const CBlock& block, const CCoinsViewCache& view) {
+    if (view.GetBestAnchor(SPROUT) != SproutMerkleTree::empty_root() ||
+        view.GetBestAnchor(SAPLING) != SaplingMerkleTree::empty_root()) {
+        return false;
+    }
+    for (const CTransaction& tx : block.vtx) {
+        if (!tx.vJoinSplit.empty() || tx.GetSaplingOutputsCount() != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  When UNCLEAN or FAILED is returned, view is left in an indeterminate state.
  *  The addressIndex and spentIndex will be updated if requested.
+ *  The undo data is read from disk unless pblockUndo provides it.
  */
 static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& state,
     const CBlockIndex* pindex, CCoinsViewCache& view, const CChainParams& chainparams,
-    const bool updateIndices)
+    const bool updateIndices, const CBlockUndo* pblockUndo = nullptr)
 {
     assert(pindex->GetBlockHash() == view.GetBestBlock());
 
     bool fClean = true;
 
-    CBlockUndo blockUndo;
-    CDiskBlockPos pos = pindex->GetUndoPos();
-    if (pos.IsNull()) {
-        error("DisconnectBlock(): no undo data available");
-        return DISCONNECT_FAILED;
-    }
-    if (!UndoReadFromDisk(blockUndo, pos, pindex->pprev->GetBlockHash())) {
-        error("DisconnectBlock(): failure reading undo data");
-        return DISCONNECT_FAILED;
+    CBlockUndo blockUndoRead;
+    if (pblockUndo == nullptr) {
+        CDiskBlockPos pos = pindex->GetUndoPos();
+        if (pos.IsNull()) {
+            error("DisconnectBlock(): no undo data available");
+            return DISCONNECT_FAILED;
+        }
+        if (!UndoReadFromDisk(blockUndoRead, pos, pindex->pprev->GetBlockHash())) {
+            error("DisconnectBlock(): failure reading undo data");
+            return DISCONNECT_FAILED;
+        }
+        pblockUndo = &blockUndoRead;
     }
+    const CBlockUndo& blockUndo = *pblockUndo;
 
     if (blockUndo.vtxundo.size() + 1 != block.vtx.size()) {
         error("DisconnectBlock(): block and undo data inconsistent");
@@ -2875,10 +2968,9 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
         if (fAddressIndex && updateIndices) {
             for (unsigned int k = tx.vout.size(); k-- > 0;) {
                 const CTxOut &out = tx.vout[k];
-                CScript::ScriptType scriptType = out.scriptPubKey.GetType();
+                uint160 addrHash;
+                CScript::ScriptType scriptType = out.scriptPubKey.ExtractAddressHash(addrHash);
                 if (scriptType != CScript::UNKNOWN) {
-                    uint160 const addrHash = out.scriptPubKey.AddressHash();
-
                     // undo receiving activity
                     addressIndex.push_back(make_pair(
                         CAddressIndexKey(scriptType, addrHash, pindex->nHeight, i, hash, k, false),
@@ -2932,10 +3024,9 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
                 const CTxIn input = tx.vin[j];
                 if (fAddressIndex && updateIndices) {
                     const CTxOut &prevout = view.GetOutputFor(input);
-                    CScript::ScriptType scriptType = prevout.scriptPubKey.GetType();
+                    uint160 addrHash;
+                    CScript::ScriptType scriptType = prevout.scriptPubKey.ExtractAddressHash(addrHash);
                     if (scriptType != CScript::UNKNOWN) {
-                        uint160 const addrHash = prevout.scriptPubKey.AddressHash();
-
                         // undo spending activity
                         addressIndex.push_back(make_pair(
                             CAddressIndexKey(scriptType, addrHash, pindex->nHeight, i, hash, j, true),
@@ -2980,18 +3071,20 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
         maybeDisconnectSubtree(ORCHARD);
     }
 
-    // set the old best Sprout anchor back
-    view.PopAnchor(blockUndo.old_sprout_tree_root, SPROUT);
+    if (!LegacyTreesFrozen(block, view)) {
+        // set the old best Sprout anchor back
+        view.PopAnchor(blockUndo.old_sprout_tree_root, SPROUT);
 
-    // set the old best Sapling anchor back
-    // We can get this from the `hashFinalSaplingRoot` of the last block
-    // However, this is only reliable if the last block was on or after
-    // the Sapling activation height. Otherwise, the last anchor was the
-    // empty root.
-    if (chainparams.GetConsensus().NetworkUpgradeActive(pindex->pprev->nHeight, Consensus::UPGRADE_SAPLING)) {
-        view.PopAnchor(pindex->pprev->hashFinalSaplingRoot, SAPLING);
-    } else {
-        view.PopAnchor(SaplingMerkleTree::empty_root(), SAPLING);
+        // set the old best Sapling anchor back
+        // We can get this from the `hashFinalSaplingRoot` of the last block
+        // However, this is only reliable if the last block was on or after
+        // the Sapling activation height. Otherwise, the last anchor was the
+        // empty root.
+        if (chainparams.GetConsensus().NetworkUpgradeActive(pindex->pprev->nHeight, Consensus::UPGRADE_SAPLING)) {
+            view.PopAnchor(pindex->pprev->hashFinalSaplingRoot, SAPLING);
+        } else {
+            view.PopAnchor(SaplingMerkleTree::empty_root(), SAPLING);
+        }
     }
 
     // Set the old best Orchard anchor back. We can get this from the
@@ -3072,9 +3165,29 @@ static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
 void ThreadScriptCheck() {
     RenameThread("zc-scriptcheck");
+    ThreadPoolMember member(ThreadPool::SCRIPT_CHECK);
     scriptcheckqueue.Thread();
 }
 
+bool RunOnScriptCheckQueue(const std::vector<std::function<bool()>>& vJobs)
+{
+    // Blocks are also decoded while the queue is in use, by the VerifyDB jobs
+    // running on it or on another thread while a block is connected. Rather
+    // than wait for the queue, leave those to the caller.
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue, std::try_to_lock);
+    if (!control.HasQueue()) {
+        return false;
+    }
+    std::vector<CScriptCheck> vChecks;
+    vChecks.reserve(vJobs.size());
+    for (const std::function<bool()>& job : vJobs) {
+        vChecks.emplace_back(&job);
+    }
+    control.Add(vChecks);
+    control.Wait();
+    return true;
+}
+
 static int64_t nTimeVerify = 0;
 static int64_t nTimeConnect = 0;
 static int64_t nTimeIndex = 0;
@@ -3142,6 +3255,19 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     std::optional<rust::Box<orchard::BatchValidator>> orchardAuth = fExpensiveChecks ?
         std::optional(orchard::init_batch_validator(fCacheResults)) : std::nullopt;
 
+    // The non-coinbase transactions of a block built from one of our own
+    // templates were checked against this parent when the template was
+    // created. Skip their scripts, proofs and signatures, and audit them in the
+    // background once the block is connected.
+    bool fFromTemplate = blockChecks == CheckAs::Block && !fJustCheck && fExpensiveChecks &&
+        IsFromRememberedTemplate(block);
+    std::optional<rust::Box<sapling::BatchValidator>> noSaplingAuth;
+    std::optional<rust::Box<orchard::BatchValidator>> noOrchardAuth;
+    std::vector<std::vector<CTxOut>> vSpentOutputs;
+    if (fFromTemplate) {
+        vSpentOutputs.resize(block.vtx.size());
+    }
+
     // If in initial block download, and this block is an ancestor of a checkpoint,
     // and -ibdskiptxverification is set, disable all transaction checks.
     bool fCheckTransactions = ShouldCheckTransactions(chainparams, pindex);
@@ -3258,13 +3384,11 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                              REJECT_INVALID, "bad-txns-BIP30");
     }
 
-    unsigned int flags = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY;
-
-    // DERSIG (BIP66) is also always enforced, but does not have a flag.
+    unsigned int flags = BLOCK_SCRIPT_VERIFY_FLAGS;
 
     CBlockUndo blockundo;
 
-    CCheckQueueControl<CScriptCheck> control(fExpensiveChecks && nScriptCheckThreads ? &scriptcheckqueue : NULL);
+    CCheckQueueControl<CScriptCheck> control(fExpensiveChecks && !fFromTemplate && nScriptCheckThreads ? &scriptcheckqueue : NULL);
 
     int64_t nTimeStart = GetTimeMicros();
     std::vector<uint256> vOrphanErase;
@@ -3279,6 +3403,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     std::vector<CAddressUnspentDbEntry> addressUnspentIndex;
     std::vector<CSpentIndexDbEntry> spentIndex;
 
+    const bool fLegacyTreesFrozen = LegacyTreesFrozen(block, view);
+
     // Construct the incremental merkle tree at the current
     // block position,
     auto old_sprout_tree_root = view.GetBestAnchor(SPROUT);
@@ -3287,17 +3413,19 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         pindex->hashSproutAnchor = old_sprout_tree_root;
     }
     SproutMerkleTree sprout_tree;
-    // This should never fail: we should always be able to get the root
-    // that is on the tip of our chain
-    assert(view.GetSproutAnchorAt(old_sprout_tree_root, sprout_tree));
-    {
-        // Consistency check: the root of the tree we're given should
-        // match what we asked for.
-        assert(sprout_tree.root() == old_sprout_tree_root);
-    }
-
     SaplingMerkleTree sapling_tree;
-    assert(view.GetSaplingAnchorAt(view.GetBestAnchor(SAPLING), sapling_tree));
+    if (!fLegacyTreesFrozen) {
+        // This should never fail: we should always be able to get the root
+        // that is on the tip of our chain
+        assert(view.GetSproutAnchorAt(old_sprout_tree_root, sprout_tree));
+        {
+            // Consistency check: the root of the tree we're given should
+            // match what we asked for.
+            assert(sprout_tree.root() == old_sprout_tree_root);
+        }
+
+        assert(view.GetSaplingAnchorAt(view.GetBestAnchor(SAPLING), sapling_tree));
+    }
 
     OrchardMerkleFrontier orchard_tree;
     if (pindex->pprev && consensusParams.NetworkUpgradeActive(pindex->pprev->nHeight, Consensus::UPGRADE_NU5)) {
@@ -3393,8 +3521,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 
                     const CTxIn input = tx.vin[j];
                     const CTxOut &prevout = allPrevOutputs[j];
-                    CScript::ScriptType scriptType = prevout.scriptPubKey.GetType();
-                    const uint160 addrHash = prevout.scriptPubKey.AddressHash();
+                    uint160 addrHash;
+                    CScript::ScriptType scriptType = prevout.scriptPubKey.ExtractAddressHash(addrHash);
                     if (fAddressIndex && scriptType != CScript::UNKNOWN) {
                         // record spending activity
                         addressIndex.push_back(make_pair(
@@ -3428,6 +3556,9 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         }
 
         txdata.emplace_back(tx, allPrevOutputs);
+        if (fFromTemplate) {
+            vSpentOutputs[i] = allPrevOutputs;
+        }
 
         if (tx.IsCoinBase())
         {
@@ -3448,7 +3579,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
             chainSupplyDelta -= txFee;
 
             std::vector<CScriptCheck> vChecks;
-            if (!ContextualCheckInputs(tx, state, view, fExpensiveChecks, flags, fCacheResults, txdata.back(), consensusParams, consensusBranchId, nScriptCheckThreads ? &vChecks : NULL))
+            if (!ContextualCheckInputs(tx, state, view, fExpensiveChecks && !fFromTemplate, flags, fCacheResults, txdata.back(), consensusParams, consensusBranchId, nScriptCheckThreads ? &vChecks : NULL))
                 return error("%s: CheckInputs on %s failed with %s", __func__,
                     tx.GetHash().ToString(), FormatStateMessage(state));
             control.Add(vChecks);
@@ -3460,8 +3591,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
             txdata.back(),
             state,
             view,
-            saplingAuth,
-            orchardAuth,
+            fFromTemplate && !tx.IsCoinBase() ? noSaplingAuth : saplingAuth,
+            fFromTemplate && !tx.IsCoinBase() ? noOrchardAuth : orchardAuth,
             consensusParams,
             consensusBranchId,
             consensusParams.NetworkUpgradeActive(pindex->nHeight, Consensus::UPGRADE_NU5),
@@ -3478,10 +3609,9 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         if (fAddressIndex) {
             for (unsigned int k = 0; k < tx.vout.size(); k++) {
                 const CTxOut &out = tx.vout[k];
-                CScript::ScriptType scriptType = out.scriptPubKey.GetType();
+                uint160 addrHash;
+                CScript::ScriptType scriptType = out.scriptPubKey.ExtractAddressHash(addrHash);
                 if (scriptType != CScript::UNKNOWN) {
-                    uint160 const addrHash = out.scriptPubKey.AddressHash();
-
                     // record receiving activity
                     addressIndex.push_back(make_pair(
                         CAddressIndexKey(scriptType, addrHash, pindex->nHeight, i, hash, k, false),
@@ -3577,8 +3707,16 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         hashChainHistoryRoot = view.GetHistoryRoot(prevConsensusBranchId);
     }
 
-    view.PushAnchor(sprout_tree);
-    view.PushAnchor(sapling_tree);
+    // An empty Sapling tree still costs a Pedersen hash per level to take the
+    // root of. The view already holds the frozen roots as its best anchors.
+    uint256 sprout_root = SproutMerkleTree::empty_root();
+    uint256 sapling_root = SaplingMerkleTree::empty_root();
+    if (!fLegacyTreesFrozen) {
+        sprout_root = sprout_tree.root();
+        sapling_root = sapling_tree.root();
+        view.PushAnchor(sprout_tree);
+        view.PushAnchor(sapling_tree);
+    }
     view.PushAnchor(orchard_tree);
     if (!fJustCheck) {
         // Update pindex with the net change in value and the chain's total value,
@@ -3602,7 +3740,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
             pindex->nChainTransparentValue = transparentValueDelta;
         }
 
-        pindex->hashFinalSproutRoot = sprout_tree.root();
+        pindex->hashFinalSproutRoot = sprout_root;
         // - If this block is before Heartwood activation, then we don't set
         //   hashFinalSaplingRoot here to maintain the invariant documented in
         //   CBlockIndex (which was ensured in AddToBlockIndex).
@@ -3611,7 +3749,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         //   blocks that are never passed to ConnectBlock (and thus never on
         //   the main chain) will stay with hashFinalSaplingRoot set to null.
         if (consensusParams.NetworkUpgradeActive(pindex->nHeight, Consensus::UPGRADE_HEARTWOOD)) {
-            pindex->hashFinalSaplingRoot = sapling_tree.root();
+            pindex->hashFinalSaplingRoot = sapling_root;
         }
 
         // - If this block is before NU5 activation:
@@ -3670,7 +3808,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     } else if (consensusParams.NetworkUpgradeActive(pindex->nHeight, Consensus::UPGRADE_SAPLING)) {
         // If Sapling is active, block.hashBlockCommitments must be the
         // same as the root of the Sapling tree
-        if (block.hashBlockCommitments != sapling_tree.root()) {
+        if (block.hashBlockCommitments != sapling_root) {
             return state.DoS(100,
                 error("%s: block's hashBlockCommitments is incorrect (should be Sapling tree root)", __func__),
                 REJECT_INVALID, "bad-sapling-root-in-block");
@@ -3866,6 +4004,12 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         LogPrint("mempool", "Erased %d orphan tx included or conflicted by block\n", nErased);
     }
 
+    if (fFromTemplate) {
+        LogPrint("bench", "    - Connected block from a local template, auditing in the background\n");
+        MetricsIncrementCounter("zcashd.templatefastpath.blocks");
+        QueueTemplateBlockAudit({pindex->GetBlockHash(), pindex->nHeight, block, std::move(vSpentOutputs)});
+    }
+
     return true;
 }
 
@@ -3876,6 +4020,37 @@ enum FlushStateMode {
     FLUSH_STATE_ALWAYS
 };
 
+/**
+ * Returns true if pindex or one of its ancestors is waiting for its deferred
+ * RandomX check. mapChecked caches the answer along the walked path.
+ */
+static bool HasDeferredPoWAncestor(const CBlockIndex* pindex, std::map<const CBlockIndex*, bool>& mapChecked)
+{
+    AssertLockHeld(cs_main);
+    if (setDeferredPoWHeaders.empty()) {
+        return false;
+    }
+    int nLowest = setDeferredPoWHeaders.begin()->first;
+    std::vector<const CBlockIndex*> vPath;
+    bool fDeferred = false;
+    for (const CBlockIndex* pwalk = pindex; pwalk != NULL && pwalk->nHeight >= nLowest; pwalk = pwalk->pprev) {
+        std::map<const CBlockIndex*, bool>::const_iterator it = mapChecked.find(pwalk);
+        if (it != mapChecked.end()) {
+            fDeferred = it->second;
+            break;
+        }
+        vPath.push_back(pwalk);
+        if (mapDeferredPoWSource.count(pwalk)) {
+            fDeferred = true;
+            break;
+        }
+    }
+    for (const CBlockIndex* pwalk : vPath) {
+        mapChecked[pwalk] = fDeferred;
+    }
+    return fDeferred;
+}
+
 /**
  * Update the on-disk chain state.
  * The caches and indexes are flushed depending on the mode we're called with
@@ -3939,7 +4114,14 @@ bool static FlushStateToDisk(
             }
             std::vector<CBlockIndex*> vBlocks;
             vBlocks.reserve(setDirtyBlockIndex.size());
+            // Juno Cash: headers whose RandomX check is still deferred, and
+            // their descendants, stay dirty until the check passes.
+            std::map<const CBlockIndex*, bool> mapDeferredChecked;
             for (set<CBlockIndex*>::iterator it = setDirtyBlockIndex.begin(); it != setDirtyBlockIndex.end(); ) {
+                if (HasDeferredPoWAncestor(*it, mapDeferredChecked)) {
+                    ++it;
+                    continue;
+                }
                 vBlocks.push_back(*it);
                 it = setDirtyBlockIndex.erase(it);
             }
@@ -4081,6 +4263,7 @@ struct PoolMetrics {
 /** Update chainActive and related internal data structures. */
 void static UpdateTip(CBlockIndex *pindexNew, const CChainParams& chainParams) {
     chainActive.SetTip(pindexNew);
+    nActiveHeight = chainActive.Height();
 
     // New best block
     nTimeBestReceived = GetTime();
@@ -4124,17 +4307,121 @@ void static UpdateTip(CBlockIndex *pindexNew, const CChainParams& chainParams) {
     }
 }
 
+/** Number of blocks CDisconnectPrefetcher reads ahead of the disconnect loop. */
+static const size_t DISCONNECT_PREFETCH_DEPTH = 16;
+
+/**
+ * Reads the blocks and undo data of a run of blocks that are about to be
+ * disconnected, ahead of the disconnect loop. Reading a block and its undo
+ * data and verifying the undo checksum then overlaps with disconnecting the
+ * blocks above it, instead of stalling every step of a deep reorg while
+ * cs_main is held.
+ */
+class CDisconnectPrefetcher
+{
+private:
+    struct Prefetched {
+        bool fOk = false;
+        CBlock block;
+        CBlockUndo blockUndo;
+    };
+
+    const CChainParams& chainparams;
+    //! The blocks to read, in the order they will be disconnected.
+    std::vector<CStoredBlock> vStored;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<Prefetched> ready;
+    size_t nTaken = 0;
+    bool fStop = false;
+    std::thread thread;
+
+    void Run()
+    {
+        for (size_t i = 0; i < vStored.size(); i++) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [&] { return fStop || i < nTaken + DISCONNECT_PREFETCH_DEPTH; });
+                if (fStop) return;
+            }
+            // A failed read is left for DisconnectTip to repeat and report.
+            const CStoredBlock& stored = vStored[i];
+            Prefetched prefetched;
+            prefetched.fOk = !stored.blockPos.IsNull() && !stored.undoPos.IsNull() &&
+                ReadBlockFromDisk(prefetched.block, stored.blockPos, chainparams.GetConsensus()) &&
+                prefetched.block.GetHash() == stored.hash &&
+                UndoReadFromDisk(prefetched.blockUndo, stored.undoPos, stored.hashPrev);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready.push_back(std::move(prefetched));
+            }
+            cond.notify_all();
+        }
+    }
+
+public:
+    /** Starts reading the blocks from pindexTip down to, but excluding, pindexStop. */
+    CDisconnectPrefetcher(const CChainParams& chainparamsIn, const CBlockIndex* pindexTip, const CBlockIndex* pindexStop) :
+        chainparams(chainparamsIn)
+    {
+        AssertLockHeld(cs_main);
+        for (const CBlockIndex* pindex = pindexTip; pindex && pindex != pindexStop && pindex->pprev; pindex = pindex->pprev) {
+            vStored.push_back(GetStoredBlock(chainparams, pindex));
+        }
+        thread = std::thread(&CDisconnectPrefetcher::Run, this);
+    }
+
+    ~CDisconnectPrefetcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            fStop = true;
+        }
+        cond.notify_all();
+        thread.join();
+    }
+
+    /**
+     * Hands out the block and undo data of pindex if it is the next block in
+     * the run and was read successfully. Otherwise the caller reads them itself.
+     */
+    bool Take(const CBlockIndex* pindex, CBlock& block, CBlockUndo& blockUndo)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (nTaken >= vStored.size() || vStored[nTaken].hash != pindex->GetBlockHash()) {
+            return false;
+        }
+        cond.wait(lock, [&] { return !ready.empty(); });
+        Prefetched prefetched = std::move(ready.front());
+        ready.pop_front();
+        nTaken++;
+        lock.unlock();
+        cond.notify_all();
+
+        if (!prefetched.fOk) {
+            return false;
+        }
+        block = std::move(prefetched.block);
+        blockUndo = std::move(prefetched.blockUndo);
+        return true;
+    }
+};
+
 /**
  * Disconnect chainActive's tip. You probably want to call mempool.removeForReorg and
  * mempool.removeWithoutBranchId after this, with cs_main held.
  */
-bool static DisconnectTip(CValidationState &state, const CChainParams& chainparams, bool fBare = false)
+bool static DisconnectTip(CValidationState &state, const CChainParams& chainparams, bool fBare = false,
+                          CDisconnectPrefetcher* prefetcher = nullptr)
 {
     CBlockIndex *pindexDelete = chainActive.Tip();
     assert(pindexDelete);
-    // Read block from disk.
+    // Read block from disk, unless it was prefetched.
     CBlock block;
-    if (!ReadBlockFromDisk(block, pindexDelete, chainparams.GetConsensus()))
+    CBlockUndo blockUndo;
+    bool fPrefetched = prefetcher && prefetcher->Take(pindexDelete, block, blockUndo);
+    if (!fPrefetched && !ReadBlockFromDisk(block, pindexDelete, chainparams.GetConsensus()))
         return AbortNode(state, "Failed to read block");
     // Apply the block atomically to the chain state.
     uint256 sproutAnchorBeforeDisconnect = pcoinsTip->GetBestAnchor(SPROUT);
@@ -4144,7 +4431,7 @@ bool static DisconnectTip(CValidationState &state, const CChainParams& chainpara
     {
         CCoinsViewCache view(pcoinsTip);
         // insightexplorer: update indices (true)
-        if (DisconnectBlock(block, state, pindexDelete, view, chainparams, true) != DISCONNECT_OK)
+        if (DisconnectBlock(block, state, pindexDelete, view, chainparams, true, fPrefetched ? &blockUndo : nullptr) != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         assert(view.Flush());
     }
@@ -4211,6 +4498,116 @@ std::map<const CBlockIndex*, std::list<CTransaction>> recentlyConflictedTxs;
 uint64_t nConnectedSequence = 0;
 uint64_t nNotifiedSequence = 0;
 
+static void AddDeferredPoWHeader(CBlockIndex* pindex, NodeId nodeid)
+{
+    AssertLockHeld(cs_main);
+    setDeferredPoWHeaders.insert(std::make_pair(pindex->nHeight, pindex));
+    mapDeferredPoWSource[pindex] = nodeid;
+    mapDeferredPoWPerPeer[nodeid]++;
+    nDeferredPoWHeaders++;
+    MetricsGauge("zcashd.headerpow.deferred", (double)setDeferredPoWHeaders.size());
+    NotifyDeferredPoWHeaders();
+}
+
+/**
+ * Juno Cash: whether the RandomX check of a header from nodeid extending
+ * pindexPrev can be deferred. See headerpow.h.
+ */
+static bool ShouldDeferPoW(const CChainParams& chainparams, const CBlockIndex* pindexPrev, NodeId nodeid)
+{
+    AssertLockHeld(cs_main);
+    if (hashAssumeValid.IsNull() || pindexPrev == NULL) {
+        return false;
+    }
+    // Once the assumed-valid block is known, so are the headers it covers.
+    if (mapBlockIndex.count(hashAssumeValid) || nDeferredPoWHeaders >= MAX_DEFERRED_POW_HEADERS) {
+        return false;
+    }
+    std::map<NodeId, size_t>::const_iterator it = mapDeferredPoWPerPeer.find(nodeid);
+    if (it != mapDeferredPoWPerPeer.end() && it->second >= MAX_DEFERRED_POW_HEADERS_PER_PEER) {
+        return false;
+    }
+    // Check a random sample right away, so that a peer sending headers with
+    // false claims is caught and banned without waiting for the verifier.
+    if (GetRand(DEFERRED_POW_SPOT_CHECK_INTERVAL) == 0) {
+        return false;
+    }
+    return IsInitialBlockDownload(chainparams.GetConsensus());
+}
+
+bool IsAssumedValidHeader(const Consensus::Params& consensusParams, const CBlockIndex* pindex)
+{
+    AssertLockHeld(cs_main);
+    if (hashAssumeValid.IsNull()) {
+        return false;
+    }
+    BlockMap::const_iterator it = mapBlockIndex.find(hashAssumeValid);
+    if (it == mapBlockIndex.end()) {
+        return false;
+    }
+    const CBlockIndex* pindexAssumed = it->second;
+    if (pindexAssumed->nChainWork < UintToArith256(consensusParams.nMinimumChainWork)) {
+        return false;
+    }
+    return pindexAssumed->GetAncestor(pindex->nHeight) == pindex;
+}
+
+std::vector<CBlockIndex*> GetDeferredPoWHeaders(size_t nMax)
+{
+    AssertLockHeld(cs_main);
+    std::vector<CBlockIndex*> vHeaders;
+    for (auto it = setDeferredPoWHeaders.begin(); it != setDeferredPoWHeaders.end() && vHeaders.size() < nMax; ++it) {
+        vHeaders.push_back(it->second);
+    }
+    return vHeaders;
+}
+
+void FinishDeferredPoWCheck(CBlockIndex* pindex, bool fValid)
+{
+    AssertLockHeld(cs_main);
+    setDeferredPoWHeaders.erase(std::make_pair(pindex->nHeight, pindex));
+    std::map<const CBlockIndex*, NodeId>::iterator itSource = mapDeferredPoWSource.find(pindex);
+    if (itSource != mapDeferredPoWSource.end()) {
+        NodeId nodeid = itSource->second;
+        mapDeferredPoWSource.erase(itSource);
+        if (--mapDeferredPoWPerPeer[nodeid] == 0) {
+            mapDeferredPoWPerPeer.erase(nodeid);
+        }
+        if (!fValid) {
+            Misbehaving(nodeid, 100);
+        }
+    }
+    if (fValid) {
+        pindex->nStatus &= ~BLOCK_POW_UNVERIFIED;
+        setDirtyBlockIndex.insert(pindex);
+    }
+    MetricsGauge("zcashd.headerpow.deferred", (double)setDeferredPoWHeaders.size());
+}
+
+/**
+ * Checks the RandomX solution of the header of a block about to be connected,
+ * if it was deferred and is not covered by -assumevalid.
+ */
+static bool CheckDeferredPoW(CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindex)
+{
+    AssertLockHeld(cs_main);
+    if (!(pindex->nStatus & BLOCK_POW_UNVERIFIED)) {
+        return true;
+    }
+    if (IsAssumedValidHeader(chainparams.GetConsensus(), pindex)) {
+        FinishDeferredPoWCheck(pindex, true);
+        return true;
+    }
+    CBlockHeader header = pindex->GetBlockHeader();
+    bool fValid = CheckRandomXSolution(&header, chainparams.GetConsensus(), pindex->pprev);
+    FinishDeferredPoWCheck(pindex, fValid);
+    if (!fValid) {
+        return state.DoS(100, error("%s: RandomX solution invalid", __func__),
+                         REJECT_INVALID, "invalid-solution");
+    }
+    return true;
+}
+
 /**
  * Connect a new block to chainActive. pblock is either NULL or a pointer to a CBlock
  * corresponding to pindexNew, to bypass loading it again from disk.
@@ -4219,19 +4616,27 @@ uint64_t nNotifiedSequence = 0;
 bool static ConnectTip(CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindexNew, const CBlock* pblock)
 {
     assert(pblock && pindexNew->pprev == chainActive.Tip());
+    if (!CheckDeferredPoW(state, chainparams, pindexNew)) {
+        QueueBlockChecked(*pblock, state);
+        InvalidBlockFound(pindexNew, state, chainparams);
+        return error("ConnectTip(): header of %s has an invalid RandomX solution", pindexNew->GetBlockHash().ToString());
+    }
     // Apply the block atomically to the chain state.
     int64_t nTime2 = GetTimeMicros();
     int64_t nTime3;
     {
         CCoinsViewCache view(pcoinsTip);
         bool rv = ConnectBlock(*pblock, state, pindexNew, view, chainparams);
-        GetMainSignals().BlockChecked(*pblock, state);
+        QueueBlockChecked(*pblock, state);
         if (!rv) {
             if (state.IsInvalid())
                 InvalidBlockFound(pindexNew, state, chainparams);
             return error("ConnectTip(): ConnectBlock %s failed", pindexNew->GetBlockHash().ToString());
         }
-        mapBlockSource.erase(pindexNew->GetBlockHash());
+        {
+            LOCK(cs_nodestate);
+            mapBlockSource.erase(pindexNew->GetBlockHash());
+        }
         nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTime2;
         LogPrint("bench", "  - Connect total: %.2fms [%.2fs]\n", (nTime3 - nTime2) * 0.001, nTimeConnectTotal * 0.000001);
         assert(view.Flush());
@@ -4416,11 +4821,16 @@ static bool ActivateBestChainStep(CValidationState& state, const CChainParams& c
 
     // Disconnect active blocks which are no longer in the best chain.
     bool fBlocksDisconnected = false;
+    std::optional<CDisconnectPrefetcher> prefetcher;
+    if (pindexFork && chainActive.Height() - pindexFork->nHeight > 1) {
+        prefetcher.emplace(chainparams, chainActive.Tip(), pindexFork);
+    }
     while (chainActive.Tip() && chainActive.Tip() != pindexFork) {
-        if (!DisconnectTip(state, chainparams))
+        if (!DisconnectTip(state, chainparams, false, prefetcher ? &*prefetcher : nullptr))
             return false;
         fBlocksDisconnected = true;
     }
+    prefetcher.reset();
 
     // Build list of new blocks to connect.
     std::vector<CBlockIndex*> vpindexToConnect;
@@ -4585,7 +4995,7 @@ bool ActivateBestChain(CValidationState& state, const CChainParams& chainparams,
                         pnode->PushBlockInventory(hashNewTip);
             }
             // Notify external listeners about the new tip.
-            GetMainSignals().UpdatedBlockTip(pindexNewTip);
+            QueueUpdatedBlockTip(pindexNewTip);
         }
     } while (pindexNewTip != pindexMostWork);
     CheckBlockIndex(chainparams.GetConsensus());
@@ -4607,6 +5017,10 @@ bool InvalidateBlock(CValidationState& state, const CChainParams& chainparams, C
     setDirtyBlockIndex.insert(pindex);
     setBlockIndexCandidates.erase(pindex);
 
+    std::optional<CDisconnectPrefetcher> prefetcher;
+    if (chainActive.Contains(pindex) && chainActive.Height() > pindex->nHeight) {
+        prefetcher.emplace(chainparams, chainActive.Tip(), pindex->pprev);
+    }
     while (chainActive.Contains(pindex)) {
         CBlockIndex *pindexWalk = chainActive.Tip();
         pindexWalk->nStatus |= BLOCK_FAILED_CHILD;
@@ -4614,7 +5028,7 @@ bool InvalidateBlock(CValidationState& state, const CChainParams& chainparams, C
         setBlockIndexCandidates.erase(pindexWalk);
         // ActivateBestChain considers blocks already in chainActive
         // unconditionally valid already, so force disconnect away from it.
-        if (!DisconnectTip(state, chainparams)) {
+        if (!DisconnectTip(state, chainparams, false, prefetcher ? &*prefetcher : nullptr)) {
             mempool.removeForReorg(pcoinsTip, chainActive.Tip()->nHeight + 1, STANDARD_LOCKTIME_VERIFY_FLAGS);
             mempool.removeWithoutBranchId(
                 CurrentEpochBranchId(chainActive.Tip()->nHeight + 1, chainparams.GetConsensus()));
@@ -5056,12 +5470,7 @@ bool CheckBlockHeader(
                              REJECT_INVALID, "invalid-solution");
 
         // Check proof of work matches claimed amount
-        // For RandomX, the POW hash is the RandomX hash stored in nSolution
-        uint256 randomxHash;
-        if (block.nSolution.size() == 32) {
-            memcpy(randomxHash.begin(), block.nSolution.data(), 32);
-        }
-        if (!CheckProofOfWork(randomxHash, block.nBits, chainparams.GetConsensus()))
+        if (!CheckClaimedProofOfWork(&block, chainparams.GetConsensus()))
             return state.DoS(50, error("CheckBlockHeader(): proof of work failed"),
                              REJECT_INVALID, "high-hash");
     }
@@ -5297,7 +5706,7 @@ bool ContextualCheckBlock(
     return true;
 }
 
-static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex=NULL)
+static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex=NULL, NodeId nodeid=-1)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -5325,8 +5734,14 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
             return state.DoS(100, error("%s: prev block invalid", __func__), REJECT_INVALID, "bad-prevblk");
     }
 
-    if (!CheckBlockHeader(block, state, chainparams, true, pindexPrev))
+    // Juno Cash: below the -assumevalid block, only check the claimed hash
+    // against nBits for now.
+    bool fDeferPoW = ShouldDeferPoW(chainparams, pindexPrev, nodeid);
+    if (!CheckBlockHeader(block, state, chainparams, !fDeferPoW, pindexPrev))
         return false;
+    if (fDeferPoW && !CheckClaimedProofOfWork(&block, chainparams.GetConsensus()))
+        return state.DoS(50, error("%s: proof of work failed", __func__),
+                         REJECT_INVALID, "high-hash");
 
     if (!ContextualCheckBlockHeader(block, state, chainparams, pindexPrev))
         return false;
@@ -5334,6 +5749,12 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
     if (pindex == NULL)
         pindex = AddToBlockIndex(block, chainparams.GetConsensus());
 
+    if (fDeferPoW) {
+        pindex->nStatus |= BLOCK_POW_UNVERIFIED;
+        setDirtyBlockIndex.insert(pindex);
+        AddDeferredPoWHeader(pindex, nodeid);
+    }
+
     if (ppindex)
         *ppindex = pindex;
 
@@ -5348,14 +5769,14 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
  * caller of AcceptBlock (ProcessNewBlock) later invokes ActivateBestChain,
  * which ultimately calls ConnectBlock in a manner that can verify the proofs.
  */
-static bool AcceptBlock(const CBlock& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp)
+static bool AcceptBlock(const CBlock& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, NodeId nodeid=-1)
 {
     AssertLockHeld(cs_main);
 
     CBlockIndex *pindexDummy = NULL;
     CBlockIndex *&pindex = ppindex ? *ppindex : pindexDummy;
 
-    if (!AcceptBlockHeader(block, state, chainparams, &pindex))
+    if (!AcceptBlockHeader(block, state, chainparams, &pindex, nodeid))
         return false;
 
     SetChainPoolValues(chainparams, block, pindex);
@@ -5444,12 +5865,17 @@ bool ProcessNewBlock(CValidationState& state, const CChainParams& chainparams, c
 
     {
         LOCK(cs_main);
-        bool fRequested = MarkBlockAsReceived(pblock->GetHash()) | fForceProcessing;
+        bool fRequested;
+        {
+            LOCK(cs_nodestate);
+            fRequested = MarkBlockAsReceived(pblock->GetHash()) | fForceProcessing;
+        }
 
         // Store to disk
         CBlockIndex *pindex = NULL;
-        bool ret = AcceptBlock(*pblock, state, chainparams, &pindex, fRequested, dbp);
+        bool ret = AcceptBlock(*pblock, state, chainparams, &pindex, fRequested, dbp, pfrom ? pfrom->GetId() : -1);
         if (pindex && pfrom) {
+            LOCK(cs_nodestate);
             mapBlockSource[pindex->GetBlockHash()] = pfrom->GetId();
         }
         CheckBlockIndex(chainparams.GetConsensus());
@@ -5893,6 +6319,7 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     if (it == mapBlockIndex.end())
         return true;
     chainActive.SetTip(it->second);
+    nActiveHeight = chainActive.Height();
 
     // Juno Cash: Initialize genesis block anchor roots if loading from disk
     // and ensure they exist in the database
@@ -5948,6 +6375,70 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     return true;
 }
 
+CStoredBlock GetStoredBlock(const CChainParams& chainparams, const CBlockIndex* pindex)
+{
+    AssertLockHeld(cs_main);
+    CStoredBlock stored;
+    stored.nHeight = pindex->nHeight;
+    stored.hash = pindex->GetBlockHash();
+    stored.hashPrev = pindex->pprev ? pindex->pprev->GetBlockHash() : uint256();
+    stored.blockPos = pindex->GetBlockPos();
+    stored.undoPos = pindex->GetUndoPos();
+    stored.fCheckTransactions = ShouldCheckTransactions(chainparams, pindex);
+    return stored;
+}
+
+bool CheckStoredBlock(
+    const CChainParams& chainparams,
+    const CStoredBlock& stored,
+    int nCheckLevel,
+    std::string& strError,
+    CBlock* pblockOut,
+    CBlockUndo* pblockUndoOut)
+{
+    // check level 0: read from disk
+    CBlock block;
+    if (stored.blockPos.IsNull() ||
+        !ReadBlockFromDisk(block, stored.blockPos, chainparams.GetConsensus()) ||
+        block.GetHash() != stored.hash)
+    {
+        strError = strprintf("ReadBlockFromDisk failed at %d, hash=%s", stored.nHeight, stored.hash.ToString());
+        return false;
+    }
+
+    // check level 1: verify block validity
+    CValidationState state;
+    auto verifier = ProofVerifier::Disabled(); // No need to verify JoinSplits twice
+    if (nCheckLevel >= 1 && !CheckBlock(block, state, chainparams, verifier, true, true, stored.fCheckTransactions)) {
+        strError = strprintf("found bad block at %d, hash=%s", stored.nHeight, stored.hash.ToString());
+        return false;
+    }
+
+    // check level 2: verify undo validity
+    if (nCheckLevel >= 2 && !stored.undoPos.IsNull()) {
+        CBlockUndo undo;
+        bool fValid = UndoReadFromDisk(undo, stored.undoPos, stored.hashPrev) &&
+            undo.vtxundo.size() + 1 == block.vtx.size();
+        for (size_t i = 0; fValid && i < undo.vtxundo.size(); i++) {
+            fValid = undo.vtxundo[i].vprevout.size() == block.vtx[i + 1].vin.size();
+        }
+        if (!fValid) {
+            strError = strprintf("found bad undo data at %d, hash=%s", stored.nHeight, stored.hash.ToString());
+            return false;
+        }
+        if (pblockUndoOut) {
+            *pblockUndoOut = std::move(undo);
+        }
+    }
+    if (pblockOut) {
+        *pblockOut = std::move(block);
+    }
+    return true;
+}
+
+/** Bytes of blocks that VerifyDB keeps from the level 0-2 checks for level 3. */
+static const size_t VERIFYDB_KEEP_BYTES = 256 * 1024 * 1024;
+
 CVerifyDB::CVerifyDB()
 {
     uiInterface.ShowProgress(_("Verifying blocks..."), 0);
@@ -5977,56 +6468,138 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
     int nGoodTransactions = 0;
     CValidationState state;
 
-    // Flags used to permit skipping checks for efficiency
-    auto verifier = ProofVerifier::Disabled(); // No need to verify JoinSplits twice
-    bool fCheckTransactions = true;
+    // Levels 0 to 2 look at one block at a time, so they run as jobs on the
+    // script check queue. The jobs only see copies of the block index
+    // entries they need, taken while we hold cs_main.
+    std::vector<CStoredBlock> vStored;
+    for (CBlockIndex* pindex = chainActive.Tip(); pindex && pindex->pprev; pindex = pindex->pprev) {
+        if (pindex->nHeight < chainActive.Height()-nCheckDepth)
+            break;
+        vStored.push_back(GetStoredBlock(chainparams, pindex));
+    }
 
-    for (CBlockIndex* pindex = chainActive.Tip(); pindex && pindex->pprev; pindex = pindex->pprev)
+    // Level 3 disconnects the same blocks from the tip down, so the blocks
+    // and undo data read here are kept for it, up to VERIFYDB_KEEP_BYTES.
+    struct KeptBlock {
+        bool fKept = false;
+        CBlock block;
+        CBlockUndo blockUndo;
+    };
+    std::vector<KeptBlock> vKept(nCheckLevel >= 3 ? vStored.size() : 0);
+    std::atomic<size_t> nKeptBytes{0};
+
+    const int nProgressShare = nCheckLevel >= 4 ? 50 : 100;
+    std::atomic<size_t> nDone{0};
+    std::mutex failureMutex;
+    size_t nFailure = vStored.size();
+    std::string strFailure;
+    std::vector<std::function<bool()>> vJobs;
+    vJobs.reserve(vStored.size());
+    for (size_t i = 0; i < vStored.size(); i++) {
+        vJobs.emplace_back([&, i]() {
+            if (ShutdownRequested()) {
+                return true;
+            }
+            CBlock block;
+            CBlockUndo blockUndo;
+            std::string strError;
+            if (!CheckStoredBlock(chainparams, vStored[i], nCheckLevel, strError, &block, &blockUndo)) {
+                // Report the failure closest to the tip, as a serial scan would.
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (i < nFailure) {
+                    nFailure = i;
+                    strFailure = strError;
+                }
+                return false;
+            }
+            if (i < vKept.size() && !vStored[i].undoPos.IsNull()) {
+                // The undo data is small next to the block, so only the block is counted.
+                size_t nBytes = RecursiveDynamicUsage(block);
+                if (nKeptBytes.fetch_add(nBytes) + nBytes <= VERIFYDB_KEEP_BYTES) {
+                    vKept[i].fKept = true;
+                    vKept[i].block = std::move(block);
+                    vKept[i].blockUndo = std::move(blockUndo);
+                } else {
+                    nKeptBytes -= nBytes;
+                }
+            }
+            size_t nChecked = ++nDone;
+            int nProgress = (int)((double)nChecked / (double)nCheckDepth * nProgressShare);
+            if (nProgress != (int)((double)(nChecked - 1) / (double)nCheckDepth * nProgressShare)) {
+                uiInterface.ShowProgress(_("Verifying blocks..."), std::max(1, std::min(99, nProgress)));
+            }
+            return true;
+        });
+    }
+    if (nScriptCheckThreads) {
+        CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+        std::vector<CScriptCheck> vChecks;
+        vChecks.reserve(vJobs.size());
+        for (const std::function<bool()>& job : vJobs) {
+            vChecks.emplace_back(&job);
+        }
+        control.Add(vChecks);
+        control.Wait();
+    } else {
+        for (const std::function<bool()>& job : vJobs) {
+            if (!job())
+                break;
+        }
+    }
+    if (nFailure < vStored.size())
+        return error("VerifyDB(): *** %s", strFailure);
+    if (ShutdownRequested())
+        return true;
+    boost::this_thread::interruption_point();
+
+    // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
+    // Kept blocks are used until the first one that was not kept; from there
+    // on the remaining blocks are read ahead by a prefetcher.
+    std::optional<CDisconnectPrefetcher> prefetcher;
+    size_t nLevel3 = 0;
+    for (CBlockIndex* pindex = chainActive.Tip(); nCheckLevel >= 3 && pindex && pindex->pprev; pindex = pindex->pprev, nLevel3++)
     {
         boost::this_thread::interruption_point();
-        uiInterface.ShowProgress(_("Verifying blocks..."), std::max(1, std::min(99, (int)(((double)(chainActive.Height() - pindex->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100)))));
         if (pindex->nHeight < chainActive.Height()-nCheckDepth)
             break;
+        if ((coins.DynamicMemoryUsage() + pcoinsTip->DynamicMemoryUsage()) > nCoinCacheUsage)
+            break;
 
         CBlock block;
-        // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
-            return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
-
-        // check level 1: verify block validity
-        fCheckTransactions = ShouldCheckTransactions(chainparams, pindex);
-        if (nCheckLevel >= 1 && !CheckBlock(block, state, chainparams, verifier, true, true, fCheckTransactions))
-            return error("VerifyDB(): *** found bad block at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
-
-        // check level 2: verify undo validity
-        if (nCheckLevel >= 2 && pindex) {
-            CBlockUndo undo;
-            CDiskBlockPos pos = pindex->GetUndoPos();
-            if (!pos.IsNull()) {
-                if (!UndoReadFromDisk(undo, pos, pindex->pprev->GetBlockHash()))
-                    return error("VerifyDB(): *** found bad undo data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
+        CBlockUndo blockUndo;
+        bool fHaveUndo;
+        if (!prefetcher && nLevel3 < vKept.size() && vKept[nLevel3].fKept) {
+            block = std::move(vKept[nLevel3].block);
+            blockUndo = std::move(vKept[nLevel3].blockUndo);
+            vKept[nLevel3].fKept = false;
+            fHaveUndo = true;
+        } else {
+            if (!prefetcher) {
+                vKept.clear();
+                prefetcher.emplace(chainparams, pindex, chainActive[chainActive.Height() - nCheckDepth - 1]);
             }
+            fHaveUndo = prefetcher->Take(pindex, block, blockUndo);
         }
-
-        // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
-        if (nCheckLevel >= 3 && pindex == pindexState && (coins.DynamicMemoryUsage() + pcoinsTip->DynamicMemoryUsage()) <= nCoinCacheUsage) {
-            // insightexplorer: do not update indices (false)
-            DisconnectResult res = DisconnectBlock(block, state, pindex, coins, chainparams, false);
-            if (res == DISCONNECT_FAILED) {
-                return error("VerifyDB(): *** irrecoverable inconsistency in block data at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
-            }
-            pindexState = pindex->pprev;
-            if (res == DISCONNECT_UNCLEAN) {
-                nGoodTransactions = 0;
-                pindexFailure = pindex;
-            } else {
-                nGoodTransactions += block.vtx.size();
-            }
+        if (!fHaveUndo && !ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
+            return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+        // insightexplorer: do not update indices (false)
+        DisconnectResult res = DisconnectBlock(block, state, pindex, coins, chainparams, false, fHaveUndo ? &blockUndo : nullptr);
+        if (res == DISCONNECT_FAILED) {
+            return error("VerifyDB(): *** irrecoverable inconsistency in block data at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+        }
+        pindexState = pindex->pprev;
+        if (res == DISCONNECT_UNCLEAN) {
+            nGoodTransactions = 0;
+            pindexFailure = pindex;
+        } else {
+            nGoodTransactions += block.vtx.size();
         }
 
         if (ShutdownRequested())
             return true;
     }
+    prefetcher.reset();
+    vKept.clear();
     if (pindexFailure)
         return error("VerifyDB(): *** coin database inconsistencies found (last %i blocks, %i good transactions before that)\n", chainActive.Height() - pindexFailure->nHeight + 1, nGoodTransactions);
 
@@ -6443,23 +7016,27 @@ void UnloadBlockIndex()
     LOCK(cs_main);
     setBlockIndexCandidates.clear();
     chainActive.SetTip(NULL);
+    nActiveHeight = -1;
     pindexBestInvalid = NULL;
     pindexBestHeader = NULL;
     mempool.clear();
     mapOrphanTransactions.clear();
     mapOrphanTransactionsByPrev.clear();
-    nSyncStarted = 0;
     mapBlocksUnlinked.clear();
     vinfoBlockFile.clear();
     nLastBlockFile = 0;
     nBlockSequenceId = 1;
-    mapBlockSource.clear();
-    mapBlocksInFlight.clear();
-    nQueuedValidatedHeaders = 0;
-    nPreferredDownload = 0;
+    {
+        LOCK(cs_nodestate);
+        nSyncStarted = 0;
+        mapBlockSource.clear();
+        mapBlocksInFlight.clear();
+        nQueuedValidatedHeaders = 0;
+        nPreferredDownload = 0;
+        mapNodeState.clear();
+    }
     setDirtyBlockIndex.clear();
     setDirtyFileInfo.clear();
-    mapNodeState.clear();
     recentRejects.reset(NULL);
 
     for (BlockMap::value_type& entry : mapBlockIndex) {
@@ -6469,6 +7046,17 @@ void UnloadBlockIndex()
     fHavePruned = false;
 }
 
+size_t BlockIndexMemoryUsage()
+{
+    LOCK(cs_main);
+    size_t nUsage = memusage::DynamicUsage(mapBlockIndex) +
+        mapBlockIndex.size() * memusage::MallocUsage(sizeof(CBlockIndex));
+    for (const BlockMap::value_type& entry : mapBlockIndex) {
+        nUsage += entry.second->SolutionMemoryUsage();
+    }
+    return nUsage;
+}
+
 bool LoadBlockIndex()
 {
     // Load block index from databases
@@ -7007,12 +7595,19 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
             {
                 // Send stream from relay memory
                 bool push = false;
-                auto mi = mapRelay.find(inv.hash);
-                if (mi != mapRelay.end() && !IsExpiringSoonTx(*mi->second, currentHeight + 1)) {
+                std::shared_ptr<const CTransaction> ptxRelay;
+                {
+                    LOCK(cs_mapRelay);
+                    auto mi = mapRelay.find(inv.hash);
+                    if (mi != mapRelay.end()) {
+                        ptxRelay = mi->second;
+                    }
+                }
+                if (ptxRelay && !IsExpiringSoonTx(*ptxRelay, currentHeight + 1)) {
                     // ZIP 239: MSG_TX should be used if and only if the tx is v4 or earlier.
-                    if ((mi->second->nVersion <= 4) != (inv.type == MSG_TX)) {
+                    if ((ptxRelay->nVersion <= 4) != (inv.type == MSG_TX)) {
                         Misbehaving(pfrom->GetId(), 100);
-                        LogPrint("net", "Wrong INV message type used for v%d tx", mi->second->nVersion);
+                        LogPrint("net", "Wrong INV message type used for v%d tx", ptxRelay->nVersion);
                         // Break so that this inv message will be erased from the queue
                         // (otherwise the peer would repeatedly hit this case until its
                         // Misbehaving level rises above -banscore, no matter what the
@@ -7021,8 +7616,8 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
                     }
                     // Ensure we only reply with a transaction if it is exactly what the
                     // peer requested from us. Otherwise we add it to vNotFound below.
-                    if (inv.hashAux == mi->second->GetAuthDigest()) {
-                        pfrom->PushMessage("tx", *mi->second);
+                    if (inv.hashAux == ptxRelay->GetAuthDigest()) {
+                        pfrom->PushMessage("tx", *ptxRelay);
                         push = true;
                     }
                 } else if (pfrom->timeLastMempoolReq) {
@@ -7260,7 +7855,7 @@ bool static ProcessMessage(const CChainParams& chainparams, CNode* pfrom, string
 
         // Potentially mark this peer as a preferred download peer.
         {
-            LOCK(cs_main);
+            LOCK(cs_nodestate);
             UpdatePreferredDownload(pfrom, State(pfrom->GetId()));
         }
 
@@ -7337,7 +7932,7 @@ bool static ProcessMessage(const CChainParams& chainparams, CNode* pfrom, string
 
     else if (strCommand == "verack")
     {
-        LOCK(cs_main);
+        LOCK(cs_nodestate);
         CNodeState* state = State(pfrom->GetId());
         assert(state != nullptr);
         if (state->fCurrentlyConnected) {
@@ -7503,6 +8098,7 @@ bool static ProcessMessage(const CChainParams& chainparams, CNode* pfrom, string
             LogPrint("net", "got inv: %s  %s peer=%d\n", inv.ToString(), fAlreadyHave ? "have" : "new", pfrom->id);
 
             if (inv.type == MSG_BLOCK) {
+                LOCK(cs_nodestate);
                 UpdateBlockAvailability(pfrom->GetId(), inv.hash);
                 if (!fAlreadyHave && !fImporting && !fReindex && !mapBlocksInFlight.count(inv.hash)) {
                     // Headers-first is the primary method of announcement on
@@ -7808,7 +8404,7 @@ bool static ProcessMessage(const CChainParams& chainparams, CNode* pfrom, string
                 Misbehaving(pfrom->GetId(), 20);
                 return error("non-continuous headers sequence");
             }
-            if (!AcceptBlockHeader(header, state, chainparams, &pindexLast)) {
+            if (!AcceptBlockHeader(header, state, chainparams, &pindexLast, pfrom->GetId())) {
                 int nDoS;
                 if (state.IsInvalid(nDoS)) {
                     if (nDoS > 0)
@@ -7818,8 +8414,10 @@ bool static ProcessMessage(const CChainParams& chainparams, CNode* pfrom, string
             }
         }
 
-        if (pindexLast)
+        if (pindexLast) {
+            LOCK(cs_nodestate);
             UpdateBlockAvailability(pfrom->GetId(), pindexLast->GetBlockHash());
+        }
 
         // Temporary, until we're sure the optimization works
         if (nCount == MAX_HEADERS_RESULTS && pindexLast && !hasNewHeaders) {
@@ -8310,13 +8908,11 @@ bool SendMessages(const Consensus::Params& params, CNode* pto)
             }
         }
 
-        TRY_LOCK(cs_main, lockMain); // Acquire cs_main for IsInitialBlockDownload() and CNodeState()
-        if (!lockMain)
-            return true;
-
-        // Address refresh broadcast
+        // Address refresh broadcast. IsInitialBlockDownload takes cs_main
+        // until IBD has finished, so only look at its latch here. It is set
+        // by the next call from validation once the node has caught up.
         int64_t nNow = GetTimeMicros();
-        if (!IsInitialBlockDownload(params) && pto->nNextLocalAddrSend < nNow) {
+        if (pto->nNextLocalAddrSend < nNow && IBDLatchToFalse.load(std::memory_order_relaxed)) {
             AdvertizeLocal(pto);
             pto->nNextLocalAddrSend = PoissonNextSend(nNow, AVG_LOCAL_ADDRESS_BROADCAST_INTERVAL);
         }
@@ -8346,8 +8942,29 @@ bool SendMessages(const Consensus::Params& params, CNode* pto)
                 pto->PushMessage("addr", vAddr);
         }
 
-        CNodeState &state = *State(pto->GetId());
-        if (state.fShouldBan) {
+        // Per-peer state. The steps below that need the chain take cs_main,
+        // and are skipped for a peer that has nothing for us to download.
+        bool fShouldBan;
+        bool fFetch;
+        bool fStartSync;
+        bool fCheckDownload;
+        std::vector<CBlockReject> rejects;
+        {
+            LOCK(cs_nodestate);
+            CNodeState &state = *State(pto->GetId());
+            fShouldBan = state.fShouldBan;
+            state.fShouldBan = false;
+            rejects.swap(state.rejects);
+            fFetch = state.fPreferredDownload || (nPreferredDownload == 0 && !pto->fClient && !pto->fOneShot); // Download if this is a nice peer, or we have no nice peers and this one might do.
+            fStartSync = !state.fSyncStarted && !pto->fClient && !fImporting && !fReindex;
+            // Once we have the best block the peer announced, FindNextBlocksToDownload
+            // has nothing to return for it until it announces another one.
+            bool fNothingToFetch = pto->fClient || (state.hashLastUnknownBlock.IsNull() &&
+                (state.pindexBestKnownBlock == NULL || state.pindexBestKnownBlock == state.pindexLastCommonBlock));
+            fCheckDownload = state.nStallingSince != 0 || !state.vBlocksInFlight.empty() || !fNothingToFetch;
+        }
+
+        if (fShouldBan) {
             if (pto->fWhitelisted)
                 LogPrintf("Warning: not punishing whitelisted peer %s!\n", pto->addr.ToString());
             else {
@@ -8359,43 +8976,51 @@ bool SendMessages(const Consensus::Params& params, CNode* pto)
                     CNode::Ban(pto->addr, BanReasonNodeMisbehaving);
                 }
             }
-            state.fShouldBan = false;
         }
 
-        for (const CBlockReject& reject : state.rejects)
+        for (const CBlockReject& reject : rejects)
             pto->PushMessage("reject", (string)"block", reject.chRejectCode, reject.strRejectReason, reject.hashBlock);
-        state.rejects.clear();
 
         // Start block sync
-        if (pindexBestHeader == NULL)
-            pindexBestHeader = chainActive.Tip();
-        bool fFetch = state.fPreferredDownload || (nPreferredDownload == 0 && !pto->fClient && !pto->fOneShot); // Download if this is a nice peer, or we have no nice peers and this one might do.
-        if (!state.fSyncStarted && !pto->fClient && !fImporting && !fReindex) {
-            // Only actively request headers from a single peer, unless we're close to today.
-            if ((nSyncStarted == 0 && fFetch) || pindexBestHeader->GetBlockTime() > GetTime() - 24 * 60 * 60) {
-                state.fSyncStarted = true;
-                nSyncStarted++;
-                const CBlockIndex *pindexStart = pindexBestHeader;
-                /* If possible, start at the block preceding the currently
-                   best known header.  This ensures that we always get a
-                   non-empty list of headers back as long as the peer
-                   is up-to-date.  With a non-empty response, we can initialise
-                   the peer's known best block.  This wouldn't be possible
-                   if we requested starting at pindexBestHeader and
-                   got back an empty response.  */
-                if (pindexStart->pprev)
-                    pindexStart = pindexStart->pprev;
-                LogPrint("net", "initial getheaders (%d) to peer=%d (startheight:%d)\n", pindexStart->nHeight, pto->id, pto->nStartingHeight);
-                pto->PushMessage("getheaders", chainActive.GetLocator(pindexStart), uint256());
+        if (fStartSync) {
+            TRY_LOCK(cs_main, lockMain);
+            if (lockMain) {
+                LOCK(cs_nodestate);
+                CNodeState &state = *State(pto->GetId());
+                if (pindexBestHeader == NULL)
+                    pindexBestHeader = chainActive.Tip();
+                // Only actively request headers from a single peer, unless we're close to today.
+                if (!state.fSyncStarted && ((nSyncStarted == 0 && fFetch) || pindexBestHeader->GetBlockTime() > GetTime() - 24 * 60 * 60)) {
+                    state.fSyncStarted = true;
+                    nSyncStarted++;
+                    const CBlockIndex *pindexStart = pindexBestHeader;
+                    /* If possible, start at the block preceding the currently
+                       best known header.  This ensures that we always get a
+                       non-empty list of headers back as long as the peer
+                       is up-to-date.  With a non-empty response, we can initialise
+                       the peer's known best block.  This wouldn't be possible
+                       if we requested starting at pindexBestHeader and
+                       got back an empty response.  */
+                    if (pindexStart->pprev)
+                        pindexStart = pindexStart->pprev;
+                    LogPrint("net", "initial getheaders (%d) to peer=%d (startheight:%d)\n", pindexStart->nHeight, pto->id, pto->nStartingHeight);
+                    pto->PushMessage("getheaders", chainActive.GetLocator(pindexStart), uint256());
+                }
             }
         }
 
         // Resend wallet transactions that haven't gotten in a block yet
         // Except during reindex, importing and IBD, when old wallet
         // transactions become unconfirmed and spams other nodes.
-        if (!fReindex && !fImporting && !IsInitialBlockDownload(params))
+        // The wallet decides itself when to resend, so it is asked once a
+        // second rather than once per peer, which keeps cs_main off this path.
+        if (!fReindex && !fImporting && nNow >= nNextWalletBroadcast)
         {
-            GetMainSignals().Broadcast(nTimeBestReceived);
+            TRY_LOCK(cs_main, lockMain);
+            if (lockMain && !IsInitialBlockDownload(params)) {
+                nNextWalletBroadcast = nNow + 1000000;
+                GetMainSignals().Broadcast(nTimeBestReceived);
+            }
         }
 
         //
@@ -8436,7 +9061,7 @@ bool SendMessages(const Consensus::Params& params, CNode* pto)
                 if (!pto->fRelayTxes) pto->setInventoryTxToSend.clear();
             }
 
-            int currentHeight = GetHeight();
+            int currentHeight = nActiveHeight;
 
             // Respond to BIP35 mempool requests
             if (fSendTrickle && pto->fSendMempool) {
@@ -8511,6 +9136,7 @@ bool SendMessages(const Consensus::Params& params, CNode* pto)
                     vInv.push_back(inv);
                     nRelayedTransactions++;
                     {
+                        LOCK(cs_mapRelay);
                         // Expire old relay messages
                         while (!vRelayExpiration.empty() && vRelayExpiration.front().first < nNow)
                         {
@@ -8534,56 +9160,66 @@ bool SendMessages(const Consensus::Params& params, CNode* pto)
         if (!vInv.empty())
             pto->PushMessage("inv", vInv);
 
-        // Detect whether we're stalling
+        // Detect whether we're stalling, and request blocks
+        vector<CInv> vGetData;
         nNow = GetTimeMicros();
-        if (!pto->fDisconnect && state.nStallingSince && state.nStallingSince < nNow - 1000000 * BLOCK_STALLING_TIMEOUT) {
-            // Stalling only triggers when the block download window cannot move. During normal steady state,
-            // the download window should be much larger than the to-be-downloaded set of blocks, so disconnection
-            // should only happen during initial block download.
-            LogPrintf("Peer=%d is stalling block download, disconnecting\n", pto->id);
-            pto->fDisconnect = true;
-        }
-        // In case there is a block that has been in flight from this peer for (2 + 0.5 * N) times the block interval
-        // (with N the number of validated blocks that were in flight at the time it was requested), disconnect due to
-        // timeout. We compensate for in-flight blocks to prevent killing off peers due to our own downstream link
-        // being saturated. We only count validated in-flight blocks so peers can't advertise non-existing block hashes
-        // to unreasonably increase our timeout.
-        // We also compare the block download timeout originally calculated against the time at which we'd disconnect
-        // if we assumed the block were being requested now (ignoring blocks we've requested from this peer, since we're
-        // only looking at this peer's oldest request).  This way a large queue in the past doesn't result in a
-        // permanently large window for this block to be delivered (ie if the number of blocks in flight is decreasing
-        // more quickly than once every 5 minutes, then we'll shorten the download window for this block).
-        if (!pto->fDisconnect && state.vBlocksInFlight.size() > 0) {
-            QueuedBlock &queuedBlock = state.vBlocksInFlight.front();
-            int64_t nTimeoutIfRequestedNow = GetBlockTimeout(nNow, nQueuedValidatedHeaders - state.nBlocksInFlightValidHeaders, params, pindexBestHeader->nHeight);
-            if (queuedBlock.nTimeDisconnect > nTimeoutIfRequestedNow) {
-                LogPrint("net", "Reducing block download timeout for peer=%d block=%s, orig=%d new=%d\n", pto->id, queuedBlock.hash.ToString(), queuedBlock.nTimeDisconnect, nTimeoutIfRequestedNow);
-                queuedBlock.nTimeDisconnect = nTimeoutIfRequestedNow;
-            }
-            if (queuedBlock.nTimeDisconnect < nNow) {
-                LogPrintf("Timeout downloading block %s from peer=%d, disconnecting\n", queuedBlock.hash.ToString(), pto->id);
-                pto->fDisconnect = true;
-            }
-        }
+        if (fCheckDownload) {
+            TRY_LOCK(cs_main, lockMain);
+            if (lockMain) {
+                LOCK(cs_nodestate);
+                CNodeState &state = *State(pto->GetId());
+                if (pindexBestHeader == NULL)
+                    pindexBestHeader = chainActive.Tip();
+                // Detect whether we're stalling
+                if (!pto->fDisconnect && state.nStallingSince && state.nStallingSince < nNow - 1000000 * BLOCK_STALLING_TIMEOUT) {
+                    // Stalling only triggers when the block download window cannot move. During normal steady state,
+                    // the download window should be much larger than the to-be-downloaded set of blocks, so disconnection
+                    // should only happen during initial block download.
+                    LogPrintf("Peer=%d is stalling block download, disconnecting\n", pto->id);
+                    pto->fDisconnect = true;
+                }
+                // In case there is a block that has been in flight from this peer for (2 + 0.5 * N) times the block interval
+                // (with N the number of validated blocks that were in flight at the time it was requested), disconnect due to
+                // timeout. We compensate for in-flight blocks to prevent killing off peers due to our own downstream link
+                // being saturated. We only count validated in-flight blocks so peers can't advertise non-existing block hashes
+                // to unreasonably increase our timeout.
+                // We also compare the block download timeout originally calculated against the time at which we'd disconnect
+                // if we assumed the block were being requested now (ignoring blocks we've requested from this peer, since we're
+                // only looking at this peer's oldest request).  This way a large queue in the past doesn't result in a
+                // permanently large window for this block to be delivered (ie if the number of blocks in flight is decreasing
+                // more quickly than once every 5 minutes, then we'll shorten the download window for this block).
+                if (!pto->fDisconnect && state.vBlocksInFlight.size() > 0) {
+                    QueuedBlock &queuedBlock = state.vBlocksInFlight.front();
+                    int64_t nTimeoutIfRequestedNow = GetBlockTimeout(nNow, nQueuedValidatedHeaders - state.nBlocksInFlightValidHeaders, params, pindexBestHeader->nHeight);
+                    if (queuedBlock.nTimeDisconnect > nTimeoutIfRequestedNow) {
+                        LogPrint("net", "Reducing block download timeout for peer=%d block=%s, orig=%d new=%d\n", pto->id, queuedBlock.hash.ToString(), queuedBlock.nTimeDisconnect, nTimeoutIfRequestedNow);
+                        queuedBlock.nTimeDisconnect = nTimeoutIfRequestedNow;
+                    }
+                    if (queuedBlock.nTimeDisconnect < nNow) {
+                        LogPrintf("Timeout downloading block %s from peer=%d, disconnecting\n", queuedBlock.hash.ToString(), pto->id);
+                        pto->fDisconnect = true;
+                    }
+                }
 
-        //
-        // Message: getdata (blocks)
-        //
-        vector<CInv> vGetData;
-        if (!pto->fDisconnect && !pto->fClient && (fFetch || !IsInitialBlockDownload(params)) && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
-            vector<CBlockIndex*> vToDownload;
-            NodeId staller = -1;
-            FindNextBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller);
-            for (CBlockIndex *pindex : vToDownload) {
-                vGetData.push_back(CInv(MSG_BLOCK, pindex->GetBlockHash()));
-                MarkBlockAsInFlight(pto->GetId(), pindex->GetBlockHash(), params, pindex);
-                LogPrint("net", "Requesting block %s (%d) peer=%d\n", pindex->GetBlockHash().ToString(),
-                    pindex->nHeight, pto->id);
-            }
-            if (state.nBlocksInFlight == 0 && staller != -1) {
-                if (State(staller)->nStallingSince == 0) {
-                    State(staller)->nStallingSince = nNow;
-                    LogPrint("net", "Stall started peer=%d\n", staller);
+                //
+                // Message: getdata (blocks)
+                //
+                if (!pto->fDisconnect && !pto->fClient && (fFetch || !IsInitialBlockDownload(params)) && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+                    vector<CBlockIndex*> vToDownload;
+                    NodeId staller = -1;
+                    FindNextBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller);
+                    for (CBlockIndex *pindex : vToDownload) {
+                        vGetData.push_back(CInv(MSG_BLOCK, pindex->GetBlockHash()));
+                        MarkBlockAsInFlight(pto->GetId(), pindex->GetBlockHash(), params, pindex);
+                        LogPrint("net", "Requesting block %s (%d) peer=%d\n", pindex->GetBlockHash().ToString(),
+                            pindex->nHeight, pto->id);
+                    }
+                    if (state.nBlocksInFlight == 0 && staller != -1) {
+                        if (State(staller)->nStallingSince == 0) {
+                            State(staller)->nStallingSince = nNow;
+                            LogPrint("net", "Stall started peer=%d\n", staller);
+                        }
+                    }
                 }
             }
         }
@@ -8591,24 +9227,27 @@ bool SendMessages(const Consensus::Params& params, CNode* pto)
         //
         // Message: getdata (non-blocks)
         //
-        while (!pto->fDisconnect && !pto->mapAskFor.empty() && (*pto->mapAskFor.begin()).first <= nNow)
-        {
-            const CInv& inv = (*pto->mapAskFor.begin()).second;
-            if (!AlreadyHave(inv))
+        if (!pto->fDisconnect && !pto->mapAskFor.empty() && (*pto->mapAskFor.begin()).first <= nNow) {
+            TRY_LOCK(cs_main, lockMain); // Acquire cs_main for AlreadyHave()
+            while (lockMain && !pto->fDisconnect && !pto->mapAskFor.empty() && (*pto->mapAskFor.begin()).first <= nNow)
             {
-                if (fDebug)
-                    LogPrint("net", "Requesting %s peer=%d\n", inv.ToString(), pto->id);
-                vGetData.push_back(inv);
-                if (vGetData.size() >= 1000)
+                const CInv& inv = (*pto->mapAskFor.begin()).second;
+                if (!AlreadyHave(inv))
                 {
-                    pto->PushMessage("getdata", vGetData);
-                    vGetData.clear();
+                    if (fDebug)
+                        LogPrint("net", "Requesting %s peer=%d\n", inv.ToString(), pto->id);
+                    vGetData.push_back(inv);
+                    if (vGetData.size() >= 1000)
+                    {
+                        pto->PushMessage("getdata", vGetData);
+                        vGetData.clear();
+                    }
+                } else {
+                    //If we're not going to ask, don't expect a response.
+                    pto->setAskFor.erase(WTxId(inv.hash, inv.hashAux));
                 }
-            } else {
-                //If we're not going to ask, don't expect a response.
-                pto->setAskFor.erase(WTxId(inv.hash, inv.hashAux));
+                pto->mapAskFor.erase(pto->mapAskFor.begin());
             }
-            pto->mapAskFor.erase(pto->mapAskFor.begin());
         }
         if (!vGetData.empty())
             pto->PushMessage("getdata", vGetData);
@@ -35,6 +35,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <functional>
 #include <map>
 #include <optional>
 #include <set>
@@ -50,6 +51,7 @@
 
 class CBlockIndex;
 class CBlockTreeDB;
+class CBlockUndo;
 class CBloomFilter;
 class CChainParams;
 class CInv;
@@ -78,6 +80,11 @@ static const CAmount HIGH_TX_FEE_PER_KB = 0.01 * COIN;
 static const CAmount HIGH_MAX_TX_FEE = 100 * HIGH_TX_FEE_PER_KB;
 //! -maxtxfee will error if called with a fee that won’t allow tx to have this many actions
 static const unsigned int LOW_LOGICAL_ACTIONS = 10;
+/**
+ * Script verification flags that blocks are checked with. DERSIG (BIP66) is
+ * also always enforced, but does not have a flag.
+ */
+static const unsigned int BLOCK_SCRIPT_VERIFY_FLAGS = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY;
 /** Default for -maxorphantx, maximum number of orphan transactions kept in memory */
 static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
 /** Expiration time for orphan transactions in seconds */
@@ -147,6 +154,15 @@ static const int64_t DEFAULT_MAX_TIP_AGE = 24 * 60 * 60;
 static const bool DEFAULT_PERMIT_BAREMULTISIG = true;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 static const bool DEFAULT_IBD_SKIP_TX_VERIFICATION = false;
+/**
+ * Maximum number of headers whose RandomX check is deferred under
+ * -assumevalid. Headers beyond it are checked when they are received.
+ */
+static const size_t MAX_DEFERRED_POW_HEADERS = 500000;
+/** Maximum number of headers from one peer whose deferred RandomX check is pending. */
+static const size_t MAX_DEFERRED_POW_HEADERS_PER_PEER = 50000;
+/** One in this many headers that could be deferred is checked on receipt instead. */
+static const uint64_t DEFERRED_POW_SPOT_CHECK_INTERVAL = 16;
 static const bool DEFAULT_TXINDEX = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 
@@ -210,6 +226,8 @@ extern bool fIsBareMultisigStd;
 extern bool fCheckBlockIndex;
 extern bool fCheckpointsEnabled;
 extern bool fIBDSkipTxVerification;
+/** Block whose header chain is assumed to have valid proof of work (-assumevalid). */
+extern uint256 hashAssumeValid;
 // TODO: remove this flag by structuring our code such that
 // it is unneeded for testing
 extern bool fCoinbaseEnforcedShieldingEnabled;
@@ -304,6 +322,11 @@ bool ProcessMessages(const CChainParams& chainparams, CNode* pfrom);
 bool SendMessages(const Consensus::Params& params, CNode* pto);
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/**
+ * Run jobs on the script checking threads and wait for them. Returns false
+ * without running them if the queue is in use. See TransactionHashRunner.
+ */
+bool RunOnScriptCheckQueue(const std::vector<std::function<bool()>>& vJobs);
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload(const Consensus::Params& params);
 /** testing-only, set or reset initial block down (IBD) state, return previous */
@@ -512,12 +535,21 @@ private:
     // We store a pointer instead of a reference here, to allow it to be null for
     // performance reasons (enabling fast swaps in CCheckQueue::Loop).
     PrecomputedTransactionData *txdata;
+    // Other work run on the script check threads instead of a script check
+    // (see CFunctionCheck). Not owned; the caller keeps it alive until the
+    // queue has finished.
+    const std::function<bool()> *job;
 
 public:
-    CScriptCheck(): amount(0), ptxTo(0), nIn(0), nFlags(0), cacheStore(false), consensusBranchId(0), error(SCRIPT_ERR_UNKNOWN_ERROR) {}
+    CScriptCheck(): amount(0), ptxTo(0), nIn(0), nFlags(0), cacheStore(false), consensusBranchId(0), error(SCRIPT_ERR_UNKNOWN_ERROR), job(nullptr) {}
     CScriptCheck(const CCoins& txFromIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, uint32_t consensusBranchIdIn, PrecomputedTransactionData* txdataIn) :
         scriptPubKey(txFromIn.vout[txToIn.vin[nInIn].prevout.n].scriptPubKey), amount(txFromIn.vout[txToIn.vin[nInIn].prevout.n].nValue),
-        ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), consensusBranchId(consensusBranchIdIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn) { }
+        ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), consensusBranchId(consensusBranchIdIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn), job(nullptr) { }
+    CScriptCheck(const CTxOut& outIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, uint32_t consensusBranchIdIn, PrecomputedTransactionData* txdataIn) :
+        scriptPubKey(outIn.scriptPubKey), amount(outIn.nValue),
+        ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), consensusBranchId(consensusBranchIdIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn), job(nullptr) { }
+    explicit CScriptCheck(const std::function<bool()>* jobIn) :
+        amount(0), ptxTo(0), nIn(0), nFlags(0), cacheStore(false), consensusBranchId(0), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(nullptr), job(jobIn) { }
 
     bool operator()();
 
@@ -531,6 +563,7 @@ public:
         std::swap(consensusBranchId, check.consensusBranchId);
         std::swap(error, check.error);
         std::swap(txdata, check.txdata);
+        std::swap(job, check.job);
     }
 
     ScriptError GetScriptError() const { return error; }
@@ -625,6 +658,34 @@ bool RegenerateSubtrees(ShieldedType type, const Consensus::Params& consensusPar
  */
 bool RewindBlockIndex(const CChainParams& chainparams, bool& clearWitnessCaches);
 
+/** Where a block of the active chain and its undo data are stored. */
+struct CStoredBlock {
+    int nHeight;
+    uint256 hash;
+    uint256 hashPrev;
+    CDiskBlockPos blockPos;
+    CDiskBlockPos undoPos;
+    bool fCheckTransactions;
+};
+
+/** Copies the storage details of a block out of the block index. Requires cs_main. */
+CStoredBlock GetStoredBlock(const CChainParams& chainparams, const CBlockIndex* pindex);
+
+/**
+ * Runs the checks of -checklevel 0 to 2 on a stored block: reads the block,
+ * runs the context-free block checks, and reads the undo data and checks it
+ * against the block. Does not need cs_main. Returns false and sets strError
+ * on failure. On success the block, and the undo data if it was read, are
+ * moved into pblockOut and pblockUndoOut when given.
+ */
+bool CheckStoredBlock(
+    const CChainParams& chainparams,
+    const CStoredBlock& stored,
+    int nCheckLevel,
+    std::string& strError,
+    CBlock* pblockOut = nullptr,
+    CBlockUndo* pblockUndoOut = nullptr);
+
 /** RAII wrapper for VerifyDB: Verify consistency of the block and coin databases */
 class CVerifyDB {
 public:
@@ -642,6 +703,28 @@ bool InvalidateBlock(CValidationState& state, const CChainParams& chainparams, C
 /** Remove invalidity status from a block and its descendants. */
 bool ReconsiderBlock(CValidationState& state, CBlockIndex *pindex);
 
+/**
+ * Returns true if pindex is the -assumevalid block or one of its ancestors,
+ * and that block has at least nMinimumChainWork. Requires cs_main.
+ */
+bool IsAssumedValidHeader(const Consensus::Params& consensusParams, const CBlockIndex* pindex);
+
+/** Returns up to nMax headers whose RandomX check was deferred, lowest first. Requires cs_main. */
+std::vector<CBlockIndex*> GetDeferredPoWHeaders(size_t nMax);
+
+/**
+ * Records the outcome of a deferred RandomX check. A header that passed loses
+ * its BLOCK_POW_UNVERIFIED mark; one that failed keeps it and must be
+ * invalidated by the caller. Requires cs_main.
+ */
+void FinishDeferredPoWCheck(CBlockIndex* pindex, bool fValid);
+
+/** Estimated memory held by the block index, in bytes. */
+size_t BlockIndexMemoryUsage();
+
+/** Estimated memory held by orphan transactions and their indexes, in bytes. */
+size_t OrphanPoolMemoryUsage();
+
 /** The currently-connected chain of blocks (protected by cs_main). */
 extern CChain chainActive;
 
@@ -0,0 +1,256 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#if defined(HAVE_CONFIG_H)
+#include "config/bitcoin-config.h"
+#endif
+
+#include "memorybudget.h"
+
+#include "chainparams.h"
+#include "coins.h"
+#include "crypto/randomx_wrapper.h"
+#include "main.h"
+#include "net.h"
+#include "sync.h"
+#include "txdb.h"
+#include "txmempool.h"
+#include "util/system.h"
+#ifdef ENABLE_WALLET
+#include "wallet/wallet.h"
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <rust/metrics.h>
+
+namespace {
+
+CCriticalSection cs_memoryBudgets;
+MemoryBudgets budgets;
+
+#if defined(__linux__)
+// Returns the single number stored in a cgroup control file, or -1 if the
+// file is missing or holds "max".
+int64_t ReadCgroupValue(const char* path)
+{
+    std::ifstream file(path);
+    int64_t nValue;
+    if (file >> nValue) {
+        return nValue;
+    }
+    return -1;
+}
+
+int64_t ReadMemAvailable()
+{
+    std::ifstream file("/proc/meminfo");
+    std::string key;
+    int64_t nValue;
+    std::string unit;
+    while (file >> key >> nValue >> unit) {
+        if (key == "MemAvailable:") {
+            return nValue * 1024;
+        }
+    }
+    return -1;
+}
+#endif
+
+}
+
+int64_t GetAvailableMemory()
+{
+    int64_t nAvailable = -1;
+#if defined(__linux__)
+    nAvailable = ReadMemAvailable();
+
+    // cgroup v2, then v1. The usage includes reclaimable page cache, so this
+    // errs on the side of leaving memory unused.
+    int64_t nLimit = ReadCgroupValue("/sys/fs/cgroup/memory.max");
+    int64_t nUsage = ReadCgroupValue("/sys/fs/cgroup/memory.current");
+    if (nLimit < 0) {
+        nLimit = ReadCgroupValue("/sys/fs/cgroup/memory/memory.limit_in_bytes");
+        nUsage = ReadCgroupValue("/sys/fs/cgroup/memory/memory.usage_in_bytes");
+    }
+    // cgroup v1 reports a huge page-aligned value when there is no limit.
+    if (nLimit > 0 && nLimit < (int64_t(1) << 60) && nUsage >= 0) {
+        int64_t nHeadroom = std::max<int64_t>(0, nLimit - nUsage);
+        nAvailable = nAvailable < 0 ? nHeadroom : std::min(nAvailable, nHeadroom);
+    }
+#endif
+    return nAvailable;
+}
+
+int64_t ComputeCoinCacheLimit(
+    bool fInitialDownload,
+    int64_t nAvailable,
+    int64_t nCoinCacheUsage,
+    int64_t nCoinCacheBase,
+    int64_t nReserved)
+{
+    if (nAvailable < 0) {
+        return nCoinCacheBase;
+    }
+    int64_t nUsable = nAvailable + nCoinCacheUsage - nReserved - MEMORY_GOVERNOR_SAFETY_MARGIN;
+    if (fInitialDownload) {
+        // Grow into free memory, but never below what -dbcache would give.
+        return std::max(nCoinCacheBase, std::min(nUsable, MAX_AUTO_COIN_CACHE));
+    }
+    // Back to the -dbcache split, and below it only under memory pressure.
+    return std::max(nMinDbCache << 20, std::min(nCoinCacheBase, nUsable));
+}
+
+int64_t MempoolMemoryLimit(int64_t nCostLimit, int64_t nUsage, int64_t nCost)
+{
+    if (nCost < MIN_MEMPOOL_COST_SAMPLE) {
+        return nCostLimit;
+    }
+    return (int64_t)(nCostLimit * ((double)nUsage / nCost));
+}
+
+void InitMemoryGovernor(
+    bool fAuto,
+    int64_t nBlockTreeDBCache,
+    int64_t nCoinDBCache,
+    int64_t nCoinCacheBase,
+    int64_t nMempoolCostLimit)
+{
+    LOCK(cs_memoryBudgets);
+    budgets.fAuto = fAuto;
+    budgets.nBlockTreeDBCache = nBlockTreeDBCache;
+    budgets.nCoinDBCache = nCoinDBCache;
+    budgets.nCoinCacheBase = nCoinCacheBase;
+    budgets.nCoinCacheLimit = nCoinCacheBase;
+    budgets.nMempoolCostLimit = nMempoolCostLimit;
+    budgets.nMempoolLimit = nMempoolCostLimit;
+}
+
+// Fills in the measured fields of a copy of the budgets. Returns false if
+// the chain state is not loaded yet.
+static bool MeasureMemoryBudgets(MemoryBudgets& measured)
+{
+    bool fInitialDownload = IsInitialBlockDownload(Params().GetConsensus());
+    int64_t nAvailable = GetAvailableMemory();
+    int64_t nMempoolUsage = mempool.DynamicMemoryUsage();
+    int64_t nMempoolCost = mempool.GetTotalCost();
+    int64_t nRandomXUsage = RandomX_CacheMemoryUsage();
+
+    LOCK2(cs_main, cs_memoryBudgets);
+    measured = budgets;
+    if (pcoinsTip == nullptr) {
+        return false;
+    }
+
+    // The mempool is idle during IBD, so its budget is lent to the UTXO
+    // cache until the node catches up. Keep room for one more RandomX cache,
+    // which is allocated before an old one is evicted at an epoch change.
+    int64_t nMempoolLimit = MempoolMemoryLimit(budgets.nMempoolCostLimit, nMempoolUsage, nMempoolCost);
+    int64_t nReserved = RandomX_CacheSize();
+    if (!fInitialDownload) {
+        nReserved += std::max<int64_t>(0, nMempoolLimit - nMempoolUsage);
+    }
+
+    measured.fInitialDownload = fInitialDownload;
+    measured.nAvailable = nAvailable;
+    measured.nCoinCacheUsage = pcoinsTip->DynamicMemoryUsage();
+    measured.nMempoolLimit = nMempoolLimit;
+    measured.nMempoolUsage = nMempoolUsage;
+    measured.nRandomXUsage = nRandomXUsage;
+    measured.nReserved = nReserved;
+    return true;
+}
+
+void UpdateMemoryBudgets()
+{
+    MemoryBudgets measured;
+    if (!MeasureMemoryBudgets(measured)) {
+        return;
+    }
+
+    LOCK2(cs_main, cs_memoryBudgets);
+    measured.nCoinCacheLimit = budgets.nCoinCacheLimit;
+    budgets = measured;
+
+    if (!budgets.fAuto) {
+        return;
+    }
+    bool fInitialDownload = budgets.fInitialDownload;
+    int64_t nAvailable = budgets.nAvailable;
+    int64_t nLimit = ComputeCoinCacheLimit(
+        fInitialDownload, nAvailable, budgets.nCoinCacheUsage, budgets.nCoinCacheBase, budgets.nReserved);
+    // Ignore small fluctuations in available memory.
+    int64_t nCurrent = nCoinCacheUsage;
+    if (std::abs(nLimit - nCurrent) * 10 > nCurrent) {
+        LogPrintf("Memory governor: in-memory UTXO set limit %.1fMiB -> %.1fMiB (%s, %.1fMiB available)\n",
+            nCurrent * (1.0 / 1024 / 1024), nLimit * (1.0 / 1024 / 1024),
+            fInitialDownload ? "initial block download" : "synced",
+            nAvailable * (1.0 / 1024 / 1024));
+        nCoinCacheUsage = nLimit;
+    }
+    budgets.nCoinCacheLimit = nCoinCacheUsage;
+}
+
+MemoryBudgets GetMemoryBudgets()
+{
+    MemoryBudgets measured;
+    MeasureMemoryBudgets(measured);
+    return measured;
+}
+
+MemoryUsage GetMemoryUsage(bool fDetailed)
+{
+    MemoryUsage usage;
+    if (fDetailed) {
+        usage.nBlockIndex = BlockIndexMemoryUsage();
+    }
+    {
+        LOCK(cs_main);
+        if (pcoinsTip != nullptr) {
+            usage.nCoinsCache = pcoinsTip->DynamicMemoryUsage();
+            usage.nCoinsDB = pcoinsTip->DatabaseMemoryUsage();
+        }
+        if (pblocktree != nullptr) {
+            usage.nBlockTreeDB = pblocktree->DynamicMemoryUsage();
+        }
+    }
+    usage.nMempool = mempool.DynamicMemoryUsage();
+    usage.nMempoolIndexes = mempool.IndexMemoryUsage();
+    usage.nOrphans = OrphanPoolMemoryUsage();
+    usage.nRandomXCaches = RandomX_CacheMemoryUsage();
+    usage.nRandomXVMs = RandomX_VMMemoryUsage();
+    usage.nPeerBuffers = PeerBufferMemoryUsage();
+#ifdef ENABLE_WALLET
+    if (pwalletMain != nullptr) {
+        usage.fWallet = true;
+        if (fDetailed) {
+            usage.nWalletTransactions = pwalletMain->TransactionsMemoryUsage();
+        }
+        usage.nWalletOrchardTree = pwalletMain->OrchardTreeMemoryUsage();
+        usage.nWalletScanners = WalletBatchScanner::TotalMemoryUsage();
+    }
+#endif
+    return usage;
+}
+
+void UpdateMemoryMetrics()
+{
+    MemoryUsage usage = GetMemoryUsage(false);
+    MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nCoinsCache, "component", "coins_cache");
+    MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nMempool, "component", "mempool");
+    MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nMempoolIndexes, "component", "mempool_indexes");
+    MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nOrphans, "component", "orphans");
+    MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nRandomXCaches, "component", "randomx_caches");
+    MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nRandomXVMs, "component", "randomx_vms");
+    MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nPeerBuffers, "component", "peer_buffers");
+    MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nBlockTreeDB, "component", "block_tree_db");
+    MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nCoinsDB, "component", "coins_db");
+    if (usage.fWallet) {
+        MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nWalletOrchardTree, "component", "wallet_orchard_tree");
+        MetricsGauge("zcashd.memory.usage.bytes", (double)usage.nWalletScanners, "component", "wallet_scanners");
+    }
+}
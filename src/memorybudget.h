@@ -0,0 +1,134 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_MEMORYBUDGET_H
+#define BITCOIN_MEMORYBUDGET_H
+
+#include <stdint.h>
+
+/**
+ * Memory governor for -dbcache=auto.
+ *
+ * The -dbcache split is fixed at startup, but the in-memory UTXO cache only
+ * pays off during initial block download. With -dbcache=auto the governor
+ * periodically sizes that cache from the memory that is actually available
+ * (taking cgroup limits into account): during IBD it grows into whatever is
+ * free after setting aside room for RandomX caches and a safety margin, and
+ * once the node has caught up it shrinks back to the -dbcache default so the
+ * memory goes to the mempool, the wallet and RandomX instead. Shrinking takes
+ * effect at the next chainstate flush.
+ */
+
+/** How often the budgets are re-evaluated, in seconds. */
+static const int64_t MEMORY_GOVERNOR_INTERVAL = 30;
+/** Memory left untouched for the rest of the process, in bytes. */
+static const int64_t MEMORY_GOVERNOR_SAFETY_MARGIN = int64_t(512) << 20;
+/** Largest in-memory UTXO cache the governor hands out, in bytes. */
+static const int64_t MAX_AUTO_COIN_CACHE = int64_t(16384) << 20;
+/**
+ * Mempool cost below which its memory usage per cost unit is not trusted, and
+ * one byte per cost unit is assumed instead.
+ */
+static const int64_t MIN_MEMPOOL_COST_SAMPLE = 1000000;
+
+/** Snapshot of the governor's state, for getmemoryinfo. All sizes in bytes. */
+struct MemoryBudgets {
+    bool fAuto = false;
+    bool fInitialDownload = false;
+    //! Memory the process can still allocate, or -1 if unknown.
+    int64_t nAvailable = -1;
+    int64_t nBlockTreeDBCache = 0;
+    int64_t nCoinDBCache = 0;
+    //! In-memory UTXO cache derived from -dbcache; the steady-state target.
+    int64_t nCoinCacheBase = 0;
+    //! Current in-memory UTXO cache limit.
+    int64_t nCoinCacheLimit = 0;
+    int64_t nCoinCacheUsage = 0;
+    //! -mempooltxcostlimit, in cost units.
+    int64_t nMempoolCostLimit = 0;
+    //! Expected memory usage of a full mempool.
+    int64_t nMempoolLimit = 0;
+    int64_t nMempoolUsage = 0;
+    int64_t nRandomXUsage = 0;
+    //! Memory set aside for the mempool and RandomX when sizing the UTXO cache.
+    int64_t nReserved = 0;
+};
+
+/**
+ * Returns how much more memory the process can allocate: the smaller of the
+ * kernel's MemAvailable estimate and the headroom below the cgroup memory
+ * limit, or -1 if neither can be determined.
+ */
+int64_t GetAvailableMemory();
+
+/**
+ * Computes the in-memory UTXO cache limit. nCoinCacheUsage is the cache's
+ * current size, which is already excluded from nAvailable, and nReserved is
+ * the memory promised to other consumers.
+ */
+int64_t ComputeCoinCacheLimit(
+    bool fInitialDownload,
+    int64_t nAvailable,
+    int64_t nCoinCacheUsage,
+    int64_t nCoinCacheBase,
+    int64_t nReserved);
+
+/**
+ * Converts the mempool cost limit to bytes. Cost counts each transaction at
+ * its own size but at least MIN_TX_COST, and leaves out the mempool's
+ * per-entry overhead and indexes, so the limit is scaled by the memory usage
+ * per cost unit of the current contents.
+ */
+int64_t MempoolMemoryLimit(int64_t nCostLimit, int64_t nUsage, int64_t nCost);
+
+/** Records the static -dbcache split. If fAuto is false, budgets are only reported. */
+void InitMemoryGovernor(
+    bool fAuto,
+    int64_t nBlockTreeDBCache,
+    int64_t nCoinDBCache,
+    int64_t nCoinCacheBase,
+    int64_t nMempoolCostLimit);
+
+/** Re-evaluates the budgets and, with -dbcache=auto, adjusts nCoinCacheUsage. */
+void UpdateMemoryBudgets();
+
+/**
+ * Returns the budgets with freshly measured usage, without adjusting
+ * anything. nCoinCacheLimit is the limit set by the last UpdateMemoryBudgets.
+ */
+MemoryBudgets GetMemoryBudgets();
+
+/**
+ * Estimated memory held by each part of the node, for getmemoryinfo
+ * "detailed" and the zcashd.memory.usage.bytes metric. All sizes in bytes.
+ */
+struct MemoryUsage {
+    int64_t nBlockIndex = 0;
+    int64_t nCoinsCache = 0;
+    int64_t nMempool = 0;
+    //! Part of nMempool held by the -insightexplorer address and spent indexes.
+    int64_t nMempoolIndexes = 0;
+    int64_t nOrphans = 0;
+    int64_t nRandomXCaches = 0;
+    int64_t nRandomXVMs = 0;
+    int64_t nPeerBuffers = 0;
+    int64_t nBlockTreeDB = 0;
+    int64_t nCoinsDB = 0;
+    bool fWallet = false;
+    int64_t nWalletTransactions = 0;
+    int64_t nWalletOrchardTree = 0;
+    int64_t nWalletScanners = 0;
+};
+
+/**
+ * Measures the memory held by each part of the node. Sizing the block index
+ * and the wallet's transactions walks every entry, so it is only done with
+ * fDetailed; otherwise nBlockIndex and nWalletTransactions are left at zero.
+ */
+MemoryUsage GetMemoryUsage(bool fDetailed);
+
+/** Exports the parts of GetMemoryUsage() that are cheap to measure as gauges. */
+void UpdateMemoryMetrics();
+
+#endif // BITCOIN_MEMORYBUDGET_H
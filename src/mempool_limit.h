@@ -83,6 +83,10 @@ public:
     {
         return txmap.getTotalWeight();
     }
+    int64_t getTotalCost() const
+    {
+        return cost;
+    }
     bool empty() const
     {
         return txmap.empty();
@@ -14,6 +14,7 @@
 
 #include "amount.h"
 #include "chainparams.h"
+#include "coinbasepool.h"
 #include "consensus/consensus.h"
 #include "consensus/funding.h"
 #include "consensus/merkle.h"
@@ -33,6 +34,8 @@
 #include "pow.h"
 #include "primitives/transaction.h"
 #include "random.h"
+#include "templatecache.h"
+#include "threadbudget.h"
 #include "timedata.h"
 #include "transaction_builder.h"
 #include "ui_interface.h"
@@ -50,6 +53,8 @@
 #ifdef ENABLE_MINING
 #include <functional>
 #endif
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <queue>
 
@@ -471,12 +476,16 @@ CBlockTemplate* BlockAssembler::CreateNewBlock(
     LogPrintf("%s: total size %u (excluding coinbase) txs: %u fees: %ld sigops %d", __func__, nBlockSize, nBlockTx, nFees, nBlockSigOps);
 
     // Create coinbase tx
+    std::optional<CMutableTransaction> pooled_cb_mtx;
     if (next_cb_mtx) {
         pblock->vtx[0] = *next_cb_mtx;
+    } else if ((pooled_cb_mtx = GetPooledCoinbase(minerAddress, pindexPrev, nFees))) {
+        pblock->vtx[0] = *pooled_cb_mtx;
     } else {
         pblock->vtx[0] = CreateCoinbaseTransaction(chainparams, nFees, minerAddress, nHeight);
     }
-    pblocktemplate->vTxFees[0] = -nFees;
+    // A pooled coinbase only pays the fees rounded down to its bucket.
+    pblocktemplate->vTxFees[0] = pooled_cb_mtx ? -CoinbasePoolFeeBucket(nFees) : -nFees;
 
     // Update the Sapling commitment tree.
     for (const CTransaction& tx : pblock->vtx) {
@@ -541,6 +550,7 @@ CBlockTemplate* BlockAssembler::CreateNewBlock(
     if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, true)) {
         throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
     }
+    RememberBlockTemplate(*pblock);
 
     return pblocktemplate.release();
 }
@@ -849,10 +859,21 @@ void IncrementExtraNonce(
     txCoinbase.vin[0].scriptSig = (CScript() << nHeight << CScriptNum(nExtraNonce)) + COINBASE_FLAGS;
     assert(txCoinbase.vin[0].scriptSig.size() <= 100);
 
+    bool fNU5Active = consensusParams.NetworkUpgradeActive(nHeight, Consensus::UPGRADE_NU5);
+    if (!pblocktemplate->fCoinbaseBranchesValid) {
+        pblocktemplate->vCoinbaseMerkleBranch = BlockMerkleBranch(*pblock, 0);
+        if (fNU5Active) {
+            pblocktemplate->vCoinbaseAuthDataBranch = pblock->BuildAuthDataMerkleBranch(0);
+        }
+        pblocktemplate->fCoinbaseBranchesValid = true;
+    }
+
     pblock->vtx[0] = txCoinbase;
-    pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
-    if (consensusParams.NetworkUpgradeActive(nHeight, Consensus::UPGRADE_NU5)) {
-        pblocktemplate->hashAuthDataRoot = pblock->BuildAuthDataMerkleTree();
+    pblock->hashMerkleRoot = ComputeMerkleRootFromBranch(
+        pblock->vtx[0].GetHash(), pblocktemplate->vCoinbaseMerkleBranch, 0);
+    if (fNU5Active) {
+        pblocktemplate->hashAuthDataRoot = AuthDataMerkleRootFromBranch(
+            pblock->vtx[0].GetAuthDigest(), pblocktemplate->vCoinbaseAuthDataBranch, 0);
         pblock->hashBlockCommitments = DeriveBlockCommitmentsHash(
             pblocktemplate->hashChainHistoryRoot,
             pblocktemplate->hashAuthDataRoot);
@@ -897,84 +918,165 @@ static bool ProcessBlockFound(const CBlock* pblock, const CChainParams& chainpar
     return true;
 }
 
-void static BitcoinMiner(const CChainParams& chainparams)
+namespace {
+
+/**
+ * A block template shared by all miner threads. It is never modified once
+ * published; each thread hashes its own copy of the block.
+ */
+struct MinerWork {
+    //! Generation the template was published under.
+    uint64_t nGeneration;
+    std::unique_ptr<CBlockTemplate> pblocktemplate;
+    const CBlockIndex* pindexPrev;
+    uint256 seedHash;
+    MinerAddress minerAddress;
+};
+
+boost::mutex mutexMinerWork;
+//! Signalled when a template is published or the producer stops.
+boost::condition_variable condMinerWork;
+//! Signalled when the published template has to be rebuilt.
+boost::condition_variable condMinerRefresh;
+std::shared_ptr<const MinerWork> currentMinerWork;
+bool fMinerRefresh = false;
+bool fMinerProducerStopped = false;
+//! Bumped whenever the published template goes stale, so that miner threads
+//! can drop it without taking mutexMinerWork.
+std::atomic<uint64_t> nMinerGeneration{0};
+
+//! Withdraws the published template. Requires mutexMinerWork.
+void WithdrawMinerWork()
 {
-    LogPrintf("JunoMonetaMiner started\n");
-    SetThreadPriority(THREAD_PRIORITY_LOWEST);
-    RenameThread("juno-miner");
+    currentMinerWork.reset();
+    nMinerGeneration++;
+}
 
-    // Initialize RandomX
-    RandomX_Init();
+void RequestMinerWork()
+{
+    boost::unique_lock<boost::mutex> lock(mutexMinerWork);
+    fMinerRefresh = true;
+    condMinerRefresh.notify_one();
+}
 
-    // Each thread has its own counter
-    unsigned int nExtraNonce = 0;
+//! Waits for a template newer than nLastGeneration. Returns nullptr once the
+//! producer has stopped.
+std::shared_ptr<const MinerWork> WaitForMinerWork(uint64_t nLastGeneration)
+{
+    boost::unique_lock<boost::mutex> lock(mutexMinerWork);
+    while (!fMinerProducerStopped &&
+           (!currentMinerWork || currentMinerWork->nGeneration <= nLastGeneration)) {
+        condMinerWork.wait(lock);
+    }
+    if (fMinerProducerStopped) {
+        return nullptr;
+    }
+    return currentMinerWork;
+}
 
-    // Juno Cash: Legacy Equihash parameters removed
-    // unsigned int n = chainparams.GetConsensus().nEquihashN;
-    // unsigned int k = chainparams.GetConsensus().nEquihashK;
-    // std::string solver = GetArg("-equihashsolver", "default");
-    // assert(solver == "tromp" || solver == "default");
-    // LogPrint("pow", "Using Equihash solver \"%s\" with n = %u, k = %u\n", solver, n, k);
+bool MinerHasPeers()
+{
+    LOCK(cs_vNodes);
+    return !vNodes.empty();
+}
 
-    LogPrint("pow", "Using RandomX proof-of-work algorithm\n");
+}
+
+/**
+ * Builds the block templates for the miner threads.
+ *
+ * One template is built per refresh and published to every miner thread,
+ * instead of each thread assembling its own. A new tip withdraws the
+ * published template at once, so that the miner threads stop hashing stale
+ * work while the next one is built. A template is also rebuilt when the
+ * mempool has changed and it is more than a minute old.
+ */
+void static MinerTemplateProducer(const CChainParams& chainparams)
+{
+    RenameThread("juno-miner-tmpl");
+
+    // Initialize RandomX
+    RandomX_Init();
 
-    std::mutex m_cs;
-    bool cancelSolver = false;
     boost::signals2::connection c = uiInterface.NotifyBlockTip.connect(
-        [&m_cs, &cancelSolver](bool, const CBlockIndex *) mutable {
-            std::lock_guard<std::mutex> lock{m_cs};
-            cancelSolver = true;
+        [](bool, const CBlockIndex *) {
+            boost::unique_lock<boost::mutex> lock(mutexMinerWork);
+            WithdrawMinerWork();
+            fMinerRefresh = true;
+            condMinerRefresh.notify_one();
         }
     );
-    miningTimer.start();
 
+    unsigned int nExtraNonce = 0;
+    unsigned int nTransactionsUpdatedLast = 0;
+    int64_t nTemplateTime = 0;
     try {
         while (true) {
-            // Get a fresh address for each block
-            std::optional<MinerAddress> maybeMinerAddress;
-            GetMainSignals().AddressForMining(maybeMinerAddress);
-
-            // Throw an error if no address valid for mining was provided.
-            if (!(maybeMinerAddress.has_value() && std::visit(IsValidMinerAddress(), maybeMinerAddress.value()))) {
-                throw std::runtime_error("No miner address available (mining requires a wallet or -mineraddress)");
+            bool fRefresh;
+            {
+                boost::unique_lock<boost::mutex> lock(mutexMinerWork);
+                if (currentMinerWork && !fMinerRefresh) {
+                    condMinerRefresh.timed_wait(lock, boost::posix_time::seconds(1));
+                }
+                fRefresh = fMinerRefresh;
+                fMinerRefresh = false;
             }
-            auto minerAddress = maybeMinerAddress.value();
-
-            if (chainparams.MiningRequiresPeers()) {
-                // Busy-wait for the network to come online so we don't waste time mining
-                // on an obsolete chain. In regtest mode we expect to fly solo.
-                miningTimer.stop();
-                do {
-                    bool fvNodesEmpty;
-                    {
-                        LOCK(cs_vNodes);
-                        fvNodesEmpty = vNodes.empty();
-                    }
-                    if (!fvNodesEmpty && !IsInitialBlockDownload(chainparams.GetConsensus()))
-                        break;
-                    MilliSleep(1000);
-                } while (true);
-                miningTimer.start();
+            boost::this_thread::interruption_point();
+
+            if (chainparams.MiningRequiresPeers() &&
+                (!MinerHasPeers() || IsInitialBlockDownload(chainparams.GetConsensus())))
+            {
+                // Don't waste time mining on an obsolete chain. In regtest
+                // mode we expect to fly solo.
+                boost::unique_lock<boost::mutex> lock(mutexMinerWork);
+                if (currentMinerWork) {
+                    WithdrawMinerWork();
+                }
+                condMinerRefresh.timed_wait(lock, boost::posix_time::seconds(1));
+                continue;
             }
 
-            //
-            // Create new block
-            //
-            unsigned int nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
             CBlockIndex* pindexPrev;
             {
                 LOCK(cs_main);
                 pindexPrev = chainActive.Tip();
             }
-
             // If we don't have a valid chain tip to work from, wait and try again.
             if (pindexPrev == nullptr) {
                 MilliSleep(1000);
                 continue;
             }
 
-            unique_ptr<CBlockTemplate> pblocktemplate(BlockAssembler(chainparams).CreateNewBlock(minerAddress));
-            if (!pblocktemplate.get())
+            // A miner thread that asked for new work gets it even when the
+            // published template is still current.
+            if (!fRefresh) {
+                boost::unique_lock<boost::mutex> lock(mutexMinerWork);
+                if (currentMinerWork && currentMinerWork->pindexPrev == pindexPrev &&
+                    !(mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nTemplateTime > 60))
+                {
+                    continue;
+                }
+            }
+
+            // Get a fresh address for each block
+            std::optional<MinerAddress> maybeMinerAddress;
+            GetMainSignals().AddressForMining(maybeMinerAddress);
+
+            // Throw an error if no address valid for mining was provided.
+            if (!(maybeMinerAddress.has_value() && std::visit(IsValidMinerAddress(), maybeMinerAddress.value()))) {
+                throw std::runtime_error("No miner address available (mining requires a wallet or -mineraddress)");
+            }
+
+            //
+            // Create new block
+            //
+            nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
+            nTemplateTime = GetTime();
+            auto work = std::make_shared<MinerWork>();
+            work->minerAddress = maybeMinerAddress.value();
+            work->pindexPrev = pindexPrev;
+            work->pblocktemplate.reset(BlockAssembler(chainparams).CreateNewBlock(work->minerAddress));
+            if (!work->pblocktemplate)
             {
                 if (GetArg("-mineraddress", "").empty()) {
                     LogPrintf("Error in JunoCashMiner: Keypool ran out, please call keypoolrefill before restarting the mining thread\n");
@@ -982,10 +1084,10 @@ void static BitcoinMiner(const CChainParams& chainparams)
                     // Should never reach here, because -mineraddress validity is checked in init.cpp
                     LogPrintf("Error in JunoCashMiner: Invalid -mineraddress\n");
                 }
-                return;
+                break;
             }
-            CBlock *pblock = &pblocktemplate->block;
-            IncrementExtraNonce(pblocktemplate.get(), pindexPrev, nExtraNonce, chainparams.GetConsensus());
+            CBlock *pblock = &work->pblocktemplate->block;
+            IncrementExtraNonce(work->pblocktemplate.get(), pindexPrev, nExtraNonce, chainparams.GetConsensus());
 
             LogPrintf("Running JunoMonetaMiner with %u transactions in block (%u bytes)\n", pblock->vtx.size(),
                 ::GetSerializeSize(*pblock, SER_NETWORK, PROTOCOL_VERSION));
@@ -993,32 +1095,92 @@ void static BitcoinMiner(const CChainParams& chainparams)
             // Calculate RandomX seed for this block height
             uint64_t blockHeight = pindexPrev->nHeight + 1;
             uint64_t seedHeight = RandomX_SeedHeight(blockHeight);
-            uint256 seedHash;
 
             if (seedHeight == 0) {
                 // Genesis epoch - use genesis seed
-                seedHash.SetNull();
-                *seedHash.begin() = 0x08;
+                work->seedHash.SetNull();
+                *work->seedHash.begin() = 0x08;
                 LogPrint("pow", "Mining block %u in genesis epoch (seed height 0)\n", blockHeight);
             } else {
                 // Get seed block hash from chain
-                CBlockIndex* pindexSeed = chainActive[seedHeight];
+                const CBlockIndex* pindexSeed = pindexPrev->GetAncestor(seedHeight);
                 if (!pindexSeed) {
                     LogPrintf("Error: Could not find seed block at height %u\n", seedHeight);
+                    MilliSleep(1000);
                     continue;
                 }
-                seedHash = pindexSeed->GetBlockHash();
+                work->seedHash = pindexSeed->GetBlockHash();
                 LogPrint("pow", "Mining block %u with seed from height %u: %s\n",
-                         blockHeight, seedHeight, seedHash.GetHex());
+                         blockHeight, seedHeight, work->seedHash.GetHex());
             }
 
             // Update RandomX cache for this seed
-            RandomX_SetMainSeedHash(seedHash.begin(), 32);
+            RandomX_SetMainSeedHash(work->seedHash.begin(), 32);
+
+            boost::unique_lock<boost::mutex> lock(mutexMinerWork);
+            WithdrawMinerWork();
+            work->nGeneration = nMinerGeneration;
+            currentMinerWork = work;
+            condMinerWork.notify_all();
+        }
+    }
+    catch (const boost::thread_interrupted&)
+    {
+        c.disconnect();
+        throw;
+    }
+    catch (const std::runtime_error &e)
+    {
+        LogPrintf("JunoCashMiner runtime error: %s\n", e.what());
+    }
+    c.disconnect();
+
+    boost::unique_lock<boost::mutex> lock(mutexMinerWork);
+    WithdrawMinerWork();
+    fMinerProducerStopped = true;
+    condMinerWork.notify_all();
+}
+
+void static BitcoinMiner(const CChainParams& chainparams, int nThreadIndex)
+{
+    LogPrintf("JunoMonetaMiner started\n");
+    SetThreadPriority(THREAD_PRIORITY_LOWEST);
+    RenameThread("juno-miner");
+    ThreadPoolMember member(ThreadPool::MINER);
+
+    // Juno Cash: Legacy Equihash parameters removed
+    // unsigned int n = chainparams.GetConsensus().nEquihashN;
+    // unsigned int k = chainparams.GetConsensus().nEquihashK;
+    // std::string solver = GetArg("-equihashsolver", "default");
+    // assert(solver == "tromp" || solver == "default");
+    // LogPrint("pow", "Using Equihash solver \"%s\" with n = %u, k = %u\n", solver, n, k);
+
+    LogPrint("pow", "Using RandomX proof-of-work algorithm\n");
+
+    miningTimer.start();
+
+    try {
+        uint64_t nLastGeneration = 0;
+        while (true) {
+            std::shared_ptr<const MinerWork> work;
+            miningTimer.stop();
+            work = WaitForMinerWork(nLastGeneration);
+            miningTimer.start();
+            if (!work) {
+                break;
+            }
+            nLastGeneration = work->nGeneration;
+
+            CBlock block = work->pblocktemplate->block;
+            CBlock *pblock = &block;
+            // CreateNewBlock leaves the top 16 bits of the nonce clear, so each
+            // thread searches its own slice of the nonce space.
+            pblock->nNonce = ArithToUint256(
+                UintToArith256(pblock->nNonce) | (arith_uint256(nThreadIndex) << 240));
 
             //
             // Search
             //
-            int64_t nStart = GetTime();
             arith_uint256 hashTarget = arith_uint256().SetCompact(pblock->nBits);
 
             while (true) {
@@ -1030,8 +1192,9 @@ void static BitcoinMiner(const CChainParams& chainparams)
 
                 // Calculate RandomX hash
                 uint256 hash;
-                if (!RandomX_Hash_Block(ss.data(), ss.size(), hash)) {
+                if (!RandomX_Hash_WithSeed(work->seedHash.begin(), 32, ss.data(), ss.size(), hash.begin())) {
                     LogPrintf("RandomX hashing failed\n");
+                    RequestMinerWork();
                     break;
                 }
 
@@ -1050,13 +1213,13 @@ void static BitcoinMiner(const CChainParams& chainparams)
                     LogPrintf("JunoMonetaMiner:\n");
                     LogPrintf("proof-of-work found  \n  hash: %s  \ntarget: %s\n", hash.GetHex(), hashTarget.GetHex());
 
-                    if (ProcessBlockFound(pblock, chainparams)) {
-                        // Ignore chain updates caused by us
-                        std::lock_guard<std::mutex> lock{m_cs};
-                        cancelSolver = false;
+                    if (!ProcessBlockFound(pblock, chainparams)) {
+                        // The tip did not move, so nothing else will
+                        // replace this template.
+                        RequestMinerWork();
                     }
                     SetThreadPriority(THREAD_PRIORITY_LOWEST);
-                    std::visit(KeepMinerAddress(), minerAddress);
+                    std::visit(KeepMinerAddress(), work->minerAddress);
 
                     // In regression test mode, stop mining after a block is found
                     if (chainparams.MineBlocksOnDemand()) {
@@ -1066,23 +1229,19 @@ void static BitcoinMiner(const CChainParams& chainparams)
                     break;
                 }
 
-                // Check for stop or if block needs to be rebuilt
+                // Check for stop or if the template went stale
                 boost::this_thread::interruption_point();
-                // Regtest mode doesn't require peers
-                if (vNodes.empty() && chainparams.MiningRequiresPeers())
-                    break;
-                if ((UintToArith256(pblock->nNonce) & 0xffff) == 0xffff)
-                    break;
-                if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 60)
-                    break;
-                if (pindexPrev != chainActive.Tip())
+                if (nMinerGeneration.load(std::memory_order_relaxed) != work->nGeneration)
                     break;
 
                 // Update nNonce and nTime
                 pblock->nNonce = ArithToUint256(UintToArith256(pblock->nNonce) + 1);
-                if (UpdateTime(pblock, chainparams.GetConsensus(), pindexPrev) < 0)
-                    break; // Recreate the block if the clock has run backwards,
-                           // so that we can use the correct time.
+                if (UpdateTime(pblock, chainparams.GetConsensus(), work->pindexPrev) < 0) {
+                    // Recreate the block if the clock has run backwards,
+                    // so that we can use the correct time.
+                    RequestMinerWork();
+                    break;
+                }
                 if (chainparams.GetConsensus().nPowAllowMinDifficultyBlocksAfterHeight != std::nullopt)
                 {
                     // Changing pblock->nTime can change work required on testnet:
@@ -1094,19 +1253,10 @@ void static BitcoinMiner(const CChainParams& chainparams)
     catch (const boost::thread_interrupted&)
     {
         miningTimer.stop();
-        c.disconnect();
         LogPrintf("JunoCashMiner terminated\n");
         throw;
     }
-    catch (const std::runtime_error &e)
-    {
-        miningTimer.stop();
-        c.disconnect();
-        LogPrintf("JunoCashMiner runtime error: %s\n", e.what());
-        return;
-    }
     miningTimer.stop();
-    c.disconnect();
 }
 
 void GenerateBitcoins(bool fGenerate, int nThreads, const CChainParams& chainparams)
@@ -1114,7 +1264,7 @@ void GenerateBitcoins(bool fGenerate, int nThreads, const CChainParams& chainpar
     static boost::thread_group* minerThreads = NULL;
 
     if (nThreads < 0)
-        nThreads = GetNumCores();
+        nThreads = ThreadBudgetFor(ThreadPool::MINER, GetNumCores());
 
     if (minerThreads != NULL)
     {
@@ -1127,9 +1277,17 @@ void GenerateBitcoins(bool fGenerate, int nThreads, const CChainParams& chainpar
     if (nThreads == 0 || !fGenerate)
         return;
 
+    {
+        boost::unique_lock<boost::mutex> lock(mutexMinerWork);
+        WithdrawMinerWork();
+        fMinerRefresh = false;
+        fMinerProducerStopped = false;
+    }
+
     minerThreads = new boost::thread_group();
+    minerThreads->create_thread(boost::bind(&MinerTemplateProducer, boost::cref(chainparams)));
     for (int i = 0; i < nThreads; i++) {
-        minerThreads->create_thread(boost::bind(&BitcoinMiner, boost::cref(chainparams)));
+        minerThreads->create_thread(boost::bind(&BitcoinMiner, boost::cref(chainparams), i));
     }
 }
 
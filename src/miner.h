@@ -92,6 +92,13 @@ struct CBlockTemplate
     // (enabling the caller to update `hashBlockCommitments` when they change
     // `hashPrevBlock`).
     uint256 hashAuthDataRoot;
+    // Merkle branches of the coinbase transaction in the transaction and
+    // authorizing data trees, computed on the first IncrementExtraNonce() so
+    // that later coinbase changes only rehash one path. They must be cleared
+    // if any other transaction in `block` changes.
+    std::vector<uint256> vCoinbaseMerkleBranch;
+    std::vector<uint256> vCoinbaseAuthDataBranch;
+    bool fCoinbaseBranchesValid = false;
     std::vector<CAmount> vTxFees;
     std::vector<int64_t> vTxSigOps;
 };
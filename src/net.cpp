@@ -2202,6 +2202,25 @@ void CNode::Fuzz(int nChance)
 unsigned int ReceiveFloodSize() { return 1000*GetArg("-maxreceivebuffer", DEFAULT_MAXRECEIVEBUFFER); }
 unsigned int SendBufferSize() { return 1000*GetArg("-maxsendbuffer", DEFAULT_MAXSENDBUFFER); }
 
+size_t PeerBufferMemoryUsage()
+{
+    size_t nUsage = 0;
+    LOCK(cs_vNodes);
+    for (CNode* pnode : vNodes) {
+        {
+            LOCK(pnode->cs_vSend);
+            nUsage += pnode->nSendSize + pnode->ssSend.size();
+        }
+        // Messages being processed hold cs_vRecvMsg; their buffers are
+        // counted on the next call.
+        TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
+        if (lockRecv) {
+            nUsage += pnode->GetTotalRecvSize();
+        }
+    }
+    return nUsage;
+}
+
 CNode::CNode(SOCKET hSocketIn, const CAddress& addrIn, const std::string& addrNameIn, bool fInboundIn) :
     ssSend(SER_NETWORK, INIT_PROTO_VERSION),
     nTimeConnected(GetTime()),
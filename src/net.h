@@ -88,6 +88,8 @@ static const unsigned int DEFAULT_MISBEHAVING_BANTIME = 60 * 60 * 24;  // Defaul
 
 unsigned int ReceiveFloodSize();
 unsigned int SendBufferSize();
+/** Bytes queued in the send and receive buffers of all peers. */
+size_t PeerBufferMemoryUsage();
 
 void AddOneShot(const std::string& strDest);
 void AddressCurrentlyConnected(const CService& addr);
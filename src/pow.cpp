@@ -194,6 +194,16 @@ bool CheckRandomXSolution(const CBlockHeader *pblock, const Consensus::Params& p
     }
 }
 
+bool CheckClaimedProofOfWork(const CBlockHeader *pblock, const Consensus::Params& params)
+{
+    // For RandomX, the POW hash is the RandomX hash stored in nSolution
+    uint256 randomxHash;
+    if (pblock->nSolution.size() == 32) {
+        memcpy(randomxHash.begin(), pblock->nSolution.data(), 32);
+    }
+    return CheckProofOfWork(randomxHash, pblock->nBits, params);
+}
+
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params& params)
 {
     bool fNegative;
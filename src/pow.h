@@ -31,6 +31,12 @@ bool CheckEquihashSolution(const CBlockHeader *pblock, const Consensus::Params&)
 bool CheckRandomXSolution(const CBlockHeader *pblock, const Consensus::Params&,
                          const CBlockIndex* pindexPrev = nullptr);
 
+/**
+ * Check whether the RandomX hash a header claims in its solution satisfies
+ * nBits. This is cheap; CheckRandomXSolution checks that the claim is true.
+ */
+bool CheckClaimedProofOfWork(const CBlockHeader *pblock, const Consensus::Params&);
+
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
 arith_uint256 GetBlockProof(const CBlockIndex& block);
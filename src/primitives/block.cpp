@@ -60,6 +60,14 @@ static uint64_t next_pow2(uint64_t x)
     return x + 1;
 }
 
+static uint256 HashAuthDataNodes(const uint256& left, const uint256& right)
+{
+    CBLAKE2bWriter ss(SER_GETHASH, 0, ZCASH_AUTH_DATA_HASH_PERSONALIZATION);
+    ss << left;
+    ss << right;
+    return ss.GetHash();
+}
+
 uint256 CBlock::BuildAuthDataMerkleTree() const
 {
     std::vector<uint256> tree;
@@ -79,10 +87,7 @@ uint256 CBlock::BuildAuthDataMerkleTree() const
     int j = 0;
     for (int layerWidth = perfectSize; layerWidth > 1; layerWidth = layerWidth / 2) {
         for (int i = 0; i < layerWidth; i += 2) {
-            CBLAKE2bWriter ss(SER_GETHASH, 0, ZCASH_AUTH_DATA_HASH_PERSONALIZATION);
-            ss << tree[j + i];
-            ss << tree[j + i + 1];
-            tree.push_back(ss.GetHash());
+            tree.push_back(HashAuthDataNodes(tree[j + i], tree[j + i + 1]));
         }
 
         // Move to the next layer.
@@ -93,6 +98,39 @@ uint256 CBlock::BuildAuthDataMerkleTree() const
     return (tree.empty() ? uint256() : tree.back());
 }
 
+std::vector<uint256> CBlock::BuildAuthDataMerkleBranch(size_t position) const
+{
+    assert(position < vtx.size());
+    auto perfectSize = next_pow2(vtx.size());
+
+    std::vector<uint256> layer;
+    layer.reserve(perfectSize);
+    for (auto &tx : vtx) {
+        layer.push_back(tx.GetAuthDigest());
+    }
+    layer.resize(perfectSize);
+
+    std::vector<uint256> branch;
+    for (; layer.size() > 1; position /= 2) {
+        branch.push_back(layer[position ^ 1]);
+        for (size_t i = 0; i < layer.size(); i += 2) {
+            layer[i / 2] = HashAuthDataNodes(layer[i], layer[i + 1]);
+        }
+        layer.resize(layer.size() / 2);
+    }
+    return branch;
+}
+
+uint256 AuthDataMerkleRootFromBranch(const uint256& leaf, const std::vector<uint256>& branch, size_t position)
+{
+    uint256 hash = leaf;
+    for (const uint256& sibling : branch) {
+        hash = (position & 1) ? HashAuthDataNodes(sibling, hash) : HashAuthDataNodes(hash, sibling);
+        position /= 2;
+    }
+    return hash;
+}
+
 std::string CBlock::ToString() const
 {
     std::stringstream s;
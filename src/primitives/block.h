@@ -108,7 +108,14 @@ public:
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
         READWRITE(*(CBlockHeader*)this);
-        READWRITE(vtx);
+        if (ser_action.ForRead()) {
+            // Hash the transactions together once they have all been read.
+            DeferredHashTransactions txs(vtx);
+            READWRITE(txs);
+            txs.ComputeHashes();
+        } else {
+            READWRITE(vtx);
+        }
     }
 
     void SetNull()
@@ -136,10 +143,20 @@ public:
     // root.
     uint256 BuildAuthDataMerkleTree() const;
 
+    // Build the authorizing data Merkle tree for this block and return the
+    // branch of the leaf at the given position, from the bottom up.
+    std::vector<uint256> BuildAuthDataMerkleBranch(size_t position) const;
+
     std::string ToString() const;
 };
 
 
+/**
+ * Compute the root of the authorizing data Merkle tree from a leaf and its
+ * branch, as returned by CBlock::BuildAuthDataMerkleBranch.
+ */
+uint256 AuthDataMerkleRootFromBranch(const uint256& leaf, const std::vector<uint256>& branch, size_t position);
+
 /**
  * Custom serializer for CBlockHeader that omits the nonce and solution, for use
  * as input to Equihash.
@@ -14,6 +14,10 @@
 
 #include <rust/transaction.h>
 
+#include <algorithm>
+#include <exception>
+#include <mutex>
+
 std::string COutPoint::ToString() const
 {
     return strprintf("COutPoint(%s, %u)", hash.ToString().substr(0,10), n);
@@ -147,6 +151,60 @@ void CTransaction::UpdateHash() const
     }
 }
 
+namespace {
+std::mutex transactionHashRunnerMutex;
+TransactionHashRunner transactionHashRunner;
+}
+
+void SetTransactionHashRunner(TransactionHashRunner runner)
+{
+    std::lock_guard<std::mutex> lock(transactionHashRunnerMutex);
+    transactionHashRunner = std::move(runner);
+}
+
+void DeferredHashTransactions::ComputeHashes() const
+{
+    TransactionHashRunner runner;
+    if (vtx.size() >= 2 * TRANSACTION_HASH_BATCH_SIZE) {
+        std::lock_guard<std::mutex> lock(transactionHashRunnerMutex);
+        runner = transactionHashRunner;
+    }
+
+    if (runner) {
+        std::mutex failureMutex;
+        std::exception_ptr failure;
+        std::vector<std::function<bool()>> vJobs;
+        vJobs.reserve((vtx.size() + TRANSACTION_HASH_BATCH_SIZE - 1) / TRANSACTION_HASH_BATCH_SIZE);
+        for (size_t start = 0; start < vtx.size(); start += TRANSACTION_HASH_BATCH_SIZE) {
+            size_t end = std::min(vtx.size(), start + TRANSACTION_HASH_BATCH_SIZE);
+            vJobs.emplace_back([&, start, end]() {
+                try {
+                    for (size_t i = start; i < end; i++) {
+                        vtx[i].UpdateHash();
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(failureMutex);
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                    return false;
+                }
+                return true;
+            });
+        }
+        if (runner(vJobs)) {
+            if (failure) {
+                std::rethrow_exception(failure);
+            }
+            return;
+        }
+    }
+
+    for (const CTransaction& tx : vtx) {
+        tx.UpdateHash();
+    }
+}
+
 CTransaction::CTransaction() : nVersion(CTransaction::SPROUT_MIN_CURRENT_VERSION),
                                fOverwintered(false), nVersionGroupId(0), nExpiryHeight(0),
                                nConsensusBranchId(std::nullopt),
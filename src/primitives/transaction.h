@@ -17,6 +17,7 @@
 #include "consensus/upgrades.h"
 
 #include <array>
+#include <functional>
 #include <variant>
 
 #include "zcash/NoteEncryption.hpp"
@@ -464,6 +465,8 @@ private:
     const WTxId wtxid;
     void UpdateHash() const;
 
+    friend class DeferredHashTransactions;
+
 protected:
     /** Developer testing only.  Set evilDeveloperFlag to true.
      * Convert a CMutableTransaction into a CTransaction without invoking UpdateHash()
@@ -536,6 +539,14 @@ public:
 
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
+        SerializeFields(s, ser_action);
+        if (ser_action.ForRead())
+            UpdateHash();
+    }
+
+private:
+    template <typename Stream, typename Operation>
+    inline void SerializeFields(Stream& s, Operation ser_action) {
         uint32_t header;
         if (ser_action.ForRead()) {
             // When deserializing, unpack the 4 byte header to extract fOverwintered and nVersion.
@@ -639,10 +650,9 @@ public:
                 }
             }
         }
-        if (ser_action.ForRead())
-            UpdateHash();
     }
 
+public:
     template <typename Stream>
     CTransaction(deserialize_type, Stream& s) : CTransaction(CMutableTransaction(deserialize, s)) {}
 
@@ -908,4 +918,59 @@ struct CMutableTransaction
     uint256 GetAuthDigest() const;
 };
 
+/** Number of transactions hashed by each job in ComputeHashes(). */
+static const size_t TRANSACTION_HASH_BATCH_SIZE = 16;
+
+/**
+ * Runs a batch of jobs on a thread pool and returns once all of them have
+ * run. Returns false without running any of them if the pool is busy.
+ */
+typedef std::function<bool(const std::vector<std::function<bool()>>&)> TransactionHashRunner;
+
+/**
+ * Sets the pool that hashes the transactions of large blocks. Without one,
+ * transactions are hashed on the thread that decodes the block.
+ */
+void SetTransactionHashRunner(TransactionHashRunner runner);
+
+/**
+ * Reader for the transactions of a block that does not compute their txids
+ * and authorizing data digests as each one is read. ComputeHashes() computes
+ * them afterwards, on the pool set by SetTransactionHashRunner for large
+ * blocks.
+ */
+class DeferredHashTransactions
+{
+private:
+    std::vector<CTransaction>& vtx;
+public:
+    DeferredHashTransactions(std::vector<CTransaction>& vtx) : vtx(vtx) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        throw std::ios_base::failure("Can't write transactions with DeferredHashTransactions");
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        // As for std::vector, limit the size per resize so that a bogus
+        // size cannot cause out of memory.
+        vtx.clear();
+        unsigned int nSize = ReadCompactSize(s);
+        unsigned int i = 0;
+        unsigned int nMid = 0;
+        while (nMid < nSize) {
+            nMid += 5000000 / sizeof(CTransaction);
+            if (nMid > nSize)
+                nMid = nSize;
+            vtx.resize(nMid);
+            for (; i < nMid; i++)
+                vtx[i].SerializeFields(s, CSerActionUnserialize());
+        }
+    }
+
+    /** Computes the txids and authorizing data digests of the transactions. */
+    void ComputeHashes() const;
+};
+
 #endif // BITCOIN_PRIMITIVES_TRANSACTION_H
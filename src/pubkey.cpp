@@ -5,6 +5,8 @@
 
 #include "pubkey.h"
 
+#include <string.h>
+
 #include <secp256k1.h>
 #include <secp256k1_recovery.h>
 
@@ -18,6 +20,47 @@ struct Secp256k1SelfTester
     }
 } SECP256K1_SELFTESTER;
 
+/**
+ * Per-thread cache of parsed public keys. Parsing a compressed key involves a
+ * square root, which is a noticeable share of a signature verification, and
+ * transactions that consolidate the outputs of one address present the same
+ * key for every input. Each check queue worker has its own cache, so there is
+ * no locking.
+ */
+class ParsedPubKeyCache
+{
+private:
+    static constexpr size_t SLOTS = 64;
+
+    struct Slot {
+        unsigned int len = 0;
+        unsigned char vch[CPubKey::PUBLIC_KEY_SIZE];
+        secp256k1_pubkey parsed;
+    };
+    Slot slots[SLOTS];
+
+public:
+    bool Parse(const unsigned char* data, unsigned int len, secp256k1_pubkey& pubkey)
+    {
+        // The byte after the prefix is the first byte of the x coordinate,
+        // which is as good as random.
+        Slot& slot = slots[data[1] % SLOTS];
+        if (slot.len == len && memcmp(slot.vch, data, len) == 0) {
+            pubkey = slot.parsed;
+            return true;
+        }
+        if (!secp256k1_ec_pubkey_parse(secp256k1_context_static, &pubkey, data, len)) {
+            return false;
+        }
+        slot.len = len;
+        memcpy(slot.vch, data, len);
+        slot.parsed = pubkey;
+        return true;
+    }
+};
+
+thread_local ParsedPubKeyCache parsedPubKeyCache;
+
 } // namespace
 
 bool CPubKey::Verify(const uint256 &hash, const std::vector<unsigned char>& vchSig) const {
@@ -25,7 +68,7 @@ bool CPubKey::Verify(const uint256 &hash, const std::vector<unsigned char>& vchS
         return false;
     secp256k1_pubkey pubkey;
     secp256k1_ecdsa_signature sig;
-    if (!secp256k1_ec_pubkey_parse(secp256k1_context_static, &pubkey, &(*this)[0], size())) {
+    if (!parsedPubKeyCache.Parse(&(*this)[0], size(), pubkey)) {
         return false;
     }
     if (vchSig.size() == 0) {
@@ -179,10 +179,10 @@ UniValue blockToDeltasJSON(const CBlock& block, const CBlockIndex* blockindex)
                 delta.pushKV("prevtxid", input.prevout.hash.GetHex());
                 delta.pushKV("prevout", (int)input.prevout.n);
 
-                inputs.push_back(delta);
+                inputs.push_back(std::move(delta));
             }
         }
-        entry.pushKV("inputs", inputs);
+        entry.pushKV("inputs", std::move(inputs));
 
         UniValue outputs(UniValue::VARR);
         for (unsigned int k = 0; k < tx.vout.size(); k++) {
@@ -202,12 +202,12 @@ UniValue blockToDeltasJSON(const CBlock& block, const CBlockIndex* blockindex)
             delta.pushKV("satoshis", out.nValue);
             delta.pushKV("index", (int)k);
 
-            outputs.push_back(delta);
+            outputs.push_back(std::move(delta));
         }
-        entry.pushKV("outputs", outputs);
-        deltas.push_back(entry);
+        entry.pushKV("outputs", std::move(outputs));
+        deltas.push_back(std::move(entry));
     }
-    result.pushKV("deltas", deltas);
+    result.pushKV("deltas", std::move(deltas));
     result.pushKV("time", block.GetBlockTime());
     result.pushKV("mediantime", (int64_t)blockindex->GetMedianTimePast());
     result.pushKV("nonce", block.nNonce.GetHex());
@@ -249,18 +249,19 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     }
     result.pushKV("chainhistoryroot", blockindex->hashChainHistoryRoot.GetHex());
     UniValue txs(UniValue::VARR);
+    txs.reserve(block.vtx.size());
     for (const CTransaction&tx : block.vtx)
     {
         if(txDetails)
         {
             UniValue objTx(UniValue::VOBJ);
             TxToJSON(tx, uint256(), objTx);
-            txs.push_back(objTx);
+            txs.push_back(std::move(objTx));
         }
         else
             txs.push_back(tx.GetHash().GetHex());
     }
-    result.pushKV("tx", txs);
+    result.pushKV("tx", std::move(txs));
     result.pushKV("time", block.GetBlockTime());
     result.pushKV("nonce", block.nNonce.GetHex());
     result.pushKV("solution", HexStr(block.nSolution));
@@ -275,7 +276,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     valuePools.push_back(ValuePoolDesc("sapling", blockindex->nChainSaplingValue, blockindex->nSaplingValue));
     valuePools.push_back(ValuePoolDesc("orchard", blockindex->nChainOrchardValue, blockindex->nOrchardValue));
     valuePools.push_back(ValuePoolDesc("lockbox", blockindex->nChainLockboxValue, blockindex->nLockboxValue));
-    result.pushKV("valuePools", valuePools);
+    result.pushKV("valuePools", std::move(valuePools));
 
     {
         UniValue trees(UniValue::VOBJ);
@@ -284,17 +285,17 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
         if (pcoinsTip != nullptr && pcoinsTip->GetSaplingAnchorAt(blockindex->hashFinalSaplingRoot, saplingTree)) {
             UniValue sapling(UniValue::VOBJ);
             sapling.pushKV("size", (uint64_t)saplingTree.size());
-            trees.pushKV("sapling", sapling);
+            trees.pushKV("sapling", std::move(sapling));
         }
 
         OrchardMerkleFrontier orchardTree;
         if (pcoinsTip != nullptr && pcoinsTip->GetOrchardAnchorAt(blockindex->hashFinalOrchardRoot, orchardTree)) {
             UniValue orchard(UniValue::VOBJ);
             orchard.pushKV("size", (uint64_t)orchardTree.size());
-            trees.pushKV("orchard", orchard);
+            trees.pushKV("orchard", std::move(orchard));
         }
 
-        result.pushKV("trees", trees);
+        result.pushKV("trees", std::move(trees));
     }
 
     if (blockindex->pprev)
@@ -389,8 +390,10 @@ UniValue mempoolToJSON(bool fVerbose = false)
                 depends.push_back(dep);
             }
 
-            info.pushKV("depends", depends);
-            o.pushKV(hash.ToString(), info);
+            info.pushKV("depends", std::move(depends));
+            // Transaction ids are unique, so skip pushKV's scan for an
+            // existing key, which is quadratic in the size of the mempool.
+            o.pushKVEnd(hash.ToString(), std::move(info));
         }
         return o;
     }
@@ -400,6 +403,7 @@ UniValue mempoolToJSON(bool fVerbose = false)
         mempool.queryHashes(vtxid);
 
         UniValue a(UniValue::VARR);
+        a.reserve(vtxid.size());
         for (const uint256& hash : vtxid)
             a.push_back(hash.ToString());
 
@@ -7,6 +7,7 @@
 
 #include "amount.h"
 #include "chainparams.h"
+#include "coinbasepool.h"
 #include "consensus/consensus.h"
 #include "consensus/funding.h"
 #include "consensus/merkle.h"
@@ -669,7 +670,9 @@ UniValue getblocktemplate(const UniValue& params, bool fHelp)
                 // Note that the time to create the coinbase tx here does not add to,
                 // but instead is included in, the 10 second delay, since we're waiting
                 // until an absolute time is reached.
-                if (!cached_next_cb_mtx && IsShieldedMinerAddress(minerAddress)) {
+                // The coinbase pool, if enabled, already does this without
+                // giving up the block's transactions.
+                if (!cached_next_cb_mtx && IsShieldedMinerAddress(minerAddress) && !CoinbasePoolEnabled()) {
                     cached_next_cb_height = nHeight + 2;
                     cached_next_cb_mtx = CreateCoinbaseTransaction(
                         Params(), CAmount{0}, minerAddress, cached_next_cb_height);
@@ -973,7 +976,11 @@ UniValue submitblock(const UniValue& params, bool fHelp)
     submitblock_StateCatcher sc(block.GetHash());
     RegisterValidationInterface(&sc);
     bool fAccepted = ProcessNewBlock(state, Params(), NULL, &block, true, NULL);
+    // BlockChecked is delivered from the validation interface queue.
+    SyncWithValidationInterfaceQueue();
     UnregisterValidationInterface(&sc);
+    // Let a notification already handed to sc finish before sc goes away.
+    SyncWithValidationInterfaceQueue();
     if (fBlockPresent)
     {
         if (fAccepted && !sc.found)
@@ -11,6 +11,7 @@
 #include "key_io.h"
 #include "experimental_features.h"
 #include "main.h"
+#include "memorybudget.h"
 #include "net.h"
 #include "netbase.h"
 #include "rpc/server.h"
@@ -1213,15 +1214,61 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCMemoryBudgets()
+{
+    MemoryBudgets budgets = GetMemoryBudgets();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("dbcache", budgets.fAuto ? "auto" : "fixed");
+    obj.pushKV("initial_block_download", budgets.fInitialDownload);
+    if (budgets.nAvailable >= 0) {
+        obj.pushKV("available", budgets.nAvailable);
+    }
+    obj.pushKV("block_tree_db", budgets.nBlockTreeDBCache);
+    obj.pushKV("coins_db", budgets.nCoinDBCache);
+    obj.pushKV("coins_cache", budgets.nCoinCacheLimit);
+    obj.pushKV("coins_cache_default", budgets.nCoinCacheBase);
+    obj.pushKV("coins_cache_usage", budgets.nCoinCacheUsage);
+    obj.pushKV("mempool", budgets.nMempoolLimit);
+    obj.pushKV("mempool_usage", budgets.nMempoolUsage);
+    obj.pushKV("randomx_usage", budgets.nRandomXUsage);
+    obj.pushKV("reserved", budgets.nReserved);
+    return obj;
+}
+
+static UniValue RPCMemoryUsage()
+{
+    MemoryUsage usage = GetMemoryUsage(true);
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("block_index", usage.nBlockIndex);
+    obj.pushKV("coins_cache", usage.nCoinsCache);
+    obj.pushKV("mempool", usage.nMempool);
+    obj.pushKV("mempool_indexes", usage.nMempoolIndexes);
+    obj.pushKV("orphans", usage.nOrphans);
+    obj.pushKV("randomx_caches", usage.nRandomXCaches);
+    obj.pushKV("randomx_vms", usage.nRandomXVMs);
+    obj.pushKV("peer_buffers", usage.nPeerBuffers);
+    obj.pushKV("block_tree_db", usage.nBlockTreeDB);
+    obj.pushKV("coins_db", usage.nCoinsDB);
+    if (usage.fWallet) {
+        obj.pushKV("wallet_transactions", usage.nWalletTransactions);
+        obj.pushKV("wallet_orchard_tree", usage.nWalletOrchardTree);
+        obj.pushKV("wallet_scanners", usage.nWalletScanners);
+    }
+    return obj;
+}
+
 UniValue getmemoryinfo(const UniValue& params, bool fHelp)
 {
     /* Please, avoid using the word "pool" here in the RPC interface or help,
      * as users will undoubtedly confuse it with the other "memory pool"
      */
-    if (fHelp || params.size() != 0)
+    if (fHelp || params.size() > 1)
         throw runtime_error(
-            "getmemoryinfo\n"
+            "getmemoryinfo ( \"mode\" )\n"
             "Returns an object containing information about memory usage.\n"
+            "\nArguments:\n"
+            "1. \"mode\"    (string, optional, default: \"stats\") \"stats\", or \"detailed\" to also break\n"
+            "             down the memory held by each part of the node.\n"
             "\nResult:\n"
             "{\n"
             "  \"locked\": {               (json object) Information about locked memory manager\n"
@@ -1231,14 +1278,53 @@ UniValue getmemoryinfo(const UniValue& params, bool fHelp)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"budgets\": {              (json object) Memory budgets, in bytes\n"
+            "    \"dbcache\": \"xxxx\",       (string) \"auto\" if the in-memory UTXO set follows available memory, otherwise \"fixed\"\n"
+            "    \"initial_block_download\": true|false, (boolean) Whether the node is in initial block download\n"
+            "    \"available\": xxxxx,     (numeric, optional) Memory the node can still allocate, within cgroup limits\n"
+            "    \"block_tree_db\": xxxxx, (numeric) Block index database cache\n"
+            "    \"coins_db\": xxxxx,      (numeric) Chain state database cache\n"
+            "    \"coins_cache\": xxxxx,   (numeric) Current limit of the in-memory UTXO set\n"
+            "    \"coins_cache_default\": xxxxx, (numeric) Limit of the in-memory UTXO set derived from -dbcache\n"
+            "    \"coins_cache_usage\": xxxxx, (numeric) Current size of the in-memory UTXO set\n"
+            "    \"mempool\": xxxxx,       (numeric) Expected memory usage of a full mempool, scaled from -mempooltxcostlimit\n"
+            "    \"mempool_usage\": xxxxx, (numeric) Current mempool memory usage\n"
+            "    \"randomx_usage\": xxxxx, (numeric) Memory held by RandomX caches\n"
+            "    \"reserved\": xxxxx,      (numeric) Memory kept free for the mempool and RandomX when sizing the UTXO set\n"
+            "  },\n"
+            "  \"usage\": {                (json object, \"detailed\" only) Estimated memory held by each part of the node, in bytes\n"
+            "    \"block_index\": xxxxx,   (numeric) Block index\n"
+            "    \"coins_cache\": xxxxx,   (numeric) In-memory UTXO set\n"
+            "    \"mempool\": xxxxx,       (numeric) Mempool, including mempool_indexes\n"
+            "    \"mempool_indexes\": xxxxx, (numeric) Mempool address and spent indexes (-insightexplorer)\n"
+            "    \"orphans\": xxxxx,       (numeric) Orphan transactions\n"
+            "    \"randomx_caches\": xxxxx, (numeric) RandomX caches\n"
+            "    \"randomx_vms\": xxxxx,   (numeric) RandomX virtual machines\n"
+            "    \"peer_buffers\": xxxxx,  (numeric) Send and receive buffers of connected peers\n"
+            "    \"block_tree_db\": xxxxx, (numeric) Block index database memtables and cache\n"
+            "    \"coins_db\": xxxxx,      (numeric) Chain state database memtables and cache\n"
+            "    \"wallet_transactions\": xxxxx, (numeric, optional) Wallet transactions\n"
+            "    \"wallet_orchard_tree\": xxxxx, (numeric, optional) Wallet Orchard note commitment tree\n"
+            "    \"wallet_scanners\": xxxxx, (numeric, optional) Outputs queued for trial decryption\n"
             "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getmemoryinfo", "")
-            + HelpExampleRpc("getmemoryinfo", "")
+            + HelpExampleCli("getmemoryinfo", "\"detailed\"")
+            + HelpExampleRpc("getmemoryinfo", "\"detailed\"")
         );
+
+    std::string mode = params.size() > 0 ? params[0].get_str() : "stats";
+    if (mode != "stats" && mode != "detailed") {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "unknown mode " + mode);
+    }
     UniValue obj(UniValue::VOBJ);
     obj.pushKV("locked", RPCLockedMemoryInfo());
+    obj.pushKV("budgets", RPCMemoryBudgets());
+    if (mode == "detailed") {
+        obj.pushKV("usage", RPCMemoryUsage());
+    }
     return obj;
 }
 
@@ -133,7 +133,7 @@ UniValue TxShieldedSpendsToJSON(const rust::Vec<sapling::Spend>& saplingSpends)
         obj.pushKV("rk", uint256::FromRawBytes(spendDesc.rk()).GetHex());
         obj.pushKV("proof", HexStr(spendDesc.zkproof()));
         obj.pushKV("spendAuthSig", HexStr(spendDesc.spend_auth_sig()));
-        vdesc.push_back(obj);
+        vdesc.push_back(std::move(obj));
     }
     return vdesc;
 }
@@ -148,7 +148,7 @@ UniValue TxShieldedOutputsToJSON(const rust::Vec<sapling::Output>& saplingOutput
         obj.pushKV("encCiphertext", HexStr(outputDesc.enc_ciphertext()));
         obj.pushKV("outCiphertext", HexStr(outputDesc.out_ciphertext()));
         obj.pushKV("proof", HexStr(outputDesc.zkproof()));
-        vdesc.push_back(obj);
+        vdesc.push_back(std::move(obj));
     }
     return vdesc;
 }
@@ -174,7 +174,7 @@ UniValue TxActionsToJSON(const rust::Vec<orchard_bundle::Action>& actions)
         obj.pushKV("outCiphertext", HexStr(outCiphertext.begin(), outCiphertext.end()));
         auto spendAuthSig = action.spend_auth_sig();
         obj.pushKV("spendAuthSig", HexStr(spendAuthSig.begin(), spendAuthSig.end()));
-        arr.push_back(obj);
+        arr.push_back(std::move(obj));
     }
     return arr;
 }
@@ -198,7 +198,7 @@ UniValue TxOrchardBundleToJSON(const CTransaction& tx, UniValue& entry)
             obj_flags.pushKV("enableSpends", enableSpends);
             auto enableOutputs = bundle->enable_outputs();
             obj_flags.pushKV("enableOutputs", enableOutputs);
-            obj.pushKV("flags", obj_flags);
+            obj.pushKV("flags", std::move(obj_flags));
         }
         auto anchor = bundle->anchor();
         obj.pushKV("anchor", HexStr(anchor.begin(), anchor.end()));
@@ -230,6 +230,7 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
 
     KeyIO keyIO(Params());
     UniValue vin(UniValue::VARR);
+    vin.reserve(tx.vin.size());
     for (const CTxIn& txin : tx.vin) {
         UniValue in(UniValue::VOBJ);
         if (tx.IsCoinBase())
@@ -240,7 +241,7 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
             UniValue o(UniValue::VOBJ);
             o.pushKV("asm", ScriptToAsmStr(txin.scriptSig, true));
             o.pushKV("hex", HexStr(txin.scriptSig.begin(), txin.scriptSig.end()));
-            in.pushKV("scriptSig", o);
+            in.pushKV("scriptSig", std::move(o));
 
             // Add address and value info if spentindex enabled
             CSpentIndexValue spentInfo;
@@ -257,10 +258,11 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
             }
         }
         in.pushKV("sequence", (int64_t)txin.nSequence);
-        vin.push_back(in);
+        vin.push_back(std::move(in));
     }
-    entry.pushKV("vin", vin);
+    entry.pushKV("vin", std::move(vin));
     UniValue vout(UniValue::VARR);
+    vout.reserve(tx.vout.size());
     for (unsigned int i = 0; i < tx.vout.size(); i++) {
         const CTxOut& txout = tx.vout[i];
         UniValue out(UniValue::VOBJ);
@@ -270,7 +272,7 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
         out.pushKV("n", (int64_t)i);
         UniValue o(UniValue::VOBJ);
         ScriptPubKeyToJSON(txout.scriptPubKey, o, true);
-        out.pushKV("scriptPubKey", o);
+        out.pushKV("scriptPubKey", std::move(o));
 
         // Add spent information if spentindex is enabled
         CSpentIndexValue spentInfo;
@@ -280,12 +282,12 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
             out.pushKV("spentIndex", (int)spentInfo.inputIndex);
             out.pushKV("spentHeight", spentInfo.blockHeight);
         }
-        vout.push_back(out);
+        vout.push_back(std::move(out));
     }
-    entry.pushKV("vout", vout);
+    entry.pushKV("vout", std::move(vout));
 
     UniValue vjoinsplit = TxJoinSplitToJSON(tx);
-    entry.pushKV("vjoinsplit", vjoinsplit);
+    entry.pushKV("vjoinsplit", std::move(vjoinsplit));
 
     if (tx.fOverwintered) {
         if (tx.nVersion >= SAPLING_TX_VERSION) {
@@ -303,7 +305,7 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
         }
         if (tx.nVersion >= ZIP225_TX_VERSION) {
             UniValue orchard = TxOrchardBundleToJSON(tx, entry);
-            entry.pushKV("orchard", orchard);
+            entry.pushKV("orchard", std::move(orchard));
         }
     }
 
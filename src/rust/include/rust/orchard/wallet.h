@@ -392,6 +392,12 @@ OrchardSpendInfoPtr* orchard_wallet_get_spend_info(
  */
 void orchard_wallet_gc_note_commitment_tree(OrchardWalletPtr* wallet);
 
+/**
+ * Returns an estimate of the memory held by the wallet's note commitment tree,
+ * in bytes.
+ */
+size_t orchard_wallet_note_commitment_tree_usage(const OrchardWalletPtr* wallet);
+
 /**
  * Write the wallet's note commitment tree to the provided stream.
  */
@@ -407,6 +407,7 @@ pub(crate) mod ffi {
             height: u32,
         ) -> Result<()>;
         fn flush(self: &mut BatchScanner);
+        fn memory_usage(self: &BatchScanner) -> usize;
         fn collect_results(
             self: &mut BatchScanner,
             block_tag: [u8; 32],
@@ -1,6 +1,7 @@
 use byteorder::{LittleEndian, ReadBytesExt, WriteBytesExt};
 use std::collections::{BTreeMap, BTreeSet};
 use std::io::{self, Read, Write};
+use std::mem;
 
 use bridgetree::{BridgeTree, Checkpoint, MerkleBridge};
 use incrementalmerkletree::{Address, Hashable, Level, Position};
@@ -337,6 +338,37 @@ pub fn write_tree<H: Hashable + HashSer + Ord, const DEPTH: u8, W: Write>(
     Ok(())
 }
 
+/// Estimates the heap memory held by a [`BridgeTree`]: the bridges with their ommers and
+/// tracked addresses, the marked positions and the checkpoints. The per-node overhead of the
+/// underlying collections is not counted.
+pub fn tree_dynamic_usage<H: Hashable + Ord, const DEPTH: u8>(
+    tree: &BridgeTree<H, u32, DEPTH>,
+) -> usize {
+    let bridges: usize = tree
+        .prior_bridges()
+        .iter()
+        .chain(tree.current_bridge().iter())
+        .map(|bridge| {
+            mem::size_of::<MerkleBridge<H>>()
+                + bridge.tracking().len() * mem::size_of::<Address>()
+                + bridge.ommers().len() * (mem::size_of::<Address>() + mem::size_of::<H>())
+                + bridge.frontier().ommers().len() * mem::size_of::<H>()
+        })
+        .sum();
+    let marked =
+        tree.marked_indices().len() * (mem::size_of::<Position>() + mem::size_of::<usize>());
+    let checkpoints: usize = tree
+        .checkpoints()
+        .iter()
+        .map(|checkpoint| {
+            mem::size_of::<Checkpoint<u32>>()
+                + (checkpoint.marked().len() + checkpoint.forgotten().len())
+                    * mem::size_of::<Position>()
+        })
+        .sum();
+    bridges + marked + checkpoints
+}
+
 #[cfg(test)]
 mod tests {
     use bridgetree::BridgeTree;
@@ -8,15 +8,18 @@ use crate::{ORCHARD_PK, ORCHARD_VK};
 mod ffi {
     #[namespace = "init"]
     extern "Rust" {
-        fn rayon_threadpool();
+        fn rayon_threadpool(num_threads: usize);
         fn zksnark_params(sprout_path: String, load_proving_keys: bool);
     }
 }
 
 static PROOF_PARAMETERS_LOADED: Once = Once::new();
 
-fn rayon_threadpool() {
+/// Initializes the global Rayon threadpool. If `num_threads` is zero, Rayon picks
+/// the number of threads itself (one per core).
+fn rayon_threadpool(num_threads: usize) {
     rayon::ThreadPoolBuilder::new()
+        .num_threads(num_threads)
         .thread_name(|i| format!("zc-rayon-{}", i))
         .build_global()
         .expect("Only initialized once");
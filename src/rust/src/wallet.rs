@@ -27,7 +27,7 @@ use orchard::{
 
 use crate::{
     builder_ffi::OrchardSpendInfo,
-    incremental_merkle_tree::{read_tree, write_tree},
+    incremental_merkle_tree::{read_tree, tree_dynamic_usage, write_tree},
     streams_ffi::{CppStreamReader, CppStreamWriter, ReadCb, StreamObj, WriteCb},
     zcashd_orchard::OrderedAddress,
 };
@@ -162,6 +162,10 @@ pub struct Wallet {
     /// this map are the outpoints where the spent notes were created, and the values
     /// are the inpoints identifying the actions in which they are spent.
     mined_notes: BTreeMap<OutPoint, InPoint>,
+    /// The outpoints of received notes that are not in `mined_notes`, indexed by the
+    /// incoming viewing key that decrypted them. This lets spendable-note queries for
+    /// a key avoid walking every note the wallet has ever received.
+    unspent_notes: BTreeMap<IncomingViewingKey, BTreeSet<OutPoint>>,
     /// For each nullifier which appears more than once in transactions that this
     /// wallet has observed, the set of inpoints where those nullifiers were
     /// observed as as having been spent.
@@ -238,6 +242,7 @@ impl Wallet {
             last_checkpoint: None,
             last_observed: None,
             mined_notes: BTreeMap::new(),
+            unspent_notes: BTreeMap::new(),
             potential_spends: BTreeMap::new(),
         }
     }
@@ -253,6 +258,22 @@ impl Wallet {
         self.last_checkpoint = None;
         self.last_observed = None;
         self.mined_notes = BTreeMap::new();
+
+        // With the spentness information gone, every received note is unspent again.
+        self.unspent_notes.clear();
+        let outpoints: Vec<_> = self
+            .wallet_received_notes
+            .iter()
+            .flat_map(|(txid, tx_notes)| {
+                tx_notes.decrypted_notes.keys().map(move |action_idx| OutPoint {
+                    txid: *txid,
+                    action_idx: *action_idx,
+                })
+            })
+            .collect();
+        for outpoint in outpoints {
+            self.index_unspent_note(outpoint);
+        }
     }
 
     /// Checkpoints the note commitment tree. This returns `false` and leaves the note
@@ -337,7 +358,16 @@ impl Wallet {
                 .collect();
             tracing::trace!("Retaining notes in transactions {:?}", to_retain);
 
+            let unmined: Vec<_> = self
+                .mined_notes
+                .iter()
+                .filter(|(_, v)| !to_retain.contains(&v.txid))
+                .map(|(outpoint, _)| *outpoint)
+                .collect();
             self.mined_notes.retain(|_, v| to_retain.contains(&v.txid));
+            for outpoint in unmined {
+                self.index_unspent_note(outpoint);
+            }
 
             // nullifier and received note data are retained, because these values are stable
             // once we've observed a note for the first time. The block height at which we
@@ -496,6 +526,10 @@ impl Wallet {
             // to decrypt the note
             self.key_store.add_raw_address(recipient, ivk.clone());
 
+            if !self.mined_notes.contains_key(&outpoint) {
+                self.unspent_notes.entry(ivk).or_default().insert(outpoint);
+            }
+
             true
         } else {
             tracing::trace!("Can't add decrypted note to the wallet, missing FVK");
@@ -629,23 +663,50 @@ impl Wallet {
 
             // For nullifiers that are ours that we detect as spent by this action,
             // we will record that input as being mined.
-            if let Some(outpoint) = self.nullifiers.get(action.nullifier()) {
+            if let Some(outpoint) = self.nullifiers.get(action.nullifier()).copied() {
                 assert!(self
                     .mined_notes
                     .insert(
-                        *outpoint,
+                        outpoint,
                         InPoint {
                             txid: *txid,
                             action_idx,
                         },
                     )
                     .is_none());
+                self.unindex_unspent_note(&outpoint);
             }
         }
 
         Ok(())
     }
 
+    /// Returns the incoming viewing key for the recipient of the note at the given outpoint.
+    fn ivk_for_outpoint(&self, outpoint: &OutPoint) -> Option<IncomingViewingKey> {
+        self.wallet_received_notes
+            .get(&outpoint.txid)
+            .and_then(|tx_notes| tx_notes.decrypted_notes.get(&outpoint.action_idx))
+            .and_then(|dnote| self.key_store.ivk_for_address(&dnote.note.recipient()))
+            .cloned()
+    }
+
+    fn index_unspent_note(&mut self, outpoint: OutPoint) {
+        if let Some(ivk) = self.ivk_for_outpoint(&outpoint) {
+            self.unspent_notes.entry(ivk).or_default().insert(outpoint);
+        }
+    }
+
+    fn unindex_unspent_note(&mut self, outpoint: &OutPoint) {
+        if let Some(ivk) = self.ivk_for_outpoint(outpoint) {
+            if let Some(outpoints) = self.unspent_notes.get_mut(&ivk) {
+                outpoints.remove(outpoint);
+                if outpoints.is_empty() {
+                    self.unspent_notes.remove(&ivk);
+                }
+            }
+        }
+    }
+
     /// Returns whether the transaction contains any notes either sent to or spent by this
     /// wallet.
     pub fn tx_involves_my_notes(&self, txid: &TxId) -> bool {
@@ -661,6 +722,9 @@ impl Wallet {
         require_spending_key: bool,
     ) -> Vec<(OutPoint, DecryptedNote)> {
         tracing::trace!("Filtering notes");
+        if ignore_mined {
+            return self.get_unspent_notes(ivk, require_spending_key);
+        }
         self.wallet_received_notes
             .iter()
             .flat_map(|(txid, tx_notes)| {
@@ -693,6 +757,40 @@ impl Wallet {
             .collect()
     }
 
+    /// Equivalent to `get_filtered_notes` with `ignore_mined` set, but only visits the
+    /// unspent notes of the requested key (or of all keys, if `ivk` is `None`).
+    fn get_unspent_notes(
+        &self,
+        ivk: Option<&IncomingViewingKey>,
+        require_spending_key: bool,
+    ) -> Vec<(OutPoint, DecryptedNote)> {
+        let by_key: Box<dyn Iterator<Item = (&IncomingViewingKey, &BTreeSet<OutPoint>)>> =
+            match ivk {
+                Some(ivk) => Box::new(self.unspent_notes.get_key_value(ivk).into_iter()),
+                None => Box::new(self.unspent_notes.iter()),
+            };
+        let mut notes: Vec<_> = by_key
+            .filter(|(note_ivk, _)| {
+                !require_spending_key || self.key_store.spending_key_for_ivk(note_ivk).is_some()
+            })
+            .flat_map(|(_, outpoints)| outpoints.iter())
+            .filter_map(|outpoint| {
+                self.wallet_received_notes
+                    .get(&outpoint.txid)
+                    .and_then(|tx_notes| tx_notes.decrypted_notes.get(&outpoint.action_idx))
+                    .map(|dnote| {
+                        tracing::trace!("Selected note at {:?}", outpoint);
+                        (*outpoint, dnote.clone())
+                    })
+            })
+            .collect();
+        // Preserve the outpoint order of a full scan when several keys are involved.
+        if ivk.is_none() {
+            notes.sort_by_key(|(outpoint, _)| *outpoint);
+        }
+        notes
+    }
+
     /// Returns the root of the Orchard note commitment tree, as of the specified checkpoint
     /// depth. A depth of 0 corresponds to the chain tip.
     pub fn note_commitment_tree_root(&self, checkpoint_depth: usize) -> Option<MerkleHashOrchard> {
@@ -1418,6 +1516,12 @@ pub extern "C" fn orchard_wallet_init_from_frontier(
     }
 }
 
+#[no_mangle]
+pub extern "C" fn orchard_wallet_note_commitment_tree_usage(wallet: *const Wallet) -> usize {
+    let wallet = unsafe { wallet.as_ref() }.expect("Wallet pointer may not be null.");
+    tree_dynamic_usage(&wallet.commitment_tree)
+}
+
 #[no_mangle]
 pub extern "C" fn orchard_wallet_unspent_notes_are_spendable(wallet: *const Wallet) -> bool {
     let wallet = unsafe { wallet.as_ref() }.expect("Wallet pointer may not be null.");
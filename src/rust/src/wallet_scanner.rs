@@ -591,6 +591,12 @@ pub(crate) fn init_batch_scanner(
 }
 
 impl BatchScanner {
+    /// Returns the memory held by the outputs queued for trial decryption, including the
+    /// batches running on the global threadpool and their results.
+    pub(crate) fn memory_usage(&self) -> usize {
+        self.dynamic_usage()
+    }
+
     /// Adds the given transaction's shielded outputs to the various batch runners.
     ///
     /// `block_tag` is the hash of the block that triggered this txid being added to the
@@ -8,6 +8,7 @@
 #include "reverselock.h"
 
 #include <assert.h>
+#include <functional>
 #include <utility>
 
 #include <boost/bind/bind.hpp>
@@ -121,3 +122,76 @@ size_t CScheduler::getQueueInfo(boost::chrono::system_clock::time_point &first,
     }
     return result;
 }
+
+void SingleThreadedSchedulerClient::MaybeScheduleProcessQueue()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutexCallbacks);
+        // A second ProcessQueue scheduled by a race here finds the queue
+        // running or empty and returns.
+        if (fCallbacksRunning || callbacksPending.empty()) {
+            return;
+        }
+    }
+    pscheduler->schedule(std::bind(&SingleThreadedSchedulerClient::ProcessQueue, this),
+                         boost::chrono::system_clock::now());
+}
+
+void SingleThreadedSchedulerClient::ProcessQueue()
+{
+    std::function<void(void)> callback;
+    {
+        boost::unique_lock<boost::mutex> lock(mutexCallbacks);
+        if (fCallbacksRunning || callbacksPending.empty()) {
+            return;
+        }
+        fCallbacksRunning = true;
+        callback = std::move(callbacksPending.front());
+        callbacksPending.pop_front();
+    }
+
+    // Clear the flag and schedule the next callback even if this one throws.
+    struct CallbacksRunningGuard {
+        SingleThreadedSchedulerClient* client;
+        ~CallbacksRunningGuard() {
+            {
+                boost::unique_lock<boost::mutex> lock(client->mutexCallbacks);
+                client->fCallbacksRunning = false;
+            }
+            client->MaybeScheduleProcessQueue();
+        }
+    } guard{this};
+    callback();
+}
+
+void SingleThreadedSchedulerClient::AddToProcessQueue(std::function<void(void)> func)
+{
+    assert(pscheduler);
+    {
+        boost::unique_lock<boost::mutex> lock(mutexCallbacks);
+        callbacksPending.emplace_back(std::move(func));
+    }
+    MaybeScheduleProcessQueue();
+}
+
+void SingleThreadedSchedulerClient::EmptyQueue()
+{
+    while (true) {
+        std::function<void(void)> callback;
+        {
+            boost::unique_lock<boost::mutex> lock(mutexCallbacks);
+            if (callbacksPending.empty()) {
+                return;
+            }
+            callback = std::move(callbacksPending.front());
+            callbacksPending.pop_front();
+        }
+        callback();
+    }
+}
+
+size_t SingleThreadedSchedulerClient::CallbacksPending()
+{
+    boost::unique_lock<boost::mutex> lock(mutexCallbacks);
+    return callbacksPending.size();
+}
@@ -13,6 +13,7 @@
 //
 #include <boost/chrono/chrono.hpp>
 #include <boost/thread.hpp>
+#include <list>
 #include <map>
 
 //
@@ -80,4 +81,35 @@ private:
     bool shouldStop() { return stopRequested || (stopWhenEmpty && taskQueue.empty()); }
 };
 
+/**
+ * Runs callbacks on a CScheduler one at a time, in the order they were added,
+ * even if the scheduler is serviced by several threads.
+ */
+class SingleThreadedSchedulerClient
+{
+public:
+    explicit SingleThreadedSchedulerClient(CScheduler* pschedulerIn) : pscheduler(pschedulerIn) {}
+
+    /** Adds a callback to be run after every callback added before it. */
+    void AddToProcessQueue(std::function<void(void)> func);
+
+    /**
+     * Runs the remaining callbacks on the calling thread. Must only be called
+     * once nothing else services the scheduler, e.g. at shutdown.
+     */
+    void EmptyQueue();
+
+    size_t CallbacksPending();
+
+private:
+    CScheduler* pscheduler;
+
+    boost::mutex mutexCallbacks;
+    std::list<std::function<void(void)>> callbacksPending;
+    bool fCallbacksRunning = false;
+
+    void MaybeScheduleProcessQueue();
+    void ProcessQueue();
+};
+
 #endif
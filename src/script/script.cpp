@@ -9,6 +9,8 @@
 #include "tinyformat.h"
 #include "util/strencodings.h"
 
+#include <algorithm>
+
 using namespace std;
 
 const char* GetOpName(opcodetype opcode)
@@ -254,19 +256,23 @@ CScript::ScriptType CScript::GetType() const
 
 // insightexplorer
 uint160 CScript::AddressHash() const
+{
+    // unknown script types return zeros (this can happen)
+    uint160 addressHash;
+    ExtractAddressHash(addressHash);
+    return addressHash;
+}
+
+CScript::ScriptType CScript::ExtractAddressHash(uint160& addressHash) const
 {
     // where the address bytes begin depends on the script type
-    int start;
-    if (this->IsPayToPublicKeyHash())
-        start = 3;
-    else if (this->IsPayToScriptHash())
-        start = 2;
-    else {
-        // unknown script type; return zeros (this can happen)
-        vector<unsigned char> hashBytes;
-        hashBytes.resize(20);
-        return uint160(hashBytes);
+    if (this->IsPayToPublicKeyHash()) {
+        std::copy(this->begin() + 3, this->begin() + 23, addressHash.begin());
+        return CScript::P2PKH;
+    }
+    if (this->IsPayToScriptHash()) {
+        std::copy(this->begin() + 2, this->begin() + 22, addressHash.begin());
+        return CScript::P2SH;
     }
-    vector<unsigned char> hashBytes(this->begin()+start, this->begin()+start+20);
-    return uint160(hashBytes);
+    return CScript::UNKNOWN;
 }
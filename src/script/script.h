@@ -604,6 +604,12 @@ public:
     bool IsPayToScriptHash() const;
     ScriptType GetType() const;
     uint160 AddressHash() const;
+    /**
+     * Classifies the script and, for a P2PKH or P2SH script, copies the hash
+     * it pays to into addressHash straight from the script bytes. Returns
+     * UNKNOWN and leaves addressHash untouched for any other script.
+     */
+    ScriptType ExtractAddressHash(uint160& addressHash) const;
 
     /** Called by IsStandardTx and P2SH/BIP62 VerifyScript (which makes it consensus-critical). */
     bool IsPushOnly(const_iterator pc) const;
@@ -6,6 +6,8 @@
 
 #include "sigcache.h"
 
+#include "crypto/common.h"
+#include "crypto/sha256.h"
 #include "memusage.h"
 #include "pubkey.h"
 #include "random.h"
@@ -67,6 +69,64 @@ public:
  * signatureCache could be made local to VerifySignature.
 */
 static CSignatureCache signatureCache;
+
+/**
+ * Cache of transactions whose scripts have all been executed successfully,
+ * so that a transaction accepted to the mempool does not have its scripts
+ * interpreted again when it is connected in a block.
+ */
+class CScriptExecutionCache
+{
+private:
+    //! Entries are SHA256(nonce || txid || auth digest || flags || consensus branch ID).
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    bool fInitialized = false;
+    boost::shared_mutex cs_scriptcache;
+
+public:
+    CScriptExecutionCache()
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    void ComputeEntry(uint256& entry, const CTransaction& tx, unsigned int flags, uint32_t consensusBranchId)
+    {
+        unsigned char vchFlags[8];
+        WriteLE32(vchFlags, flags);
+        WriteLE32(vchFlags + 4, consensusBranchId);
+        CSHA256()
+            .Write(nonce.begin(), 32)
+            .Write(tx.GetHash().begin(), 32)
+            .Write(tx.GetAuthDigest().begin(), 32)
+            .Write(vchFlags, sizeof(vchFlags))
+            .Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry, const bool erase)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_scriptcache);
+        return fInitialized && setValid.contains(entry, erase);
+    }
+
+    void Set(uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_scriptcache);
+        if (fInitialized) {
+            setValid.insert(entry);
+        }
+    }
+
+    uint32_t setup_bytes(size_t n)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_scriptcache);
+        fInitialized = true;
+        return setValid.setup_bytes(n);
+    }
+};
+
+static CScriptExecutionCache scriptExecutionCache;
 }
 
 // To be called once in AppInit2/TestingSetup to initialize the signatureCache
@@ -78,6 +138,31 @@ void InitSignatureCache(size_t nMaxCacheSize)
             (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
 }
 
+void InitScriptExecutionCache(size_t nMaxCacheSize)
+{
+    if (nMaxCacheSize <= 0) return;
+    size_t nElems = scriptExecutionCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for script execution cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
+
+uint256 ScriptExecutionCacheEntry(const CTransaction& tx, unsigned int flags, uint32_t consensusBranchId)
+{
+    uint256 entry;
+    scriptExecutionCache.ComputeEntry(entry, tx, flags, consensusBranchId);
+    return entry;
+}
+
+bool ScriptExecutionCacheContains(const uint256& entry, bool erase)
+{
+    return scriptExecutionCache.Get(entry, erase);
+}
+
+void ScriptExecutionCacheAdd(uint256& entry)
+{
+    scriptExecutionCache.Set(entry);
+}
+
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
@@ -52,4 +52,16 @@ public:
 
 void InitSignatureCache(size_t nMaxCacheSize);
 
+/**
+ * The script execution cache remembers transactions whose scripts all passed
+ * under a given set of flags and consensus branch, keyed by txid and auth
+ * digest. The spent outputs need not be part of the key, as they are fixed by
+ * the prevouts that the txid commits to.
+ */
+void InitScriptExecutionCache(size_t nMaxCacheSize);
+uint256 ScriptExecutionCacheEntry(const CTransaction& tx, unsigned int flags, uint32_t consensusBranchId);
+/** Looks up an entry; with erase set, a hit may be evicted to make room. */
+bool ScriptExecutionCacheContains(const uint256& entry, bool erase);
+void ScriptExecutionCacheAdd(uint256& entry);
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
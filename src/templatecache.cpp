@@ -0,0 +1,168 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "templatecache.h"
+
+#include "chainparams.h"
+#include "consensus/upgrades.h"
+#include "consensus/validation.h"
+#include "hash.h"
+#include "main.h"
+#include "script/interpreter.h"
+#include "sync.h"
+#include "util/system.h"
+#include "util/time.h"
+
+#include <algorithm>
+#include <deque>
+
+#include <boost/thread.hpp>
+
+#include <rust/metrics.h>
+
+namespace {
+
+CCriticalSection cs_templates;
+//! Keys of the most recently issued templates, oldest first.
+std::deque<uint256> rememberedTemplates;
+
+boost::mutex mutexAudits;
+boost::condition_variable condAudits;
+std::deque<TemplateBlockAudit> pendingAudits;
+
+}
+
+uint256 BlockTemplateKey(const CBlock& block)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << block.hashPrevBlock;
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        ss << block.vtx[i].GetHash() << block.vtx[i].GetAuthDigest();
+    }
+    return ss.GetHash();
+}
+
+void RememberBlockTemplate(const CBlock& block)
+{
+    if (!GetBoolArg("-templatefastpath", DEFAULT_TEMPLATE_FAST_PATH)) {
+        return;
+    }
+    uint256 key = BlockTemplateKey(block);
+    LOCK(cs_templates);
+    if (std::find(rememberedTemplates.begin(), rememberedTemplates.end(), key) != rememberedTemplates.end()) {
+        return;
+    }
+    rememberedTemplates.push_back(key);
+    if (rememberedTemplates.size() > MAX_REMEMBERED_TEMPLATES) {
+        rememberedTemplates.pop_front();
+    }
+}
+
+bool IsFromRememberedTemplate(const CBlock& block)
+{
+    {
+        LOCK(cs_templates);
+        if (rememberedTemplates.empty()) {
+            return false;
+        }
+    }
+    uint256 key = BlockTemplateKey(block);
+    LOCK(cs_templates);
+    return std::find(rememberedTemplates.begin(), rememberedTemplates.end(), key) != rememberedTemplates.end();
+}
+
+bool AuditTemplateBlock(
+    const TemplateBlockAudit& audit,
+    const Consensus::Params& consensusParams,
+    std::string& strError)
+{
+    const unsigned int flags = BLOCK_SCRIPT_VERIFY_FLAGS;
+    const uint32_t consensusBranchId = CurrentEpochBranchId(audit.nHeight, consensusParams);
+
+    auto saplingAuth = sapling::init_batch_validator(false);
+    auto orchardAuth = orchard::init_batch_validator(false);
+    for (size_t i = 1; i < audit.block.vtx.size(); i++) {
+        const CTransaction& tx = audit.block.vtx[i];
+        const std::vector<CTxOut>& spentOutputs = audit.vSpentOutputs[i];
+        PrecomputedTransactionData txdata(tx, spentOutputs);
+
+        for (unsigned int j = 0; j < tx.vin.size(); j++) {
+            CScriptCheck check(spentOutputs[j], tx, j, flags, false, consensusBranchId, &txdata);
+            if (!check()) {
+                strError = strprintf("script check failed for input %d of %s (%s)",
+                    j, tx.GetHash().ToString(), ScriptErrorString(check.GetScriptError()));
+                return false;
+            }
+        }
+
+        if (tx.GetSaplingBundle().IsPresent() || tx.GetOrchardBundle().IsPresent()) {
+            CScript scriptCode;
+            uint256 dataToBeSigned = SignatureHash(
+                scriptCode, tx, NOT_AN_INPUT, SIGHASH_ALL, 0, consensusBranchId, txdata);
+            if (!tx.GetSaplingBundle().QueueAuthValidation(*saplingAuth, dataToBeSigned)) {
+                strError = strprintf("Sapling bundle of %s is invalid", tx.GetHash().ToString());
+                return false;
+            }
+            tx.GetOrchardBundle().QueueAuthValidation(*orchardAuth, dataToBeSigned);
+        }
+    }
+    if (!saplingAuth->validate()) {
+        strError = "a Sapling bundle within the block is invalid";
+        return false;
+    }
+    if (!orchardAuth->validate()) {
+        strError = "an Orchard bundle within the block is invalid";
+        return false;
+    }
+    return true;
+}
+
+void QueueTemplateBlockAudit(TemplateBlockAudit audit)
+{
+    boost::unique_lock<boost::mutex> lock(mutexAudits);
+    pendingAudits.push_back(std::move(audit));
+    condAudits.notify_one();
+}
+
+void ThreadTemplateBlockAudit()
+{
+    const CChainParams& chainparams = Params();
+    while (true) {
+        TemplateBlockAudit audit;
+        {
+            boost::unique_lock<boost::mutex> lock(mutexAudits);
+            while (pendingAudits.empty()) {
+                condAudits.wait(lock);
+            }
+            audit = std::move(pendingAudits.front());
+            pendingAudits.pop_front();
+        }
+
+        int64_t nStart = GetTimeMicros();
+        std::string strError;
+        if (AuditTemplateBlock(audit, chainparams.GetConsensus(), strError)) {
+            LogPrint("bench", "%s: audited block %s in %.2fms\n",
+                __func__, audit.hashBlock.ToString(), (GetTimeMicros() - nStart) * 0.001);
+            continue;
+        }
+
+        // The block was connected and relayed on the strength of our own
+        // mempool checks, which were wrong. Back it out.
+        LogPrintf("ERROR: %s: block %s built from a local template failed full validation: %s\n",
+            __func__, audit.hashBlock.ToString(), strError);
+        MetricsIncrementCounter("zcashd.templatefastpath.audit_failures");
+        CValidationState state;
+        {
+            LOCK(cs_main);
+            BlockMap::iterator mi = mapBlockIndex.find(audit.hashBlock);
+            if (mi == mapBlockIndex.end()) {
+                continue;
+            }
+            InvalidateBlock(state, chainparams, mi->second);
+        }
+        if (state.IsValid()) {
+            ActivateBestChain(state, chainparams);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_TEMPLATECACHE_H
+#define BITCOIN_TEMPLATECACHE_H
+
+#include "primitives/block.h"
+#include "primitives/transaction.h"
+#include "uint256.h"
+
+#include <string>
+#include <vector>
+
+namespace Consensus { struct Params; };
+
+/**
+ * Fast path for blocks built from our own templates.
+ *
+ * Every template handed out by BlockAssembler has been checked against its
+ * parent by TestBlockValidity, and the proofs and signatures of its
+ * transactions were verified when they entered the mempool. When a block
+ * arrives whose parent and non-coinbase transactions (including their
+ * authorizing data) match such a template, ConnectBlock skips script and
+ * shielded authorization checks for those transactions, so that a block we
+ * just found is connected and relayed without re-verifying it. The coinbase
+ * and every contextual rule are still checked, and the skipped checks are
+ * re-run by a background audit that invalidates the block if they fail.
+ *
+ * Templates are matched on their transactions rather than on the merkle root,
+ * which changes with every extra nonce.
+ */
+
+/** Default for -templatefastpath. */
+static const bool DEFAULT_TEMPLATE_FAST_PATH = true;
+/** Number of recently issued templates that are remembered. */
+static const size_t MAX_REMEMBERED_TEMPLATES = 16;
+
+/**
+ * Commits to the parent of the block and the txid and authorizing data digest
+ * of every transaction except the coinbase, in order.
+ */
+uint256 BlockTemplateKey(const CBlock& block);
+
+/** Records a template that passed TestBlockValidity. */
+void RememberBlockTemplate(const CBlock& block);
+bool IsFromRememberedTemplate(const CBlock& block);
+
+/** The checks skipped when a block was connected through the fast path. */
+struct TemplateBlockAudit {
+    uint256 hashBlock;
+    int nHeight = 0;
+    CBlock block;
+    //! Outputs spent by each transaction, indexed like block.vtx.
+    std::vector<std::vector<CTxOut>> vSpentOutputs;
+};
+
+/**
+ * Verifies the scripts and the shielded proofs and signatures of the
+ * non-coinbase transactions. Returns false and sets strError on failure.
+ */
+bool AuditTemplateBlock(
+    const TemplateBlockAudit& audit,
+    const Consensus::Params& consensusParams,
+    std::string& strError);
+
+void QueueTemplateBlockAudit(TemplateBlockAudit audit);
+
+/** Background thread that audits fast-path blocks. */
+void ThreadTemplateBlockAudit();
+
+#endif // BITCOIN_TEMPLATECACHE_H
@@ -379,6 +379,59 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_FrozenCleanup)
 }
 
 
+// Test that once a check fails, the checks that are still queued are
+// discarded rather than evaluated.
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Cancels_After_Failure)
+{
+    typedef CCheckQueue<CFunctionCheck> Function_Queue;
+    auto queue = std::unique_ptr<Function_Queue>(new Function_Queue {QUEUE_BATCH_SIZE});
+    boost::thread_group tg;
+    for (auto x = 0; x < nScriptCheckThreads; ++x) {
+        tg.create_thread([&]{queue->Thread();});
+    }
+
+    const size_t COUNT = 100000;
+    std::atomic<size_t> n_calls {0};
+    std::atomic<bool> fFailureAdded {false};
+    {
+        CCheckQueueControl<CFunctionCheck> control(queue.get());
+        std::vector<CFunctionCheck> vChecks;
+        vChecks.emplace_back([]{ return false; });
+        control.Add(vChecks);
+        BOOST_REQUIRE(!control.Wait());
+    }
+    {
+        CCheckQueueControl<CFunctionCheck> control(queue.get());
+        std::vector<CFunctionCheck> vChecks;
+        for (size_t i = 0; i < COUNT; i++) {
+            vChecks.emplace_back([&]{
+                ++n_calls;
+                // Don't let the workers get through everything before the
+                // failing check has been queued.
+                while (!fFailureAdded) MilliSleep(1);
+                return true;
+            });
+        }
+        control.Add(vChecks);
+        vChecks.clear();
+        vChecks.emplace_back([&]{ ++n_calls; return false; });
+        control.Add(vChecks);
+        fFailureAdded = true;
+        BOOST_REQUIRE(!control.Wait());
+    }
+    BOOST_CHECK(n_calls < COUNT);
+
+    // The failure must not leak into the next verification.
+    {
+        CCheckQueueControl<CFunctionCheck> control(queue.get());
+        std::vector<CFunctionCheck> vChecks(10);
+        control.Add(vChecks);
+        BOOST_REQUIRE(control.Wait());
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
 /** Test that CCheckQueueControl is threadsafe */
 BOOST_AUTO_TEST_CASE(test_CheckQueueControl_Locks)
 {
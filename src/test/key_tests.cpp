@@ -162,6 +162,35 @@ BOOST_AUTO_TEST_CASE(key_test1)
     BOOST_CHECK(detsigc == ParseHex("2052d8a32079c11e79db95af63bb9600c5b04f21a9ca33dc129c2bfa8ac9dc1cd561d8ae5e0f6c1a16bde3719c64c2fd70e404b6428ab9a69566962e8771b5944d"));
 }
 
+BOOST_AUTO_TEST_CASE(pubkey_parse_cache)
+{
+    KeyIO keyIO(Params());
+    CKey key1  = keyIO.DecodeSecret(strSecret1);
+    CKey key1C = keyIO.DecodeSecret(strSecret1C);
+    CPubKey pubkey1  = key1. GetPubKey();
+    CPubKey pubkey1C = key1C.GetPubKey();
+
+    uint256 hashMsg = Hash(strSecret1.begin(), strSecret1.end());
+    vector<unsigned char> sign1;
+    BOOST_CHECK(key1.Sign(hashMsg, sign1));
+
+    // Both encodings of the key share an x coordinate, and so a cache slot.
+    BOOST_CHECK(pubkey1.Verify(hashMsg, sign1));
+    BOOST_CHECK(pubkey1C.Verify(hashMsg, sign1));
+    BOOST_CHECK(pubkey1.Verify(hashMsg, sign1));
+
+    // A key that differs from a cached one only in its last byte is not
+    // mistaken for it.
+    for (const CPubKey& pubkey : {pubkey1, pubkey1C}) {
+        vector<unsigned char> vch(pubkey.begin(), pubkey.end());
+        vch.back() ^= 1;
+        CPubKey tampered(vch.begin(), vch.end());
+        BOOST_CHECK(pubkey.Verify(hashMsg, sign1));
+        BOOST_CHECK(!tampered.Verify(hashMsg, sign1));
+        BOOST_CHECK(pubkey.Verify(hashMsg, sign1));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(zc_address_test)
 {
     KeyIO keyIO(Params());
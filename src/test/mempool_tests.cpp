@@ -11,6 +11,8 @@
 #include "test/test_bitcoin.h"
 
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <limits>
 #include <list>
 #include <vector>
 
@@ -374,6 +376,71 @@ BOOST_AUTO_TEST_CASE(RemoveWithoutBranchId) {
     BOOST_CHECK_EQUAL(pool.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(RemoveExpired) {
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+    entry.hadNoDependencies = true;
+
+    // Expiry heights 0 (never), 10, 11, ..., 19
+    std::vector<uint256> txids;
+    for (auto i = 0; i < 11; i++) {
+        CMutableTransaction tx = CMutableTransaction();
+        tx.fOverwintered = true;
+        tx.nVersion = SAPLING_TX_VERSION;
+        tx.nVersionGroupId = SAPLING_VERSION_GROUP_ID;
+        tx.nExpiryHeight = i == 0 ? 0 : 9 + i;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        tx.vout[0].nValue = COIN;
+        pool.addUnchecked(tx.GetHash(), entry.FromTx(tx));
+        txids.push_back(tx.GetHash());
+    }
+    BOOST_CHECK_EQUAL(pool.size(), 11);
+
+    BOOST_CHECK(pool.removeExpired(10).empty());
+    std::vector<uint256> expired = pool.removeExpired(12);
+    std::sort(expired.begin(), expired.end());
+    std::vector<uint256> expected{txids[1], txids[2]};
+    std::sort(expected.begin(), expected.end());
+    BOOST_CHECK(expired == expected);
+    BOOST_CHECK_EQUAL(pool.size(), 9);
+
+    BOOST_CHECK_EQUAL(pool.removeExpired(100).size(), 8);
+    BOOST_CHECK_EQUAL(pool.size(), 1);
+    BOOST_CHECK(pool.exists(txids[0]));
+}
+
+BOOST_AUTO_TEST_CASE(MaturityHeight) {
+    TestMemPoolEntryHelper entry;
+    CMutableTransaction tx = CMutableTransaction();
+    tx.vin.resize(1);
+    tx.vin[0].nSequence = 0;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = COIN;
+
+    // Nothing can become invalid at a lower height.
+    BOOST_CHECK_EQUAL(entry.Height(100).FromTx(tx).GetMaturityHeight(), 0);
+
+    // Coinbase spends were mature at the height the entry was accepted at.
+    BOOST_CHECK_EQUAL(entry.Height(100).SpendsCoinbase(true).FromTx(tx).GetMaturityHeight(), 101);
+
+    // Height-based lock times.
+    tx.nLockTime = 50;
+    BOOST_CHECK_EQUAL(entry.Height(100).SpendsCoinbase(false).FromTx(tx).GetMaturityHeight(), 51);
+    BOOST_CHECK_EQUAL(entry.Height(100).SpendsCoinbase(true).FromTx(tx).GetMaturityHeight(), 101);
+
+    // Lock times are ignored if every input is final.
+    tx.vin[0].nSequence = std::numeric_limits<uint32_t>::max();
+    BOOST_CHECK_EQUAL(entry.Height(100).SpendsCoinbase(false).FromTx(tx).GetMaturityHeight(), 0);
+
+    // Time-based lock times are always checked.
+    tx.vin[0].nSequence = 0;
+    tx.nLockTime = LOCKTIME_THRESHOLD;
+    BOOST_CHECK_EQUAL(
+        entry.Height(100).SpendsCoinbase(false).FromTx(tx).GetMaturityHeight(),
+        std::numeric_limits<unsigned int>::max());
+}
+
 // Test that nCheckFrequency is set correctly when calling setSanityCheck().
 // https://github.com/zcash/zcash/issues/3134
 BOOST_AUTO_TEST_CASE(SetSanityCheck) {
@@ -313,6 +313,22 @@ BOOST_AUTO_TEST_CASE(rpc_getnetworksolps)
     BOOST_CHECK_NO_THROW(CallRPC("getnetworksolps 120 -1"));
 }
 
+BOOST_AUTO_TEST_CASE(rpc_getmemoryinfo)
+{
+    UniValue r;
+    BOOST_CHECK_NO_THROW(r = CallRPC("getmemoryinfo"));
+    BOOST_CHECK(find_value(r.get_obj(), "usage").isNull());
+    BOOST_CHECK_NO_THROW(r = CallRPC("getmemoryinfo stats"));
+    BOOST_CHECK(find_value(r.get_obj(), "usage").isNull());
+    BOOST_CHECK_NO_THROW(r = CallRPC("getmemoryinfo detailed"));
+    UniValue usage = find_value(r.get_obj(), "usage");
+    BOOST_CHECK(usage.isObject());
+    BOOST_CHECK(find_value(usage.get_obj(), "block_index").get_int64() > 0);
+    BOOST_CHECK(find_value(usage.get_obj(), "coins_db").isNum());
+    BOOST_CHECK_THROW(CallRPC("getmemoryinfo bogus"), runtime_error);
+    BOOST_CHECK_THROW(CallRPC("getmemoryinfo detailed extra"), runtime_error);
+}
+
 // Test parameter processing (not functionality).
 // These tests also ensure that src/rpc/client.cpp has the correct entries.
 BOOST_AUTO_TEST_CASE(rpc_insightexplorer)
@@ -108,4 +108,56 @@ BOOST_AUTO_TEST_CASE(manythreads)
     BOOST_CHECK_EQUAL(counterSum, 200);
 }
 
+BOOST_AUTO_TEST_CASE(singlethreadedclient_ordered)
+{
+    CScheduler scheduler;
+
+    // Two clients on a scheduler serviced by several threads: each client's
+    // callbacks must run one at a time and in order.
+    SingleThreadedSchedulerClient client1(&scheduler);
+    SingleThreadedSchedulerClient client2(&scheduler);
+
+    int counter1 = 0;
+    int counter2 = 0;
+    for (int i = 0; i < 100; i++) {
+        client1.AddToProcessQueue([i, &counter1]() {
+            bool expectation = i == counter1++;
+            assert(expectation);
+        });
+        client2.AddToProcessQueue([i, &counter2]() {
+            bool expectation = i == counter2++;
+            assert(expectation);
+        });
+    }
+
+    boost::thread_group threads;
+    for (int i = 0; i < 5; i++) {
+        threads.create_thread(boost::bind(&CScheduler::serviceQueue, &scheduler));
+    }
+
+    // Drain the task queue then exit threads
+    scheduler.stop(true);
+    threads.join_all();
+
+    BOOST_CHECK_EQUAL(counter1, 100);
+    BOOST_CHECK_EQUAL(counter2, 100);
+    BOOST_CHECK_EQUAL(client1.CallbacksPending(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(singlethreadedclient_emptyqueue)
+{
+    CScheduler scheduler;
+    SingleThreadedSchedulerClient client(&scheduler);
+
+    // Nothing services the scheduler, so the callbacks run on this thread.
+    std::vector<int> order;
+    for (int i = 0; i < 3; i++) {
+        client.AddToProcessQueue([i, &order]() { order.push_back(i); });
+    }
+    BOOST_CHECK_EQUAL(client.CallbacksPending(), 3);
+    client.EmptyQueue();
+    BOOST_CHECK_EQUAL(client.CallbacksPending(), 0);
+    BOOST_CHECK(order == std::vector<int>({0, 1, 2}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
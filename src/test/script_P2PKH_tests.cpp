@@ -57,4 +57,33 @@ BOOST_AUTO_TEST_CASE(IsPayToPublicKeyHash)
 
 }
 
+BOOST_AUTO_TEST_CASE(ExtractAddressHash)
+{
+    // Test CScript::ExtractAddressHash() against GetType() and AddressHash()
+    uint160 hash;
+    hash.SetHex("0102030405060708090a0b0c0d0e0f1011121314");
+    CScript p2pkh;
+    p2pkh << OP_DUP << OP_HASH160 << ToByteVector(hash) << OP_EQUALVERIFY << OP_CHECKSIG;
+    CScript p2sh;
+    p2sh << OP_HASH160 << ToByteVector(hash) << OP_EQUAL;
+    CScript other;
+    other << OP_RETURN << ToByteVector(hash);
+
+    uint160 extracted;
+    BOOST_CHECK_EQUAL(p2pkh.ExtractAddressHash(extracted), CScript::P2PKH);
+    BOOST_CHECK(extracted == hash);
+    BOOST_CHECK(p2pkh.AddressHash() == hash);
+
+    extracted.SetNull();
+    BOOST_CHECK_EQUAL(p2sh.ExtractAddressHash(extracted), CScript::P2SH);
+    BOOST_CHECK(extracted == hash);
+    BOOST_CHECK(p2sh.AddressHash() == hash);
+
+    extracted.SetNull();
+    BOOST_CHECK_EQUAL(other.ExtractAddressHash(extracted), CScript::UNKNOWN);
+    BOOST_CHECK(extracted.IsNull());
+    BOOST_CHECK(other.AddressHash().IsNull());
+    BOOST_CHECK_EQUAL(other.GetType(), CScript::UNKNOWN);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
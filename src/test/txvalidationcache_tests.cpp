@@ -3,10 +3,12 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php .
 
+#include "consensus/upgrades.h"
 #include "consensus/validation.h"
 #include "key.h"
 #include "main.h"
 #include "miner.h"
+#include "policy/policy.h"
 #include "pubkey.h"
 #include "txmempool.h"
 #include "random.h"
@@ -85,6 +87,62 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_block_doublespend, TestChain100Setup)
     // block with spends[0] is accepted:
     BOOST_CHECK_EQUAL(mempool.size(), 0);
 }
+
+BOOST_FIXTURE_TEST_CASE(script_execution_cache_connectblock, TestChain100Setup)
+{
+    // ConnectBlock does not run the scripts of a transaction that is in the
+    // script execution cache. Spends with an empty signature fail their
+    // scripts, so a block containing one is only accepted if the check was
+    // skipped.
+    CScript scriptPubKey = CScript() <<  ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    std::vector<CMutableTransaction> spends;
+    spends.resize(2);
+    for (int i = 0; i < 2; i++)
+    {
+        spends[i].vin.resize(1);
+        spends[i].vin[0].prevout.hash = coinbaseTxns[i].GetHash();
+        spends[i].vin[0].prevout.n = 0;
+        spends[i].vin[0].scriptSig << std::vector<unsigned char>();
+        spends[i].vout.resize(1);
+        spends[i].vout[0].nValue = 11*CENT;
+        spends[i].vout[0].scriptPubKey = scriptPubKey;
+    }
+
+    uint32_t consensusBranchId = CurrentEpochBranchId(chainActive.Height() + 1, Params().GetConsensus());
+    uint256 entry = ScriptExecutionCacheEntry(CTransaction(spends[0]), BLOCK_SCRIPT_VERIFY_FLAGS, consensusBranchId);
+    ScriptExecutionCacheAdd(entry);
+
+    CBlock block = CreateAndProcessBlock({spends[0]}, scriptPubKey);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() == block.GetHash());
+
+    // Without a cache entry the scripts run and the block is rejected.
+    block = CreateAndProcessBlock({spends[1]}, scriptPubKey);
+    BOOST_CHECK(chainActive.Tip()->GetBlockHash() != block.GetHash());
+}
 #endif // ENABLE_MINING
 
+BOOST_FIXTURE_TEST_CASE(script_execution_cache, BasicTestingSetup)
+{
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].prevout = COutPoint(GetRandHash(), 0);
+    mtx.vout.resize(1);
+    mtx.vout[0].nValue = 11*CENT;
+    CTransaction tx(mtx);
+
+    uint256 entry = ScriptExecutionCacheEntry(tx, BLOCK_SCRIPT_VERIFY_FLAGS, SPROUT_BRANCH_ID);
+    BOOST_CHECK(!ScriptExecutionCacheContains(entry, false));
+    ScriptExecutionCacheAdd(entry);
+    BOOST_CHECK(ScriptExecutionCacheContains(entry, false));
+
+    // The entry only applies to the same flags and consensus branch.
+    BOOST_CHECK(ScriptExecutionCacheEntry(tx, STANDARD_SCRIPT_VERIFY_FLAGS, SPROUT_BRANCH_ID) != entry);
+    BOOST_CHECK(ScriptExecutionCacheEntry(tx, BLOCK_SCRIPT_VERIFY_FLAGS, 0x5ba81b19) != entry);
+
+    // A different transaction does not hit.
+    mtx.vout[0].nValue = 12*CENT;
+    BOOST_CHECK(!ScriptExecutionCacheContains(
+        ScriptExecutionCacheEntry(CTransaction(mtx), BLOCK_SCRIPT_VERIFY_FLAGS, SPROUT_BRANCH_ID), false));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,250 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "threadbudget.h"
+
+#include "compat.h"
+#include "sync.h"
+#include "util/strencodings.h"
+#include "util/system.h"
+#include "util/time.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <rust/metrics.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <time.h>
+typedef clockid_t ThreadCpuClock;
+#else
+typedef int ThreadCpuClock;
+#endif
+
+namespace {
+
+struct PoolInfo {
+    const char* name;
+    ThreadClass cls;
+    int nDefaultShare;
+};
+
+// Indexed by ThreadPool. Default shares add up to 100%. The async RPC queue
+// always has a single worker, since its operations are not safe to run
+// concurrently, so it takes no share of the budget.
+const PoolInfo POOLS[] = {
+    {"scriptcheck", ThreadClass::VALIDATION, 40},
+    {"rayon",       ThreadClass::VALIDATION, 30},
+    {"http",        ThreadClass::RPC,        15},
+    {"asyncrpc",    ThreadClass::RPC,         0},
+    {"miner",       ThreadClass::MINING,     15},
+};
+static_assert(sizeof(POOLS) / sizeof(POOLS[0]) == (size_t)ThreadPool::NUM_POOLS,
+    "POOLS must have one entry per ThreadPool");
+
+const size_t NUM_POOLS = (size_t)ThreadPool::NUM_POOLS;
+
+int nThreadBudget = 0;
+int nPoolThreads[NUM_POOLS] = {};
+
+struct PoolUsage {
+    //! CPU clocks of the live members of the pool, by member id.
+    std::map<int64_t, ThreadCpuClock> members;
+    //! CPU time accumulated by members that have exited, in nanoseconds.
+    int64_t nRetiredNanos = 0;
+    int64_t nLastCpuNanos = 0;
+    int64_t nLastSampleMicros = 0;
+};
+
+CCriticalSection cs_threadPools;
+PoolUsage poolUsage[NUM_POOLS];
+int64_t nNextMemberId = 0;
+
+int64_t ClockNanos(ThreadCpuClock clock)
+{
+#if defined(__linux__)
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) == 0) {
+        return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+#endif
+    return 0;
+}
+
+int64_t CurrentThreadCpuNanos()
+{
+#if defined(__linux__)
+    return ClockNanos(CLOCK_THREAD_CPUTIME_ID);
+#else
+    return 0;
+#endif
+}
+
+int PriorityForClass(ThreadClass cls)
+{
+    switch (cls) {
+    case ThreadClass::VALIDATION:
+    case ThreadClass::RELAY:
+        return THREAD_PRIORITY_NORMAL;
+    case ThreadClass::RPC:
+        return THREAD_PRIORITY_BELOW_NORMAL;
+    case ThreadClass::MINING:
+        return THREAD_PRIORITY_LOWEST;
+    }
+    return THREAD_PRIORITY_NORMAL;
+}
+
+}
+
+bool InitThreadBudget(int nCores, std::string& strError)
+{
+    nThreadBudget = GetArg("-threadbudget", DEFAULT_THREAD_BUDGET);
+    if (nThreadBudget < 0) {
+        // Like -par, a negative value leaves that many cores free.
+        nThreadBudget = std::max(1, nCores + nThreadBudget);
+    }
+
+    int shares[NUM_POOLS];
+    for (size_t i = 0; i < NUM_POOLS; i++) {
+        shares[i] = POOLS[i].nDefaultShare;
+    }
+    for (const std::string& strShare : GetMultiArg("-threadshare")) {
+        size_t colon = strShare.find(':');
+        int32_t nShare;
+        if (colon == std::string::npos ||
+            !ParseInt32(strShare.substr(colon + 1), &nShare) ||
+            nShare < 0 || nShare > 100)
+        {
+            strError = strprintf("Invalid -threadshare value '%s' (expected <pool>:<percent>)", strShare);
+            return false;
+        }
+        std::string strPool = strShare.substr(0, colon);
+        auto it = std::find_if(std::begin(POOLS), std::end(POOLS),
+            [&](const PoolInfo& info) { return strPool == info.name; });
+        if (it == std::end(POOLS) || it - std::begin(POOLS) == (ptrdiff_t)ThreadPool::ASYNC_RPC) {
+            strError = strprintf("Unknown thread pool '%s' in -threadshare", strPool);
+            return false;
+        }
+        shares[it - std::begin(POOLS)] = nShare;
+    }
+
+    if (nThreadBudget == 0) {
+        return true;
+    }
+
+    // Hand out cores in priority order. Every pool gets at least one thread,
+    // so a budget smaller than the number of pools is oversubscribed only in
+    // the lowest priority classes.
+    std::vector<size_t> order(NUM_POOLS);
+    for (size_t i = 0; i < NUM_POOLS; i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [](size_t a, size_t b) {
+        return POOLS[a].cls < POOLS[b].cls;
+    });
+    int nRemaining = nThreadBudget;
+    for (size_t i : order) {
+        if (i == (size_t)ThreadPool::ASYNC_RPC) {
+            nPoolThreads[i] = 1;
+            continue;
+        }
+        int nWanted = std::max(1, (nThreadBudget * shares[i] + 50) / 100);
+        nPoolThreads[i] = std::max(1, std::min(nWanted, nRemaining));
+        nRemaining = std::max(0, nRemaining - nPoolThreads[i]);
+    }
+    return true;
+}
+
+bool ThreadBudgetEnabled()
+{
+    return nThreadBudget > 0;
+}
+
+const char* ThreadPoolName(ThreadPool pool)
+{
+    return POOLS[(size_t)pool].name;
+}
+
+ThreadClass ThreadPoolClass(ThreadPool pool)
+{
+    return POOLS[(size_t)pool].cls;
+}
+
+int ThreadBudgetFor(ThreadPool pool, int nDefault)
+{
+    if (!ThreadBudgetEnabled()) {
+        return nDefault;
+    }
+    return nPoolThreads[(size_t)pool];
+}
+
+int64_t GetPoolThreadsArg(ThreadPool pool, const std::string& strArg, int64_t nDefault)
+{
+    if (mapArgs.count(strArg) || !ThreadBudgetEnabled()) {
+        return GetArg(strArg, nDefault);
+    }
+    return nPoolThreads[(size_t)pool];
+}
+
+std::string ThreadBudgetToString()
+{
+    if (!ThreadBudgetEnabled()) {
+        return "disabled";
+    }
+    std::string str = strprintf("%d cores:", nThreadBudget);
+    for (size_t i = 0; i < NUM_POOLS; i++) {
+        str += strprintf(" %s=%d", POOLS[i].name, nPoolThreads[i]);
+    }
+    return str;
+}
+
+ThreadPoolMember::ThreadPoolMember(ThreadPool poolIn) : pool(poolIn), nId(-1)
+{
+    if (ThreadBudgetEnabled()) {
+        SetThreadPriority(PriorityForClass(ThreadPoolClass(pool)));
+    }
+#if defined(__linux__)
+    ThreadCpuClock clock;
+    if (pthread_getcpuclockid(pthread_self(), &clock) == 0) {
+        LOCK(cs_threadPools);
+        nId = nNextMemberId++;
+        poolUsage[(size_t)pool].members.emplace(nId, clock);
+    }
+#endif
+}
+
+ThreadPoolMember::~ThreadPoolMember()
+{
+    if (nId < 0) return;
+    // Deregister while still running, as another thread's CPU clock must
+    // not be read once that thread has exited.
+    int64_t nCpuNanos = CurrentThreadCpuNanos();
+    LOCK(cs_threadPools);
+    auto& usage = poolUsage[(size_t)pool];
+    usage.members.erase(nId);
+    usage.nRetiredNanos += nCpuNanos;
+}
+
+void SampleThreadPoolUtilization()
+{
+    LOCK(cs_threadPools);
+    int64_t nNowMicros = GetTimeMicros();
+    for (size_t i = 0; i < NUM_POOLS; i++) {
+        auto& usage = poolUsage[i];
+        int64_t nCpuNanos = usage.nRetiredNanos;
+        for (const auto& member : usage.members) {
+            nCpuNanos += ClockNanos(member.second);
+        }
+        size_t nThreads = usage.members.size();
+        MetricsGauge("zcashd.threads.count", (double)nThreads, "pool", POOLS[i].name);
+
+        if (usage.nLastSampleMicros != 0 && nNowMicros > usage.nLastSampleMicros && nThreads > 0) {
+            double nWallNanos = (double)(nNowMicros - usage.nLastSampleMicros) * 1000;
+            double utilization = (nCpuNanos - usage.nLastCpuNanos) / (nWallNanos * nThreads);
+            MetricsGauge("zcashd.threads.utilization", utilization, "pool", POOLS[i].name);
+        }
+        usage.nLastCpuNanos = nCpuNanos;
+        usage.nLastSampleMicros = nNowMicros;
+    }
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_THREADBUDGET_H
+#define BITCOIN_THREADBUDGET_H
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Core budget for the node's CPU-bound thread pools.
+ *
+ * By default every pool sizes itself to the number of cores, so that under
+ * combined load (IBD, wallet scanning, RPC and mining at once) the node runs
+ * several times more busy threads than there are cores. When -threadbudget
+ * is set, the budget is split between the pools according to their shares
+ * (-threadshare), handing out cores in priority order so that validation is
+ * never starved by RPC or mining. Explicit per-pool options (-par,
+ * -rpcthreads, -genproclimit) still take precedence.
+ */
+
+/** Priority classes, highest priority first. */
+enum class ThreadClass {
+    VALIDATION,
+    RELAY,
+    RPC,
+    MINING,
+};
+
+/** Thread pools managed by the budget, in allocation order. */
+enum class ThreadPool {
+    SCRIPT_CHECK,
+    RAYON,
+    HTTP,
+    ASYNC_RPC,
+    MINER,
+    NUM_POOLS,
+};
+
+/** Default for -threadbudget; 0 disables budgeting. */
+static const int DEFAULT_THREAD_BUDGET = 0;
+/** How often per-pool utilisation is published, in seconds. */
+static const int64_t THREAD_POOL_SAMPLE_INTERVAL = 10;
+
+/**
+ * Reads -threadbudget and -threadshare and computes each pool's share.
+ * Returns false and sets strError if an option is invalid.
+ */
+bool InitThreadBudget(int nCores, std::string& strError);
+
+bool ThreadBudgetEnabled();
+
+const char* ThreadPoolName(ThreadPool pool);
+ThreadClass ThreadPoolClass(ThreadPool pool);
+
+/** Number of threads assigned to the pool, or nDefault if budgeting is disabled. */
+int ThreadBudgetFor(ThreadPool pool, int nDefault);
+
+/**
+ * Returns the value of strArg if it was given explicitly (or budgeting is
+ * disabled), otherwise the pool's budget.
+ */
+int64_t GetPoolThreadsArg(ThreadPool pool, const std::string& strArg, int64_t nDefault);
+
+/** Human-readable summary of the budget for the debug log. */
+std::string ThreadBudgetToString();
+
+/**
+ * RAII marker for a thread that belongs to a pool. Applies the pool's
+ * priority class when budgeting is enabled, and accounts the thread's CPU
+ * time towards the pool's utilisation metrics.
+ */
+class ThreadPoolMember
+{
+private:
+    ThreadPool pool;
+    int64_t nId;
+
+public:
+    explicit ThreadPoolMember(ThreadPool poolIn);
+    ~ThreadPoolMember();
+
+    ThreadPoolMember(const ThreadPoolMember&) = delete;
+    ThreadPoolMember& operator=(const ThreadPoolMember&) = delete;
+};
+
+/** Publishes per-pool thread count and utilisation gauges. */
+void SampleThreadPoolUtilization();
+
+#endif // BITCOIN_THREADBUDGET_H
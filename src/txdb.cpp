@@ -15,6 +15,8 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+
 #include <boost/thread.hpp>
 
 #include <rust/metrics.h>
@@ -509,11 +511,30 @@ bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos>
 }
 
 // START insightexplorer
+// A block's index entries arrive in transaction order, scattered across the
+// key space. LevelDB inserts a batch into its memtable one key at a time, which
+// is cheaper in key order. The sort is stable, so the last update to a key
+// (for example the erasure of an output spent in the block that created it)
+// still wins.
+template<typename Entry, typename KeyCompare>
+static std::vector<const Entry*> SortedByKey(const std::vector<Entry>& vect, KeyCompare compare)
+{
+    std::vector<const Entry*> sorted;
+    sorted.reserve(vect.size());
+    for (const Entry& entry : vect) {
+        sorted.push_back(&entry);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [&](const Entry* a, const Entry* b) {
+        return compare(a->first, b->first);
+    });
+    return sorted;
+}
+
 // https://github.com/bitpay/bitcoin/commit/017f548ea6d89423ef568117447e61dd5707ec42#diff-81e4f16a1b5d5b7ca25351a63d07cb80R183
 bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<CAddressUnspentDbEntry> &vect)
 {
     CDBBatch batch(*this);
-    for (std::vector<CAddressUnspentDbEntry>::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+    for (const CAddressUnspentDbEntry* it : SortedByKey(vect, CAddressUnspentKeyCompare())) {
         if (it->second.IsNull()) {
             batch.Erase(make_pair(DB_ADDRESSUNSPENTINDEX, it->first));
         } else {
@@ -545,14 +566,14 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type, std::v
 
 bool CBlockTreeDB::WriteAddressIndex(const std::vector<CAddressIndexDbEntry> &vect) {
     CDBBatch batch(*this);
-    for (std::vector<CAddressIndexDbEntry>::const_iterator it=vect.begin(); it!=vect.end(); it++)
+    for (const CAddressIndexDbEntry* it : SortedByKey(vect, CAddressIndexKeyCompare()))
         batch.Write(make_pair(DB_ADDRESSINDEX, it->first), it->second);
     return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::EraseAddressIndex(const std::vector<CAddressIndexDbEntry> &vect) {
     CDBBatch batch(*this);
-    for (std::vector<CAddressIndexDbEntry>::const_iterator it=vect.begin(); it!=vect.end(); it++)
+    for (const CAddressIndexDbEntry* it : SortedByKey(vect, CAddressIndexKeyCompare()))
         batch.Erase(make_pair(DB_ADDRESSINDEX, it->first));
     return WriteBatch(batch);
 }
@@ -592,7 +613,7 @@ bool CBlockTreeDB::ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
 
 bool CBlockTreeDB::UpdateSpentIndex(const std::vector<CSpentIndexDbEntry> &vect) {
     CDBBatch batch(*this);
-    for (std::vector<CSpentIndexDbEntry>::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+    for (const CSpentIndexDbEntry* it : SortedByKey(vect, CSpentIndexKeyCompare())) {
         if (it->second.IsNull()) {
             batch.Erase(make_pair(DB_SPENTINDEX, it->first));
         } else {
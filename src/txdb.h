@@ -113,6 +113,7 @@ public:
                     SubtreeCache &cacheSaplingSubtrees,
                     SubtreeCache &cacheOrchardSubtrees);
     bool GetStats(CCoinsStats &stats) const;
+    size_t DatabaseMemoryUsage() const { return db.DynamicMemoryUsage(); }
 };
 
 /** Access to the block database (blocks/index/) */
@@ -21,6 +21,7 @@
 
 #include <rust/metrics.h>
 
+#include <algorithm>
 #include <optional>
 
 using namespace std;
@@ -41,6 +42,17 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTransaction& _tx, const CAmount& _nFee,
     nModFeesWithDescendants = nFee;
 
     feeDelta = 0;
+
+    // The coinbases spent by the transaction were mature at the mempool
+    // height it was accepted at.
+    nMaturityHeight = spendsCoinbase ? nHeight + 1 : 0;
+    bool fFinalInputs = std::all_of(_tx.vin.begin(), _tx.vin.end(),
+        [](const CTxIn& txin) { return txin.IsFinal(); });
+    if (_tx.nLockTime != 0 && !fFinalInputs) {
+        nMaturityHeight = _tx.nLockTime < LOCKTIME_THRESHOLD
+            ? std::max(nMaturityHeight, _tx.nLockTime + 1)
+            : std::numeric_limits<unsigned int>::max();
+    }
 }
 
 CTxMemPoolEntry::CTxMemPoolEntry(const CTxMemPoolEntry& other)
@@ -457,10 +469,11 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
     for (unsigned int j = 0; j < tx.vin.size(); j++) {
         const CTxIn input = tx.vin[j];
         const CTxOut &prevout = view.GetOutputFor(input);
-        CScript::ScriptType type = prevout.scriptPubKey.GetType();
+        uint160 addressHash;
+        CScript::ScriptType type = prevout.scriptPubKey.ExtractAddressHash(addressHash);
         if (type == CScript::UNKNOWN)
             continue;
-        CMempoolAddressDeltaKey key(type, prevout.scriptPubKey.AddressHash(), txhash, j, 1);
+        CMempoolAddressDeltaKey key(type, addressHash, txhash, j, 1);
         CMempoolAddressDelta delta(entry.GetTime(), prevout.nValue * -1, input.prevout.hash, input.prevout.n);
         mapAddress.insert(make_pair(key, delta));
         inserted.push_back(key);
@@ -468,10 +481,11 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
 
     for (unsigned int j = 0; j < tx.vout.size(); j++) {
         const CTxOut &out = tx.vout[j];
-        CScript::ScriptType type = out.scriptPubKey.GetType();
+        uint160 addressHash;
+        CScript::ScriptType type = out.scriptPubKey.ExtractAddressHash(addressHash);
         if (type == CScript::UNKNOWN)
             continue;
-        CMempoolAddressDeltaKey key(type, out.scriptPubKey.AddressHash(), txhash, j, 0);
+        CMempoolAddressDeltaKey key(type, addressHash, txhash, j, 0);
         mapAddress.insert(make_pair(key, CMempoolAddressDelta(entry.GetTime(), out.nValue)));
         inserted.push_back(key);
     }
@@ -518,9 +532,9 @@ void CTxMemPool::addSpentIndex(const CTxMemPoolEntry &entry, const CCoinsViewCac
         const CTxIn input = tx.vin[j];
         const CTxOut &prevout = view.GetOutputFor(input);
         CSpentIndexKey key = CSpentIndexKey(input.prevout.hash, input.prevout.n);
-        CSpentIndexValue value = CSpentIndexValue(txhash, j, -1, prevout.nValue,
-            prevout.scriptPubKey.GetType(),
-            prevout.scriptPubKey.AddressHash());
+        uint160 addressHash;
+        CScript::ScriptType type = prevout.scriptPubKey.ExtractAddressHash(addressHash);
+        CSpentIndexValue value = CSpentIndexValue(txhash, j, -1, prevout.nValue, type, addressHash);
         mapSpent.insert(make_pair(key, value));
         inserted.push_back(key);
     }
@@ -660,7 +674,10 @@ void CTxMemPool::removeForReorg(const CCoinsViewCache *pcoins, unsigned int nMem
     // Remove transactions spending a coinbase which are now immature and no-longer-final transactions
     LOCK(cs);
     list<CTransaction> transactionsToRemove;
-    for (indexed_transaction_set::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
+    // Only transactions that were accepted at a greater height can have
+    // become invalid.
+    const auto& maturityIndex = mapTx.get<maturity_height>();
+    for (auto it = maturityIndex.upper_bound(nMemPoolHeight); it != maturityIndex.end(); it++) {
         const CTransaction& tx = it->GetTx();
         if (!CheckFinalTx(tx, flags)) {
             transactionsToRemove.push_back(tx);
@@ -785,12 +802,13 @@ std::vector<uint256> CTxMemPool::removeExpired(unsigned int nBlockHeight)
     // Remove expired txs from the mempool
     LOCK(cs);
     list<CTransaction> transactionsToRemove;
-    for (indexed_transaction_set::const_iterator it = mapTx.begin(); it != mapTx.end(); it++)
+    const auto& expiryIndex = mapTx.get<expiry_height>();
+    auto itEnd = expiryIndex.lower_bound(nBlockHeight);
+    for (auto it = expiryIndex.begin(); it != itEnd; it++)
     {
         const CTransaction& tx = it->GetTx();
-        if (IsExpiredTx(tx, nBlockHeight)) {
-            transactionsToRemove.push_back(tx);
-        }
+        assert(IsExpiredTx(tx, nBlockHeight));
+        transactionsToRemove.push_back(tx);
     }
     std::vector<uint256> ids;
     for (const CTransaction& tx : transactionsToRemove) {
@@ -1203,7 +1221,7 @@ size_t CTxMemPool::DynamicMemoryUsage() const {
 
     // Estimate the overhead of mapTx to be 9 pointers + an allocation, as no exact formula for
     // boost::multi_index_contained is implemented.
-    total += memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 9 * sizeof(void*)) * mapTx.size();
+    total += memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size();
 
     // Three metadata maps inherited from Bitcoin Core
     total += memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks);
@@ -1223,14 +1241,20 @@ size_t CTxMemPool::DynamicMemoryUsage() const {
     total += memusage::DynamicUsage(recentlyEvicted) + memusage::DynamicUsage(limitSet);
 
     // Insight-related structures
+    total += IndexMemoryUsage();
+
+    return total;
+}
+
+size_t CTxMemPool::IndexMemoryUsage() const {
+    LOCK(cs);
+
     size_t insight = 0;
     insight += memusage::DynamicUsage(mapAddress);
     insight += memusage::DynamicUsage(mapAddressInserted);
     insight += memusage::DynamicUsage(mapSpent);
     insight += memusage::DynamicUsage(mapSpentInserted);
-    total += insight;
-
-    return total;
+    return insight;
 }
 
 void CTxMemPool::UpdateMetrics() const {
@@ -1306,6 +1330,11 @@ void CTxMemPool::UpdateMetrics() const {
     MetricsGauge("zcash.mempool.usage.bytes", DynamicMemoryUsage());
 }
 
+int64_t CTxMemPool::GetTotalCost() const {
+    LOCK(cs);
+    return limitSet->getTotalCost();
+}
+
 void CTxMemPool::SetMempoolCostLimit(int64_t totalCostLimit, int64_t evictionMemorySeconds) {
     LOCK(cs);
     LogPrint("mempool", "Setting mempool cost limit: (limit=%d, time=%d)\n", totalCostLimit, evictionMemorySeconds);
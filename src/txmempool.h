@@ -7,6 +7,7 @@
 #ifndef BITCOIN_TXMEMPOOL_H
 #define BITCOIN_TXMEMPOOL_H
 
+#include <limits>
 #include <list>
 #include <memory>
 #include <set>
@@ -67,6 +68,7 @@ private:
     unsigned int sigOpCount;   //!< Legacy sig ops plus P2SH sig op count
     int64_t feeDelta;          //!< Used for determining the priority of the transaction for mining in a block
     uint32_t nBranchId;        //!< Branch ID this transaction is known to commit to, cached for efficiency
+    unsigned int nMaturityHeight; //!< Mempool height below which coinbase maturity and lock time must be rechecked
 
     // Information about descendants of this transaction that are in the
     // mempool; if we remove this transaction we must remove all of these
@@ -123,6 +125,12 @@ public:
 
     bool GetSpendsCoinbase() const { return spendsCoinbase; }
     uint32_t GetValidatedBranchId() const { return nBranchId; }
+
+    // Return the lowest mempool height (chain height + 1) at which the
+    // transaction is known to spend only mature coinbases and to be final.
+    // A reorg to a lower height has to check it again; a transaction with a
+    // time-based lock time is always checked.
+    unsigned int GetMaturityHeight() const { return nMaturityHeight; }
 };
 
 // Helpers for modifying CTxMemPool::mapTx, which is a boost multi_index.
@@ -167,6 +175,28 @@ struct mempoolentry_txid
     }
 };
 
+// extracts the height above which a TxMemPoolEntry's transaction is expired,
+// or the maximum height if it never expires
+struct mempoolentry_expiry_height
+{
+    typedef uint32_t result_type;
+    result_type operator() (const CTxMemPoolEntry &entry) const
+    {
+        uint32_t nExpiryHeight = entry.GetTx().nExpiryHeight;
+        return nExpiryHeight == 0 ? std::numeric_limits<uint32_t>::max() : nExpiryHeight;
+    }
+};
+
+// extracts a TxMemPoolEntry's maturity height
+struct mempoolentry_maturity_height
+{
+    typedef unsigned int result_type;
+    result_type operator() (const CTxMemPoolEntry &entry) const
+    {
+        return entry.GetMaturityHeight();
+    }
+};
+
 /** \class CompareTxMemPoolEntryByDescendantScore
  *
  *  Sort an entry by max(score/size of entry's tx, score/size with all descendants).
@@ -234,6 +264,8 @@ public:
 // Multi_index tag names
 struct descendant_score {};
 struct mining_score {};
+struct expiry_height {};
+struct maturity_height {};
 
 /** An inpoint - a combination of a transaction and an index n into its vin */
 class CInPoint
@@ -276,10 +308,13 @@ struct TxMempoolInfo
  *
  * CTxMemPool::mapTx, and CTxMemPoolEntry bookkeeping:
  *
- * mapTx is a boost::multi_index that sorts the mempool on 2 criteria:
+ * mapTx is a boost::multi_index that sorts the mempool on 5 criteria:
  * - transaction hash
  * - feerate [we use max(feerate of tx, feerate of tx with all descendants)]
  * - mining score (feerate modified by any fee deltas from PrioritiseTransaction)
+ * - expiry height, so that removeExpired() only visits expired transactions
+ * - maturity height, so that removeForReorg() only visits transactions that a
+ *   lower tip can invalidate
  *
  * Note: the term "descendant" refers to in-mempool transactions that depend on
  * this one, while "ancestor" refers to in-mempool transactions that a given
@@ -381,6 +416,16 @@ public:
                 boost::multi_index::tag<mining_score>,
                 boost::multi_index::identity<CTxMemPoolEntry>,
                 CompareTxMemPoolEntryByScore
+            >,
+            // sorted by expiry height
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::tag<expiry_height>,
+                mempoolentry_expiry_height
+            >,
+            // sorted by maturity height
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::tag<maturity_height>,
+                mempoolentry_maturity_height
             >
         >
     > indexed_transaction_set;
@@ -581,6 +626,10 @@ public:
     std::vector<TxMempoolInfo> infoAll() const;
 
     size_t DynamicMemoryUsage() const;
+    /** Part of DynamicMemoryUsage() held by the insightexplorer address and spent indexes. */
+    size_t IndexMemoryUsage() const;
+    /** Total cost of the transactions in the mempool, as limited by -mempooltxcostlimit. */
+    int64_t GetTotalCost() const;
 
     void UpdateMetrics() const;
 
@@ -358,6 +358,32 @@ BOOST_AUTO_TEST_CASE(univalue_object)
     BOOST_CHECK_EQUAL(kv["age"].getValStr(), "43");
     BOOST_CHECK_EQUAL(kv["name"].getValStr(), "foo bar");
 
+    UniValue arr(UniValue::VARR);
+    arr.push_back("moved");
+    obj.pushKV("list", std::move(arr));
+    BOOST_CHECK_EQUAL(obj.size(), 3);
+    BOOST_CHECK_EQUAL(obj["list"][0].getValStr(), "moved");
+
+    UniValue replacement(UniValue::VARR);
+    obj.pushKV("list", std::move(replacement));
+    BOOST_CHECK_EQUAL(obj.size(), 3);
+    BOOST_CHECK(obj["list"].empty());
+
+    // pushKVEnd does not look for an existing key.
+    BOOST_CHECK(obj.pushKVEnd("unique", UniValue(7)));
+    BOOST_CHECK_EQUAL(obj.size(), 4);
+    BOOST_CHECK_EQUAL(obj["unique"].getValStr(), "7");
+    BOOST_CHECK_EQUAL(obj.write(), "{\"age\":43,\"name\":\"foo bar\",\"list\":[],\"unique\":7}");
+
+    UniValue notObj(UniValue::VARR);
+    BOOST_CHECK(!notObj.pushKVEnd("key", UniValue(1)));
+    BOOST_CHECK(!notObj.pushKV("key", UniValue(1)));
+
+    UniValue reserved(UniValue::VOBJ);
+    reserved.reserve(2);
+    BOOST_CHECK(reserved.empty());
+    reserved.pushKVEnd("a", "b");
+    BOOST_CHECK_EQUAL(reserved.write(), "{\"a\":\"b\"}");
 }
 
 static const char *json1 =
@@ -7,14 +7,17 @@
 #include "validationinterface.h"
 
 #include "chainparams.h"
+#include "consensus/validation.h"
 #include "init.h"
 #include "main.h"
+#include "scheduler.h"
 #include "txmempool.h"
 #include "ui_interface.h"
 
 #include <boost/thread.hpp>
 
 #include <chrono>
+#include <future>
 #include <thread>
 
 #include <rust/metrics.h>
@@ -24,6 +27,10 @@ using namespace boost::placeholders;
 static CMainSignals g_signals;
 
 static constexpr const char* METRIC_WALLET_SYNCED_HEIGHT = "zcashd.wallet.synced.block.height";
+static constexpr const char* METRIC_QUEUE_SIZE = "zcashd.validationinterface.queue.size";
+
+// Set before validation threads start and cleared after they have stopped.
+static std::unique_ptr<SingleThreadedSchedulerClient> pBackgroundQueue;
 
 CMainSignals& GetMainSignals()
 {
@@ -66,6 +73,83 @@ void UnregisterAllValidationInterfaces() {
     g_signals.UpdatedBlockTip.disconnect_all_slots();
 }
 
+void RegisterBackgroundSignalScheduler(CScheduler& scheduler)
+{
+    assert(!pBackgroundQueue);
+    pBackgroundQueue.reset(new SingleThreadedSchedulerClient(&scheduler));
+}
+
+void UnregisterBackgroundSignalScheduler()
+{
+    pBackgroundQueue.reset();
+}
+
+void FlushBackgroundCallbacks()
+{
+    if (pBackgroundQueue) {
+        pBackgroundQueue->EmptyQueue();
+        MetricsGauge(METRIC_QUEUE_SIZE, 0);
+    }
+}
+
+size_t CallbacksPending()
+{
+    if (!pBackgroundQueue) {
+        return 0;
+    }
+    return pBackgroundQueue->CallbacksPending();
+}
+
+void CallFunctionInValidationInterfaceQueue(std::function<void ()> func)
+{
+    if (!pBackgroundQueue) {
+        func();
+        return;
+    }
+    pBackgroundQueue->AddToProcessQueue([func]() {
+        func();
+        MetricsGauge(METRIC_QUEUE_SIZE, (double)CallbacksPending());
+    });
+    MetricsGauge(METRIC_QUEUE_SIZE, (double)CallbacksPending());
+}
+
+void SyncWithValidationInterfaceQueue()
+{
+    AssertLockNotHeld(cs_main);
+    auto promise = std::make_shared<std::promise<void>>();
+    std::future<void> done = promise->get_future();
+    CallFunctionInValidationInterfaceQueue([promise]() { promise->set_value(); });
+    // The scheduler thread is stopped before the RPC server at shutdown.
+    while (done.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout) {
+        if (ShutdownRequested()) {
+            return;
+        }
+    }
+}
+
+void QueueUpdatedBlockTip(const CBlockIndex *pindex)
+{
+    CallFunctionInValidationInterfaceQueue([pindex]() {
+        g_signals.UpdatedBlockTip(pindex);
+    });
+}
+
+void QueueBlockChecked(const CBlock &block, const CValidationState &state)
+{
+    if (!pBackgroundQueue) {
+        g_signals.BlockChecked(block, state);
+        return;
+    }
+    if (g_signals.BlockChecked.empty()) {
+        return;
+    }
+    // The caller's block does not outlive validation.
+    auto pblock = std::make_shared<const CBlock>(block);
+    CallFunctionInValidationInterfaceQueue([pblock, state]() {
+        g_signals.BlockChecked(*pblock, state);
+    });
+}
+
 void AddTxToBatches(
     std::vector<BatchScanner*> &batchScanners,
     const CTransaction &tx,
@@ -7,6 +7,8 @@
 #ifndef BITCOIN_VALIDATIONINTERFACE_H
 #define BITCOIN_VALIDATIONINTERFACE_H
 
+#include <functional>
+#include <memory>
 #include <optional>
 
 #include <boost/signals2/signal.hpp>
@@ -25,6 +27,7 @@ class CBlock;
 class CBlockIndex;
 struct CBlockLocator;
 class CReserveScript;
+class CScheduler;
 class CTransaction;
 class CValidationInterface;
 class CValidationState;
@@ -82,6 +85,35 @@ void UnregisterValidationInterface(CValidationInterface* pwalletIn);
 /** Unregister all wallets from core */
 void UnregisterAllValidationInterfaces();
 
+/**
+ * Background queue for notifications that validation code does not wait for.
+ *
+ * Once a scheduler is registered, UpdatedBlockTip and BlockChecked are no
+ * longer called from validation code (often with cs_main held), but queued and
+ * delivered in order on the scheduler thread, so that slow listeners such as
+ * the ZMQ publishers do not delay block connection. Without a scheduler they
+ * are delivered synchronously.
+ */
+void RegisterBackgroundSignalScheduler(CScheduler& scheduler);
+void UnregisterBackgroundSignalScheduler();
+/** Delivers the queued notifications on the calling thread, at shutdown. */
+void FlushBackgroundCallbacks();
+/** Number of notifications waiting in the queue. */
+size_t CallbacksPending();
+
+/** Runs func on the queue after every notification queued before it. */
+void CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
+/**
+ * Waits until every notification queued so far has been delivered. Must not be
+ * called with cs_main held.
+ */
+void SyncWithValidationInterfaceQueue();
+
+/** Queues UpdatedBlockTip. */
+void QueueUpdatedBlockTip(const CBlockIndex *pindex);
+/** Queues BlockChecked with a copy of the block and of its validation state. */
+void QueueBlockChecked(const CBlock &block, const CValidationState &state);
+
 class CValidationInterface {
 protected:
     virtual void UpdatedBlockTip(const CBlockIndex *pindex) {}
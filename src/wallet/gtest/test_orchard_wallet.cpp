@@ -155,3 +155,64 @@ TEST(TransactionBuilder, OrchardToOrchard) {
     // Revert to default
     RegtestDeactivateNU5();
 }
+
+TEST(OrchardWalletTests, SpentNotesAreNotSelected) {
+    LoadProofParameters();
+
+    auto consensusParams = RegtestActivateNU5();
+    OrchardWallet wallet;
+
+    auto sk = RandomOrchardSpendingKey();
+    auto ivk = sk.ToFullViewingKey().ToIncomingViewingKey();
+    wallet.AddSpendingKey(sk);
+
+    // Receive a note and mine it at height 2.
+    libzcash::diversifier_index_t j(0);
+    auto txRecv = FakeOrchardTx(sk, j);
+    wallet.AddNotesIfInvolvingMe(txRecv);
+
+    CBlock recvBlock;
+    recvBlock.vtx.resize(2);
+    recvBlock.vtx[1] = txRecv;
+    ASSERT_TRUE(wallet.AppendNoteCommitments(2, recvBlock));
+    ASSERT_TRUE(wallet.CheckpointNoteCommitmentTree(2));
+
+    std::vector<OrchardNoteMetadata> notes;
+    wallet.GetFilteredNotes(notes, ivk, true, true);
+    ASSERT_EQ(notes.size(), 1);
+
+    // Spend the note to someone else and mine the spend at height 3.
+    auto spendInfo = wallet.GetSpendInfo(notes, 1, wallet.GetLatestAnchor());
+    auto recipient = RandomOrchardSpendingKey()
+        .ToFullViewingKey()
+        .ToIncomingViewingKey()
+        .Address(j);
+    auto builder = TransactionBuilder(Params(), 3, wallet.GetLatestAnchor(), SaplingMerkleTree::empty_root());
+    EXPECT_TRUE(builder.AddOrchardSpend(sk, std::move(spendInfo[0].second)));
+    builder.AddOrchardOutput(std::nullopt, recipient, 25000, std::nullopt);
+    auto txSpend = builder.Build().GetTxOrThrow();
+
+    CBlock spendBlock;
+    spendBlock.vtx.resize(2);
+    spendBlock.vtx[1] = txSpend;
+    ASSERT_TRUE(wallet.AppendNoteCommitments(3, spendBlock));
+    ASSERT_TRUE(wallet.CheckpointNoteCommitmentTree(3));
+
+    // The spent note is no longer selected, but is still known to the wallet.
+    notes.clear();
+    wallet.GetFilteredNotes(notes, ivk, true, true);
+    EXPECT_EQ(notes.size(), 0);
+    notes.clear();
+    wallet.GetFilteredNotes(notes, ivk, false, true);
+    EXPECT_EQ(notes.size(), 1);
+
+    // Rewinding past the spend makes the note selectable again.
+    uint32_t uResultHeight{0};
+    ASSERT_TRUE(wallet.Rewind(2, uResultHeight));
+    EXPECT_EQ(uResultHeight, 2);
+    notes.clear();
+    wallet.GetFilteredNotes(notes, ivk, true, true);
+    EXPECT_EQ(notes.size(), 1);
+
+    RegtestDeactivateNU5();
+}
@@ -518,6 +518,10 @@ public:
     bool UnspentNotesAreSpendable() const {
         return orchard_wallet_unspent_notes_are_spendable(inner.get());
     }
+
+    size_t NoteCommitmentTreeMemoryUsage() const {
+        return orchard_wallet_note_commitment_tree_usage(inner.get());
+    }
 };
 
 class OrchardWalletNoteCommitmentTreeWriter
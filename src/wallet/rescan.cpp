@@ -0,0 +1,181 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#include "wallet/rescan.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "checkpoints.h"
+#include "main.h"
+#include "sync.h"
+#include "util/system.h"
+#include "util/time.h"
+#include "wallet/wallet.h"
+#include "wallet/walletdb.h"
+
+#include <algorithm>
+#include <optional>
+
+#include <boost/thread.hpp>
+
+namespace {
+
+boost::mutex mutexRescan;
+boost::condition_variable condRescan;
+//! Next block to scan, if a rescan is pending.
+std::optional<int> nRescanHeight;
+//! Whether the pending rescan updates transactions already in the wallet.
+bool fRescanUpdate = false;
+WalletRescanProgress rescanProgress;
+int64_t nLastRescanSave = 0;
+
+double GuessProgress(CBlockIndex* pindex)
+{
+    return Checkpoints::GuessVerificationProgress(Params().Checkpoints(), pindex, false);
+}
+
+}
+
+bool AsyncRescanEnabled()
+{
+    return GetBoolArg("-asyncrescan", !Params().MineBlocksOnDemand());
+}
+
+void QueueWalletRescan(CWallet* pwallet, int nHeight, bool fUpdate)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(pwallet->cs_wallet);
+
+    boost::unique_lock<boost::mutex> lock(mutexRescan);
+    if (nRescanHeight && *nRescanHeight <= nHeight) {
+        LogPrintf("Rescan from height %d merged into the rescan at height %d\n", nHeight, *nRescanHeight);
+        fRescanUpdate |= fUpdate;
+        return;
+    }
+    fRescanUpdate = (nRescanHeight && fRescanUpdate) || fUpdate;
+    nRescanHeight = nHeight;
+    rescanProgress.fActive = true;
+    rescanProgress.nStartHeight = nHeight;
+    rescanProgress.nHeight = nHeight;
+    rescanProgress.nTipHeight = chainActive.Height();
+    rescanProgress.dProgress = 0;
+    rescanProgress.nStartTime = GetTime();
+    rescanProgress.strError.clear();
+
+    CWalletDB walletdb(pwallet->strWalletFile);
+    walletdb.WriteRescanHeight(nHeight);
+    nLastRescanSave = GetTime();
+
+    LogPrintf("Queued a background rescan from height %d\n", nHeight);
+    condRescan.notify_one();
+}
+
+WalletRescanProgress GetWalletRescanProgress()
+{
+    boost::unique_lock<boost::mutex> lock(mutexRescan);
+    return rescanProgress;
+}
+
+void ResumeWalletRescan(CWallet* pwallet)
+{
+    int nHeight;
+    if (!CWalletDB(pwallet->strWalletFile).ReadRescanHeight(nHeight)) {
+        return;
+    }
+    LOCK2(cs_main, pwallet->cs_wallet);
+    if (nHeight > chainActive.Height()) {
+        // Everything above the tip is scanned when it is connected.
+        CWalletDB(pwallet->strWalletFile).EraseRescanHeight();
+        return;
+    }
+    LogPrintf("Resuming the background rescan at height %d\n", nHeight);
+    QueueWalletRescan(pwallet, nHeight, true);
+}
+
+void ThreadWalletRescan(CWallet* pwallet)
+{
+    RenameThread("zc-wallet-rescan");
+
+    try {
+        while (true) {
+            {
+                boost::unique_lock<boost::mutex> lock(mutexRescan);
+                while (!nRescanHeight) {
+                    condRescan.wait(lock);
+                }
+            }
+            boost::this_thread::interruption_point();
+
+            // Lets the RPC tests watch a rescan in progress.
+            int64_t nDelay = GetArg("-rescanchunkdelay", 0);
+            if (nDelay > 0) {
+                MilliSleep(nDelay);
+            }
+
+            // Imports queue rescans while holding cs_wallet, so the position
+            // cannot move while a chunk is being scanned.
+            LOCK2(cs_main, pwallet->cs_wallet);
+            int nHeight;
+            bool fUpdate;
+            {
+                boost::unique_lock<boost::mutex> lock(mutexRescan);
+                nHeight = *nRescanHeight;
+                fUpdate = fRescanUpdate;
+            }
+
+            CBlockIndex* pindexNext = nullptr;
+            std::string strError;
+            CBlockIndex* pindex = chainActive[nHeight];
+            if (pindex != nullptr) {
+                try {
+                    pindexNext = pwallet->ScanWalletTransactionsChunk(pindex, WALLET_RESCAN_CHUNK_SIZE, fUpdate);
+                } catch (const std::exception& e) {
+                    strError = e.what();
+                }
+            }
+
+            boost::unique_lock<boost::mutex> lock(mutexRescan);
+            CWalletDB walletdb(pwallet->strWalletFile, "r+", false);
+            if (!strError.empty()) {
+                LogPrintf("ERROR: %s: abandoned the rescan at height %d: %s\n", __func__, nHeight, strError);
+                nRescanHeight = std::nullopt;
+                rescanProgress.fActive = false;
+                rescanProgress.strError = strError;
+                walletdb.EraseRescanHeight();
+            } else if (pindexNext == nullptr) {
+                LogPrintf("Background rescan from height %d finished in %ds\n",
+                    rescanProgress.nStartHeight, GetTime() - rescanProgress.nStartTime);
+                nRescanHeight = std::nullopt;
+                rescanProgress.fActive = false;
+                rescanProgress.nHeight = chainActive.Height() + 1;
+                rescanProgress.nTipHeight = chainActive.Height();
+                rescanProgress.dProgress = 1;
+                walletdb.EraseRescanHeight();
+                pwallet->MarkDirty();
+            } else {
+                nRescanHeight = pindexNext->nHeight;
+                rescanProgress.nHeight = pindexNext->nHeight;
+                rescanProgress.nTipHeight = chainActive.Height();
+                CBlockIndex* pindexStart = chainActive[rescanProgress.nStartHeight];
+                double dStart = pindexStart ? GuessProgress(pindexStart) : 0;
+                double dTip = GuessProgress(chainActive.Tip());
+                if (dTip > dStart) {
+                    rescanProgress.dProgress = std::min(1.0, (GuessProgress(pindexNext) - dStart) / (dTip - dStart));
+                }
+                if (GetTime() >= nLastRescanSave + WALLET_RESCAN_SAVE_INTERVAL) {
+                    walletdb.WriteRescanHeight(pindexNext->nHeight);
+                    nLastRescanSave = GetTime();
+                }
+            }
+        }
+    } catch (const boost::thread_interrupted&) {
+        // Save the position on shutdown, so that the next start does not
+        // repeat the chunks scanned since the last save.
+        boost::unique_lock<boost::mutex> lock(mutexRescan);
+        if (nRescanHeight) {
+            CWalletDB(pwallet->strWalletFile).WriteRescanHeight(*nRescanHeight);
+        }
+        throw;
+    }
+}
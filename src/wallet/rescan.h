@@ -0,0 +1,71 @@
+// Copyright (c) 2025 The Juno Cash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php .
+
+#ifndef BITCOIN_WALLET_RESCAN_H
+#define BITCOIN_WALLET_RESCAN_H
+
+#include <cstdint>
+#include <string>
+
+class CWallet;
+
+/**
+ * Background rescans for imported keys.
+ *
+ * An import that asks for a rescan would otherwise scan the chain inside the
+ * RPC call, holding cs_main and cs_wallet until it reaches the tip. Instead,
+ * the rescan is queued and a background thread scans the chain in chunks of
+ * WALLET_RESCAN_CHUNK_SIZE blocks, releasing both locks between chunks so
+ * that blocks are connected and other RPCs are served meanwhile.
+ *
+ * Rescans are tracked by height: blocks connected while a rescan runs are
+ * scanned as usual with every key the wallet holds, so only blocks at or
+ * above the rescan position are left to it. An import that asks for a lower
+ * height moves the running pass back rather than starting a second one. The
+ * position is written to the wallet, so a rescan interrupted by a shutdown
+ * carries on after the next start.
+ */
+
+/** Number of blocks scanned per acquisition of cs_main. */
+static const int WALLET_RESCAN_CHUNK_SIZE = 100;
+/** Minimum number of seconds between writes of the rescan position. */
+static const int64_t WALLET_RESCAN_SAVE_INTERVAL = 10;
+
+struct WalletRescanProgress {
+    bool fActive = false;
+    //! Height the current pass started from.
+    int nStartHeight = 0;
+    //! Next block to scan.
+    int nHeight = 0;
+    int nTipHeight = 0;
+    //! Fraction of the pass done, weighted by transaction count.
+    double dProgress = 0;
+    int64_t nStartTime = 0;
+    //! Why the last pass was abandoned, if it failed.
+    std::string strError;
+};
+
+/** Whether import RPCs leave their rescans to the background (-asyncrescan). */
+bool AsyncRescanEnabled();
+
+/**
+ * Queues a rescan of the active chain from nHeight, merging it with a pass
+ * that is already running. If fUpdate is true, transactions that are already
+ * in the wallet are updated; a merged pass does so if any of its requests
+ * asked for it. Requires cs_main and cs_wallet.
+ */
+void QueueWalletRescan(CWallet* pwallet, int nHeight, bool fUpdate);
+
+WalletRescanProgress GetWalletRescanProgress();
+
+/**
+ * Queues the rescan left unfinished by the previous run, if there is one. As
+ * only its position is saved, it updates existing transactions.
+ */
+void ResumeWalletRescan(CWallet* pwallet);
+
+/** Background thread that runs queued rescans. */
+void ThreadWalletRescan(CWallet* pwallet);
+
+#endif // BITCOIN_WALLET_RESCAN_H
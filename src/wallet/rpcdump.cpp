@@ -18,6 +18,7 @@
 #include "util/match.h"
 #include "util/time.h"
 #include "wallet.h"
+#include "wallet/rescan.h"
 
 #include <fstream>
 #include <optional>
@@ -36,6 +37,18 @@ bool EnsureWalletIsAvailable(bool avoidException);
 
 UniValue importwallet_impl(const UniValue& params, bool fImportZKeys);
 
+// Rescans the chain from pindexStart for newly imported keys, in the
+// background if -asyncrescan is set.
+static void RescanAfterImport(CBlockIndex* pindexStart, bool fUpdate)
+{
+    AssertLockHeld(cs_main);
+    if (AsyncRescanEnabled()) {
+        QueueWalletRescan(pwalletMain, pindexStart->nHeight, fUpdate);
+    } else {
+        pwalletMain->ScanForWalletTransactions(pindexStart, fUpdate, false);
+    }
+}
+
 
 std::string static EncodeDumpTime(int64_t nTime) {
     return DateTimeStrFormat("%Y-%m-%dT%H:%M:%SZ", nTime);
@@ -93,7 +106,8 @@ UniValue importprivkey(const UniValue& params, bool fHelp)
             "1. \"junocashprivkey\"   (string, required) The private key (see dumpprivkey)\n"
             "2. \"label\"            (string, optional, default=\"\") An optional label\n"
             "3. rescan               (boolean, optional, default=true) Rescan the wallet for transactions\n"
-            "\nNote: This call can take a long time to complete if rescan is true.\n"
+            "\nNote: The rescan runs in the background after the call returns (see getrescaninfo), unless\n"
+            "-asyncrescan is disabled, in which case this call can take a long time to complete.\n"
             "\nExamples:\n"
             "\nDump a private key\n"
             + HelpExampleCli("dumpprivkey", "\"myaddress\"") +
@@ -149,7 +163,7 @@ UniValue importprivkey(const UniValue& params, bool fHelp)
         pwalletMain->nTimeFirstKey = 1; // 0 would be considered 'no value'
 
         if (fRescan) {
-            pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true, false);
+            RescanAfterImport(chainActive.Genesis(), true);
         }
     }
 
@@ -204,7 +218,8 @@ UniValue importaddress(const UniValue& params, bool fHelp)
             "2. \"label\"            (string, optional, default=\"\") An optional label\n"
             "3. rescan               (boolean, optional, default=true) Rescan the wallet for transactions\n"
             "4. p2sh                 (boolean, optional, default=false) Add the P2SH version of the script as well\n"
-            "\nNote: This call can take a long time to complete if rescan is true.\n"
+            "\nNote: The rescan runs in the background after the call returns (see getrescaninfo), unless\n"
+            "-asyncrescan is disabled, in which case this call can take a long time to complete.\n"
             "If you have the full public key, you should call importpubkey instead of this.\n"
             "\nNote: If you import a non-standard raw script in hex form, outputs sending to it will be treated\n"
             "as change, and not show up in many RPCs.\n"
@@ -253,7 +268,7 @@ UniValue importaddress(const UniValue& params, bool fHelp)
 
     if (fRescan)
     {
-        pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true, false);
+        RescanAfterImport(chainActive.Genesis(), true);
         pwalletMain->ReacceptWalletTransactions();
     }
 
@@ -273,7 +288,8 @@ UniValue importpubkey(const UniValue& params, bool fHelp)
             "1. \"pubkey\"           (string, required) The hex-encoded public key\n"
             "2. \"label\"            (string, optional, default=\"\") An optional label\n"
             "3. rescan               (boolean, optional, default=true) Rescan the wallet for transactions\n"
-            "\nNote: This call can take a long time to complete if rescan is true.\n"
+            "\nNote: The rescan runs in the background after the call returns (see getrescaninfo), unless\n"
+            "-asyncrescan is disabled, in which case this call can take a long time to complete.\n"
             "\nExamples:\n"
             "\nImport a public key with rescan\n"
             + HelpExampleCli("importpubkey", "\"mypubkey\"") +
@@ -309,7 +325,7 @@ UniValue importpubkey(const UniValue& params, bool fHelp)
 
     if (fRescan)
     {
-        pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true, false);
+        RescanAfterImport(chainActive.Genesis(), true);
         pwalletMain->ReacceptWalletTransactions();
     }
 
@@ -470,7 +486,7 @@ UniValue importwallet_impl(const UniValue& params, bool fImportZKeys)
         pwalletMain->nTimeFirstKey = nTimeBegin;
 
     LogPrintf("Rescanning last %i blocks\n", chainActive.Height() - pindex->nHeight + 1);
-    pwalletMain->ScanForWalletTransactions(pindex, false, false);
+    RescanAfterImport(pindex, false);
     pwalletMain->MarkDirty();
 
     if (!fGood)
@@ -700,7 +716,8 @@ UniValue z_importkey(const UniValue& params, bool fHelp)
             "1. \"zkey\"             (string, required) The zkey (see z_exportkey)\n"
             "2. rescan             (string, optional, default=\"whenkeyisnew\") Rescan the wallet for transactions - can be \"yes\", \"no\" or \"whenkeyisnew\"\n"
             "3. startHeight        (numeric, optional, default=0) Block height to start rescan from\n"
-            "\nNote: This call can take a long time to complete if rescan is true.\n"
+            "\nNote: The rescan runs in the background after the call returns (see getrescaninfo), unless\n"
+            "-asyncrescan is disabled, in which case this call can take a long time to complete.\n"
             "\nResult:\n"
             "{\n"
             "  \"address_type\" : \"xxxx\",                 (string) \"sprout\" or \"sapling\"\n"
@@ -791,7 +808,7 @@ UniValue z_importkey(const UniValue& params, bool fHelp)
 
     // We want to scan for transactions and notes
     if (fRescan) {
-        pwalletMain->ScanForWalletTransactions(chainActive[nRescanHeight], true, false);
+        RescanAfterImport(chainActive[nRescanHeight], true);
     }
 
     return result;
@@ -810,7 +827,9 @@ UniValue z_importviewingkey(const UniValue& params, bool fHelp)
             "1. \"vkey\"             (string, required) The viewing key (see z_exportviewingkey)\n"
             "2. rescan             (string, optional, default=\"whenkeyisnew\") Rescan the wallet for transactions - can be \"yes\", \"no\" or \"whenkeyisnew\"\n"
             "3. startHeight        (numeric, optional, default=0) Block height to start rescan from\n"
-            "\nNote: This call can take a long time to complete if rescan is true. Import of Unified viewing keys is not yet supported.\n"
+            "\nNote: The rescan runs in the background after the call returns (see getrescaninfo), unless\n"
+            "-asyncrescan is disabled, in which case this call can take a long time to complete.\n"
+            "Import of Unified viewing keys is not yet supported.\n"
             "\nResult:\n"
             "{\n"
             "  \"address_type\" : \"xxxx\",                 (string) \"sprout\" or \"sapling\"\n"
@@ -892,12 +911,57 @@ UniValue z_importviewingkey(const UniValue& params, bool fHelp)
 
     // We want to scan for transactions and notes
     if (fRescan) {
-        pwalletMain->ScanForWalletTransactions(chainActive[nRescanHeight], true, false);
+        RescanAfterImport(chainActive[nRescanHeight], true);
     }
 
     return result;
 }
 
+UniValue getrescaninfo(const UniValue& params, bool fHelp)
+{
+    if (!EnsureWalletIsAvailable(fHelp))
+        return NullUniValue;
+
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getrescaninfo\n"
+            "\nReturns the progress of the background rescan started by key imports.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"rescanning\" : true|false,   (boolean) Whether a rescan is running\n"
+            "  \"startheight\" : n,           (numeric) The height the current pass started from\n"
+            "  \"height\" : n,                (numeric) The next block to be scanned\n"
+            "  \"tipheight\" : n,             (numeric) The height of the chain tip\n"
+            "  \"progress\" : x.xxx,          (numeric) Fraction of the pass done, weighted by transaction count\n"
+            "  \"duration\" : n,              (numeric) Seconds since the pass started\n"
+            "  \"eta\" : n,                   (numeric, optional) Estimated seconds until the pass finishes\n"
+            "  \"error\" : \"xxxx\",            (string, optional) Why the last pass was abandoned\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getrescaninfo", "")
+            + HelpExampleRpc("getrescaninfo", "")
+        );
+
+    WalletRescanProgress progress = GetWalletRescanProgress();
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("rescanning", progress.fActive);
+    if (progress.fActive) {
+        int64_t nDuration = GetTime() - progress.nStartTime;
+        result.pushKV("startheight", progress.nStartHeight);
+        result.pushKV("height", progress.nHeight);
+        result.pushKV("tipheight", progress.nTipHeight);
+        result.pushKV("progress", progress.dProgress);
+        result.pushKV("duration", nDuration);
+        if (progress.dProgress > 0) {
+            result.pushKV("eta", (int64_t)(nDuration * (1 - progress.dProgress) / progress.dProgress));
+        }
+    }
+    if (!progress.strError.empty()) {
+        result.pushKV("error", progress.strError);
+    }
+    return result;
+}
+
 UniValue z_exportkey(const UniValue& params, bool fHelp)
 {
     if (!EnsureWalletIsAvailable(fHelp))
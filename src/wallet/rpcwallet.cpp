@@ -1622,7 +1622,7 @@ void ListTransactions(const CWalletTx& wtx, int nMinDepth, bool fLong, UniValue&
             if (fLong)
                 WalletTxToJSON(wtx, entry, asOfHeight);
             entry.pushKV("size", static_cast<uint64_t>(GetSerializeSize(static_cast<CTransaction>(wtx), SER_NETWORK, PROTOCOL_VERSION)));
-            ret.push_back(entry);
+            ret.push_back(std::move(entry));
         }
     }
 
@@ -1659,7 +1659,7 @@ void ListTransactions(const CWalletTx& wtx, int nMinDepth, bool fLong, UniValue&
             if (fLong)
                 WalletTxToJSON(wtx, entry, asOfHeight);
             entry.pushKV("size", static_cast<uint64_t>(GetSerializeSize(static_cast<CTransaction>(wtx), SER_NETWORK, PROTOCOL_VERSION)));
-            ret.push_back(entry);
+            ret.push_back(std::move(entry));
         }
     }
 }
@@ -2738,7 +2738,7 @@ UniValue listunspent(const UniValue& params, bool fHelp)
         entry.pushKV("amountZat", out.tx->vout[out.i].nValue);
         entry.pushKV("confirmations", out.nDepth);
         entry.pushKV("spendable", out.fSpendable);
-        results.push_back(entry);
+        results.push_back(std::move(entry));
     }
 
     return results;
@@ -2884,7 +2884,7 @@ UniValue z_listunspent(const UniValue& params, bool fHelp)
         if (hasSproutSpendingKey) {
             obj.pushKV("change", pwalletMain->IsNoteSproutChange(sproutNullifiers, entry.address, entry.jsop));
         }
-        results.push_back(obj);
+        results.push_back(std::move(obj));
     }
 
     for (auto & entry : saplingEntries) {
@@ -2913,7 +2913,7 @@ UniValue z_listunspent(const UniValue& params, bool fHelp)
                     "change",
                     pwalletMain->IsNoteSaplingChange(saplingNullifiers, entry.address, entry.op));
         }
-        results.push_back(obj);
+        results.push_back(std::move(obj));
     }
 
     for (auto & entry : orchardEntries) {
@@ -2944,7 +2944,7 @@ UniValue z_listunspent(const UniValue& params, bool fHelp)
         if (haveSpendingKey) {
             obj.pushKV("change", isInternal);
         }
-        results.push_back(obj);
+        results.push_back(std::move(obj));
     }
 
     return results;
@@ -5975,6 +5975,7 @@ extern UniValue z_exportviewingkey(const UniValue& params, bool fHelp);
 extern UniValue z_importviewingkey(const UniValue& params, bool fHelp);
 extern UniValue z_exportwallet(const UniValue& params, bool fHelp);
 extern UniValue z_importwallet(const UniValue& params, bool fHelp);
+extern UniValue getrescaninfo(const UniValue& params, bool fHelp);
 
 extern UniValue z_getpaymentdisclosure(const UniValue& params, bool fHelp); // in rpcdisclosure.cpp
 extern UniValue z_validatepaymentdisclosure(const UniValue &params, bool fHelp);
@@ -5994,6 +5995,7 @@ static const CRPCCommand commands[] =
     { "wallet",             "getnewaddress",            &getnewaddress,            true  },
     { "wallet",             "getrawchangeaddress",      &getrawchangeaddress,      true  },
     { "wallet",             "getreceivedbyaddress",     &getreceivedbyaddress,     false },
+    { "wallet",             "getrescaninfo",            &getrescaninfo,            true  },
     { "wallet",             "gettransaction",           &gettransaction,           false },
     { "wallet",             "getunconfirmedbalance",    &getunconfirmedbalance,    false },
     { "wallet",             "getwalletinfo",            &getwalletinfo,            false },
@@ -13,6 +13,7 @@
 #include "consensus/upgrades.h"
 #include "consensus/validation.h"
 #include "consensus/consensus.h"
+#include "core_memusage.h"
 #include "fs.h"
 #include "init.h"
 #include "key_io.h"
@@ -36,6 +37,7 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
 #include <numeric>
 #include <variant>
 
@@ -1391,7 +1393,8 @@ bool CWallet::ChangeWalletPassphrase(const SecureString& strOldWalletPassphrase,
 void CWallet::ChainTipAdded(const CBlockIndex *pindex,
                             const CBlock *pblock,
                             MerkleFrontiers frontiers,
-                            bool performOrchardWalletUpdates)
+                            bool performOrchardWalletUpdates,
+                            bool fUpdateBestBlock)
 {
     const auto chainParams = Params();
     IncrementNoteWitnesses(
@@ -1400,6 +1403,10 @@ void CWallet::ChainTipAdded(const CBlockIndex *pindex,
             frontiers, performOrchardWalletUpdates);
     UpdateSaplingNullifierNoteMapForBlock(pblock);
 
+    if (!fUpdateBestBlock) {
+        return;
+    }
+
     // SetBestChain() can be expensive for large wallets, so do only
     // this sometimes; the wallet state will be brought up to date
     // during rescanning on startup.
@@ -3669,9 +3676,30 @@ void WalletBatchScanner::AddTransaction(
 }
 
 void WalletBatchScanner::Flush() {
+    // Sample before flushing, while the batch still holds its outputs.
+    UpdateMemoryUsage();
     inner->flush();
 }
 
+namespace {
+std::atomic<size_t> nBatchScannersMemoryUsage{0};
+}
+
+WalletBatchScanner::~WalletBatchScanner() {
+    nBatchScannersMemoryUsage -= nMemoryUsage;
+}
+
+void WalletBatchScanner::UpdateMemoryUsage() {
+    size_t nUsage = inner->memory_usage();
+    nBatchScannersMemoryUsage += nUsage;
+    nBatchScannersMemoryUsage -= nMemoryUsage;
+    nMemoryUsage = nUsage;
+}
+
+size_t WalletBatchScanner::TotalMemoryUsage() {
+    return nBatchScannersMemoryUsage;
+}
+
 void WalletBatchScanner::SyncTransaction(
     const CTransaction &tx,
     const CBlock *pblock,
@@ -3686,6 +3714,22 @@ void WalletBatchScanner::SyncTransaction(
     pwallet->MarkAffectedTransactionsDirty(tx);
 }
 
+size_t CWallet::TransactionsMemoryUsage() const
+{
+    LOCK(cs_wallet);
+    size_t nUsage = memusage::DynamicUsage(mapWallet);
+    for (const auto& entry : mapWallet) {
+        nUsage += RecursiveDynamicUsage(entry.second);
+    }
+    return nUsage;
+}
+
+size_t CWallet::OrchardTreeMemoryUsage() const
+{
+    LOCK(cs_wallet);
+    return orchardWallet.NoteCommitmentTreeMemoryUsage();
+}
+
 BatchScanner* CWallet::GetBatchScanner()
 {
     LOCK(cs_wallet);
@@ -4635,6 +4679,92 @@ void CWallet::WitnessNoteCommitment(std::vector<uint256> commitments,
     }
 }
 
+int CWallet::ScanBlockForWalletTransactions(
+        WalletBatchScanner& batchScanner,
+        const CBlockIndex* pindex,
+        bool fUpdate,
+        bool performOrchardWalletUpdates,
+        std::vector<uint256>& myTxHashes,
+        bool fUpdateBestBlock)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+    const auto& consensus = Params().GetConsensus();
+    int nFound = 0;
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, consensus)) {
+        throw std::runtime_error(
+            strprintf("Can't read block %d from disk (%s)", pindex->nHeight, pindex->GetBlockHash().GetHex()));
+    }
+    for (CTransaction& tx : block.vtx) {
+        CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION);
+        ssTx << tx;
+        std::vector<unsigned char> txBytes(ssTx.begin(), ssTx.end());
+        batchScanner.AddTransaction(tx, txBytes, pindex->GetBlockHash(), pindex->nHeight);
+    }
+    batchScanner.Flush();
+    for (CTransaction& tx : block.vtx)
+    {
+        if (batchScanner.AddToWalletIfInvolvingMe(consensus, tx, &block, pindex->nHeight, fUpdate)) {
+            myTxHashes.push_back(tx.GetHash());
+            nFound++;
+        }
+    }
+
+    MerkleFrontiers frontiers;
+    // Juno Cash: Skip all anchor assertions during wallet rescan
+    // These checks are not needed during rescan - ConnectBlock already validates anchors
+    // Skipping prevents assertion failures when anchors may not be in database yet
+    // assert(pcoinsTip->GetSproutAnchorAt(pindex->hashSproutAnchor, frontiers.sprout));
+    // if (pindex->pprev) {
+    //     if (consensus.NetworkUpgradeActive(pindex->pprev->nHeight,  Consensus::UPGRADE_SAPLING)) {
+    //         assert(pcoinsTip->GetSaplingAnchorAt(pindex->pprev->hashFinalSaplingRoot, frontiers.sapling));
+    //     }
+    //     if (consensus.NetworkUpgradeActive(pindex->pprev->nHeight,  Consensus::UPGRADE_NU5)) {
+    //         assert(pcoinsTip->GetOrchardAnchorAt(pindex->pprev->hashFinalOrchardRoot, frontiers.orchard));
+    //     }
+    // }
+    // Increment note witness caches
+    ChainTipAdded(pindex, &block, frontiers, performOrchardWalletUpdates, fUpdateBestBlock);
+    return nFound;
+}
+
+void CWallet::WriteRescannedNoteData(const std::vector<uint256>& myTxHashes)
+{
+    // After rescanning, persist Sapling & Orchard note data that might have changed,
+    // e.g. nullifiers. Do not flush the wallet here for performance reasons.
+    CWalletDB walletdb(strWalletFile, "r+", false);
+    for (auto hash : myTxHashes) {
+        CWalletTx wtx = mapWallet[hash];
+        if (!wtx.mapSaplingNoteData.empty() || !wtx.orchardTxMeta.empty()) {
+            if (!walletdb.WriteTx(wtx)) {
+                LogPrintf(
+                        "Rescanning... WriteToDisk failed to update Sapling/Orchard note data for tx: %s\n",
+                        hash.ToString());
+            }
+        }
+    }
+}
+
+CBlockIndex* CWallet::ScanWalletTransactionsChunk(CBlockIndex* pindexStart, int nMaxBlocks, bool fUpdate)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    // The batch scanner is created for each chunk so that it picks up keys
+    // imported since the previous one.
+    auto batchScanner = WalletBatchScanner(this);
+    std::vector<uint256> myTxHashes;
+    CBlockIndex* pindex = pindexStart;
+    for (int i = 0; pindex && i < nMaxBlocks; i++) {
+        ScanBlockForWalletTransactions(batchScanner, pindex, fUpdate, false, myTxHashes, false);
+        pindex = chainActive.Next(pindex);
+    }
+    WriteRescannedNoteData(myTxHashes);
+    return pindex;
+}
+
 /**
  * Scan the block chain (starting in pindexStart) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -4649,7 +4779,6 @@ std::optional<int> CWallet::ScanForWalletTransactions(
     int myTransactionsFound = 0;
     int64_t nNow = GetTime();
     const CChainParams& chainParams = Params();
-    const auto& consensus = chainParams.GetConsensus();
 
     CBlockIndex* pindex = pindexStart;
 
@@ -4723,41 +4852,8 @@ std::optional<int> CWallet::ScanForWalletTransactions(
             if (pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0)
                 ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
 
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, consensus)) {
-                throw std::runtime_error(
-                    strprintf("Can't read block %d from disk (%s)", pindex->nHeight, pindex->GetBlockHash().GetHex()));
-            }
-            for (CTransaction& tx : block.vtx) {
-                CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION);
-                ssTx << tx;
-                std::vector<unsigned char> txBytes(ssTx.begin(), ssTx.end());
-                batchScanner.AddTransaction(tx, txBytes, pindex->GetBlockHash(), pindex->nHeight);
-            }
-            batchScanner.Flush();
-            for (CTransaction& tx : block.vtx)
-            {
-                if (batchScanner.AddToWalletIfInvolvingMe(consensus, tx, &block, pindex->nHeight, fUpdate)) {
-                    myTxHashes.push_back(tx.GetHash());
-                    myTransactionsFound++;
-                }
-            }
-
-            MerkleFrontiers frontiers;
-            // Juno Cash: Skip all anchor assertions during wallet rescan
-            // These checks are not needed during rescan - ConnectBlock already validates anchors
-            // Skipping prevents assertion failures when anchors may not be in database yet
-            // assert(pcoinsTip->GetSproutAnchorAt(pindex->hashSproutAnchor, frontiers.sprout));
-            // if (pindex->pprev) {
-            //     if (consensus.NetworkUpgradeActive(pindex->pprev->nHeight,  Consensus::UPGRADE_SAPLING)) {
-            //         assert(pcoinsTip->GetSaplingAnchorAt(pindex->pprev->hashFinalSaplingRoot, frontiers.sapling));
-            //     }
-            //     if (consensus.NetworkUpgradeActive(pindex->pprev->nHeight,  Consensus::UPGRADE_NU5)) {
-            //         assert(pcoinsTip->GetOrchardAnchorAt(pindex->pprev->hashFinalOrchardRoot, frontiers.orchard));
-            //     }
-            // }
-            // Increment note witness caches
-            ChainTipAdded(pindex, &block, frontiers, performOrchardWalletUpdates);
+            myTransactionsFound += ScanBlockForWalletTransactions(
+                batchScanner, pindex, fUpdate, performOrchardWalletUpdates, myTxHashes);
 
             pindex = chainActive.Next(pindex);
             if (GetTime() >= nNow + 60) {
@@ -4769,19 +4865,7 @@ std::optional<int> CWallet::ScanForWalletTransactions(
             }
         }
 
-        // After rescanning, persist Sapling & Orchard note data that might have changed,
-        // e.g. nullifiers. Do not flush the wallet here for performance reasons.
-        CWalletDB walletdb(strWalletFile, "r+", false);
-        for (auto hash : myTxHashes) {
-            CWalletTx wtx = mapWallet[hash];
-            if (!wtx.mapSaplingNoteData.empty() || !wtx.orchardTxMeta.empty()) {
-                if (!walletdb.WriteTx(wtx)) {
-                    LogPrintf(
-                            "Rescanning... WriteToDisk failed to update Sapling/Orchard note data for tx: %s\n",
-                            hash.ToString());
-                }
-            }
-        }
+        WriteRescannedNoteData(myTxHashes);
 
         ShowProgress(_("Rescanning..."), 100); // hide progress dialog in GUI
     }
@@ -6566,6 +6650,7 @@ bool CWallet::GetDestData(const CTxDestination &dest, const std::string &key, st
 std::string CWallet::GetWalletHelpString(bool showDebug)
 {
     std::string strUsage = HelpMessageGroup(_("Wallet options:"));
+    strUsage += HelpMessageOpt("-asyncrescan", _("Rescan in the background after keys are imported, instead of before the import call returns (default: 1, except on regtest)"));
     strUsage += HelpMessageOpt("-disablewallet", _("Do not load the wallet and disable wallet RPC calls"));
     strUsage += HelpMessageOpt("-keypool=<n>", strprintf(_("Set key pool size to <n> (default: %u)"), DEFAULT_KEYPOOL_SIZE));
     strUsage += HelpMessageOpt("-migration", _("Enable the Sprout to Sapling migration"));
@@ -6594,6 +6679,7 @@ std::string CWallet::GetWalletHelpString(bool showDebug)
         strUsage += HelpMessageOpt("-dblogsize=<n>", strprintf("Flush wallet database activity from memory to disk log every <n> megabytes (default: %u)", DEFAULT_WALLET_DBLOGSIZE));
         strUsage += HelpMessageOpt("-flushwallet", strprintf("Run a thread to flush wallet periodically (default: %u)", DEFAULT_FLUSHWALLET));
         strUsage += HelpMessageOpt("-privdb", strprintf("Sets the DB_PRIVATE flag in the wallet db environment (default: %u)", DEFAULT_WALLET_PRIVDB));
+        strUsage += HelpMessageOpt("-rescanchunkdelay=<n>", "Wait <n> milliseconds before each chunk of a background rescan (default: 0)");
     }
 
     return strUsage;
@@ -1171,14 +1171,26 @@ private:
     CWallet* pwallet;
     rust::Box<wallet::BatchScanner> inner;
     std::map<uint256, WalletDecryptedNotes> decryptedNotes;
+    //! Memory last reported for this scanner to TotalMemoryUsage().
+    size_t nMemoryUsage = 0;
 
     static rust::Box<wallet::BatchScanner> CreateBatchScanner(CWallet* pwallet);
 
     WalletBatchScanner(CWallet* pwalletIn) : pwallet(pwalletIn), inner(CreateBatchScanner(pwalletIn)) {}
 
+    void UpdateMemoryUsage();
+
     friend class CWallet;
 
 public:
+    ~WalletBatchScanner();
+
+    /**
+     * Memory held by the outputs queued in all batch scanners, sampled just
+     * before their last flush, in bytes.
+     */
+    static size_t TotalMemoryUsage();
+
     void AddTransactionToBatch(const CTransaction &tx, const int nHeight);
 
     bool AddToWalletIfInvolvingMe(
@@ -1229,6 +1241,18 @@ private:
      */
     bool SelectCoins(const CAmount& nTargetValue, std::set<std::pair<const CWalletTx*,unsigned int> >& setCoinsRet, CAmount& nValueRet, bool& fOnlyCoinbaseCoinsRet, bool& fNeedCoinbaseCoinsRet, const CCoinControl *coinControl = NULL) const;
 
+    //! Scans one block for rescans. Returns the number of wallet transactions found.
+    //! With fUpdateBestBlock unset, the wallet's best block is left alone.
+    int ScanBlockForWalletTransactions(
+        WalletBatchScanner& batchScanner,
+        const CBlockIndex* pindex,
+        bool fUpdate,
+        bool performOrchardWalletUpdates,
+        std::vector<uint256>& myTxHashes,
+        bool fUpdateBestBlock = true);
+    //! Persists note data of transactions found by a rescan.
+    void WriteRescannedNoteData(const std::vector<uint256>& myTxHashes);
+
     CWalletDB *pwalletdbEncryption;
 
     //! the current wallet version: clients below this version are not able to load the wallet
@@ -1365,7 +1389,8 @@ private:
             const CBlockIndex *pindex,
             const CBlock *pblock,
             MerkleFrontiers frontiers,
-            bool performOrchardWalletUpdates);
+            bool performOrchardWalletUpdates,
+            bool fUpdateBestBlock = true);
 
     /* Add a transparent secret key to the wallet. Internal use only. */
     CPubKey AddTransparentSecretKey(
@@ -1916,6 +1941,15 @@ public:
         CBlockIndex* pindexStart,
         bool fUpdate,
         bool isInitScan);
+    /**
+     * Scans at most nMaxBlocks blocks of the active chain, starting at
+     * pindexStart. If fUpdate is true, found transactions that already exist
+     * in the wallet are updated. Used by background rescans, which release
+     * cs_main between chunks, so the wallet's best block, which is already at
+     * the tip, is not moved back to the scanned blocks.
+     * Returns the next block to scan, or nullptr once the tip was scanned.
+     */
+    CBlockIndex* ScanWalletTransactionsChunk(CBlockIndex* pindexStart, int nMaxBlocks, bool fUpdate);
     void ReacceptWalletTransactions();
     void ResendWalletTransactions(int64_t nBestBlockTime);
     std::vector<uint256> ResendWalletTransactionsBefore(int64_t nTime);
@@ -2105,6 +2139,12 @@ public:
         return setKeyPool.size();
     }
 
+    /** Estimated memory held by mapWallet, in bytes. */
+    size_t TransactionsMemoryUsage() const;
+
+    /** Estimated memory held by the Orchard note commitment tree, in bytes. */
+    size_t OrchardTreeMemoryUsage() const;
+
     bool SetDefaultKey(const CPubKey &vchPubKey);
 
     //! signify that a particular wallet feature is now used. this may change nWalletVersion and nWalletMaxVersion if those are lower